@@ -0,0 +1,501 @@
+#include "aio.h"
+#include "log.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+// For stat
+std::atomic<int64_t> stat_aio_read_page;
+std::atomic<int64_t> stat_aio_write_page;
+
+// 같은 table의 연속된 page들을 한 번의 preadv/pwritev로 처리하는 단위
+typedef struct aio_run_t {
+    int fd;
+    bool is_write;
+    off_t offset;
+    // table의 page 크기, run의 page는 모두 이 크기
+    uint32_t page_size;
+    uint32_t num_pages;
+    struct iovec iov[AIO_MAX_RUN_PAGES];
+    aio_request_t *requests[AIO_MAX_RUN_PAGES];
+} aio_run_t;
+
+static bool aio_initialized;
+static bool use_io_uring;
+// aio_set_enabled()로 끄면 aio_submit()이 실패해 호출자가 동기 경로를 씀
+static std::atomic<bool> aio_enabled{true};
+
+// table_id를 index로 하는 file descriptor, 열지 않은 table은 -1
+static std::mutex fd_latch;
+static std::vector<int> table_fds;
+// table_id를 index로 하는 page 크기
+static std::vector<uint32_t> table_page_sizes;
+
+#ifdef HAVE_LIBURING
+static struct io_uring ring;
+// submission queue를 보호
+static std::mutex ring_latch;
+static std::thread reaper;
+#endif
+
+// io_uring을 쓸 수 없을 때 run을 처리하는 worker thread들
+static std::mutex worker_latch;
+static std::condition_variable worker_cond;
+static std::deque<aio_run_t *> run_queue;
+static std::vector<std::thread> workers;
+static bool workers_running;
+
+static int get_table_fd(int64_t table_id, uint32_t *page_size = nullptr) {
+    std::lock_guard<std::mutex> guard(fd_latch);
+    if (table_id < 0 || (uint64_t)table_id >= table_fds.size())
+        return -1;
+    if (page_size)
+        *page_size = table_page_sizes[table_id];
+    return table_fds[table_id];
+}
+
+/**
+ * @brief Run the callback of a finished request and count it in its batch.
+ *
+ * @details The request is not touched after its callback, so the callback may
+ * free it.
+ */
+static void complete_request(aio_request_t *request, int result) {
+    aio_batch_t *batch = request->batch;
+    if (request->callback)
+        request->callback(request, result);
+
+    if (batch == nullptr)
+        return;
+    std::lock_guard<std::mutex> guard(batch->latch);
+    if (result < 0)
+        batch->num_failed++;
+    // 마지막 request가 끝나면 기다리던 thread가 batch를 해제할 수 있으므로 이후 접근 금지
+    if (--batch->num_pending == 0)
+        batch->cond.notify_all();
+}
+
+static void complete_run(aio_run_t *run, int result) {
+    if (result == 0)
+        (run->is_write ? stat_aio_write_page : stat_aio_read_page) += run->num_pages;
+    for (uint32_t i = 0; i < run->num_pages; i++)
+        complete_request(run->requests[i], result);
+    delete run;
+}
+
+/**
+ * @brief Do the I/O of a run synchronously, starting from byte done.
+ *
+ * @return 0 on success, -errno on failure.
+ *
+ * @details Partial transfers are retried. Reading past the end of the file
+ * fills the rest of the pages with zero.
+ */
+static int do_run(aio_run_t *run, size_t done) {
+    size_t total = (size_t)run->num_pages * run->page_size;
+    struct iovec *iov = run->iov;
+    int iovcnt = run->num_pages;
+    size_t skip = done;
+
+    while (done < total) {
+        // 이미 처리한 만큼 iovec을 앞으로 당김
+        while (skip >= iov->iov_len) {
+            skip -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        iov->iov_base = (char *)iov->iov_base + skip;
+        iov->iov_len -= skip;
+
+        ssize_t n = run->is_write ? pwritev(run->fd, iov, iovcnt, run->offset + done)
+                                  : preadv(run->fd, iov, iovcnt, run->offset + done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                skip = 0;
+                continue;
+            }
+            return -errno;
+        }
+        if (n == 0) {
+            if (run->is_write)
+                return -EIO;
+            // file 끝을 넘은 page는 0으로 채움
+            for (int i = 0; i < iovcnt; i++)
+                memset(iov[i].iov_base, 0, iov[i].iov_len);
+            return 0;
+        }
+        done += n;
+        skip = n;
+    }
+    return 0;
+}
+
+static void worker_main() {
+    std::unique_lock<std::mutex> lock(worker_latch);
+    while (true) {
+        worker_cond.wait(lock, [] { return !run_queue.empty() || !workers_running; });
+        // 종료 요청을 받아도 남은 run은 모두 처리한 뒤 끝냄
+        if (run_queue.empty())
+            return;
+        aio_run_t *run = run_queue.front();
+        run_queue.pop_front();
+        lock.unlock();
+        complete_run(run, do_run(run, 0));
+        lock.lock();
+    }
+}
+
+#ifdef HAVE_LIBURING
+static void reaper_main() {
+    while (true) {
+        struct io_uring_cqe *cqe;
+        int ret = io_uring_wait_cqe(&ring, &cqe);
+        if (ret == -EINTR)
+            continue;
+        if (ret < 0) {
+            buf_log_error("Error: io_uring_wait_cqe failed: " << strerror(-ret));
+            return;
+        }
+        aio_run_t *run = (aio_run_t *)io_uring_cqe_get_data(cqe);
+        int res = cqe->res;
+        io_uring_cqe_seen(&ring, cqe);
+
+        // aio_shutdown()이 보낸 종료 신호
+        if (run == nullptr)
+            return;
+        // 일부만 처리된 경우 나머지는 동기로 마저 처리
+        complete_run(run, res < 0 ? res : do_run(run, res));
+    }
+}
+#endif
+
+static void submit_run(aio_run_t *run) {
+#ifdef HAVE_LIBURING
+    if (use_io_uring) {
+        std::lock_guard<std::mutex> guard(ring_latch);
+        struct io_uring_sqe *sqe;
+        while ((sqe = io_uring_get_sqe(&ring)) == nullptr)
+            io_uring_submit(&ring);
+        if (run->is_write)
+            io_uring_prep_writev(sqe, run->fd, run->iov, run->num_pages, run->offset);
+        else
+            io_uring_prep_readv(sqe, run->fd, run->iov, run->num_pages, run->offset);
+        io_uring_sqe_set_data(sqe, run);
+        return;
+    }
+#endif
+    {
+        std::lock_guard<std::mutex> guard(worker_latch);
+        run_queue.push_back(run);
+    }
+    worker_cond.notify_one();
+}
+
+/**
+ * @brief Start the asynchronous I/O layer.
+ *
+ * @retval 0: successful
+ * @retval others: failed
+ *
+ * @details io_uring is used if the tree is built with HAVE_LIBURING and the
+ * kernel supports it. Otherwise AIO_NUM_WORKERS threads do the I/O with
+ * preadv()/pwritev(). The io_uring backend is experimental: it is only built
+ * with the BUF_IO_URING CMake option and has not been run against liburing.
+ */
+int aio_init() {
+    if (aio_initialized)
+        return 0;
+
+#ifdef HAVE_LIBURING
+    if (io_uring_queue_init(AIO_QUEUE_DEPTH, &ring, 0) == 0) {
+        use_io_uring = true;
+        reaper = std::thread(reaper_main);
+        aio_initialized = true;
+        return 0;
+    }
+    buf_log_info("io_uring is not available, falling back to I/O worker threads.");
+#endif
+
+    use_io_uring = false;
+    workers_running = true;
+    for (int i = 0; i < AIO_NUM_WORKERS; i++)
+        workers.emplace_back(worker_main);
+    aio_initialized = true;
+    return 0;
+}
+
+/**
+ * @brief Stop the asynchronous I/O layer after finishing all submitted I/O.
+ *
+ * @details The files opened by aio_open_table() are synced and closed. Every
+ * request submitted before, including fire-and-forget prefetches, has
+ * completed and run its callback when this returns.
+ */
+void aio_shutdown() {
+    if (!aio_initialized)
+        return;
+
+#ifdef HAVE_LIBURING
+    if (use_io_uring) {
+        {
+            std::lock_guard<std::mutex> guard(ring_latch);
+            struct io_uring_sqe *sqe;
+            while ((sqe = io_uring_get_sqe(&ring)) == nullptr)
+                io_uring_submit(&ring);
+            // io_uring은 순서 없이 끝나므로, 앞서 낸 요청이 모두 끝난 뒤에 NOP이 끝나게 함
+            // 그래야 fire-and-forget 읽기의 callback이 frame을 해제하기 전에 모두 불림
+            io_uring_prep_nop(sqe);
+            io_uring_sqe_set_flags(sqe, IOSQE_IO_DRAIN);
+            io_uring_sqe_set_data(sqe, nullptr);
+            io_uring_submit(&ring);
+        }
+        reaper.join();
+        io_uring_queue_exit(&ring);
+    }
+#endif
+
+    {
+        std::lock_guard<std::mutex> guard(worker_latch);
+        workers_running = false;
+    }
+    worker_cond.notify_all();
+    for (std::thread &worker : workers)
+        worker.join();
+    workers.clear();
+
+    std::lock_guard<std::mutex> guard(fd_latch);
+    for (int fd : table_fds) {
+        if (fd >= 0) {
+            fsync(fd);
+            close(fd);
+        }
+    }
+    table_fds.clear();
+    table_page_sizes.clear();
+    aio_initialized = false;
+}
+
+/**
+ * @brief Flush the files opened by aio_open_table() to stable storage.
+ *
+ * @retval 0: successful
+ * @retval others: fsync() failed for some table
+ *
+ * @details fsync() flushes the whole file, so this also covers pages the
+ * file layer wrote through its own descriptor.
+ */
+int aio_sync() {
+    std::vector<int> fds;
+    {
+        std::lock_guard<std::mutex> guard(fd_latch);
+        fds = table_fds;
+    }
+    int ret = 0;
+    for (int fd : fds) {
+        if (fd >= 0 && fsync(fd) != 0) {
+            buf_log_error("Error: fsync failed: " << strerror(errno));
+            ret = 1;
+        }
+    }
+    return ret;
+}
+
+/**
+ * @brief Open the file of a table for asynchronous I/O.
+ *
+ * @retval 0: successful
+ * @retval others: failed
+ *
+ * @details The file layer keeps pages at page_num * PAGE_SIZE, so the same
+ * file is opened again here and accessed at the same offsets. A table with
+ * larger pages keeps page page_num at page_num * page_size, which is where
+ * the buffer pool puts it through the file layer too.
+ */
+int aio_open_table(int64_t table_id, const char *pathname, uint32_t page_size) {
+    if (table_id < 0)
+        return 1;
+
+    int fd = open(pathname, O_RDWR);
+    if (fd < 0) {
+        buf_log_error("Error: Failed to open " << pathname << " for async I/O: " << strerror(errno));
+        return 1;
+    }
+
+    std::lock_guard<std::mutex> guard(fd_latch);
+    if ((uint64_t)table_id >= table_fds.size()) {
+        table_fds.resize(table_id + 1, -1);
+        table_page_sizes.resize(table_id + 1, PAGE_SIZE);
+    }
+    if (table_fds[table_id] >= 0)
+        close(table_fds[table_id]);
+    table_fds[table_id] = fd;
+    table_page_sizes[table_id] = page_size;
+    return 0;
+}
+
+/**
+ * @brief Get the size of a table's file in pages of the table's page size.
+ *
+ * @return The number of pages, or -1 if the table is not open for async I/O.
+ */
+int64_t aio_get_num_pages(int64_t table_id) {
+    uint32_t page_size;
+    int fd = get_table_fd(table_id, &page_size);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0)
+        return -1;
+    return st.st_size / page_size;
+}
+
+/**
+ * @brief Extend the file of a table to num_pages pages without writing them.
+ *
+ * @retval 0: successful
+ * @retval others: failed, or the table is not open for async I/O
+ *
+ * @details fallocate() reserves the disk blocks, so a full disk shows up here
+ * instead of at a later write of the pages. On file systems without
+ * fallocate() the file is extended sparsely with ftruncate(). The new pages
+ * read as zero, and the file is never shrunk.
+ */
+int aio_extend_table(int64_t table_id, uint64_t num_pages) {
+    uint32_t page_size;
+    int fd = get_table_fd(table_id, &page_size);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0)
+        return 1;
+    off_t size = (off_t)num_pages * page_size;
+    if (st.st_size >= size)
+        return 0;
+    if (fallocate(fd, 0, st.st_size, size - st.st_size) == 0)
+        return 0;
+    if (errno != EOPNOTSUPP) {
+        buf_log_error("Error: cannot extend table " << table_id << ": " << strerror(errno));
+        return 1;
+    }
+    if (ftruncate(fd, size) != 0) {
+        buf_log_error("Error: cannot extend table " << table_id << ": " << strerror(errno));
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Turn asynchronous page I/O on or off.
+ *
+ * @details While it is off, aio_submit() fails, so every caller takes its
+ * synchronous path: checkpoints write page by page through the file layer,
+ * and prefetches and read-ahead fail, so get_buffer() reads each page
+ * itself. This compares the two paths on the same pool. File growth with
+ * aio_extend_table() is not affected.
+ */
+void aio_set_enabled(bool enabled) {
+    aio_enabled = enabled;
+}
+
+void aio_init_batch(aio_batch_t *batch) {
+    batch->num_pending = 0;
+    batch->num_failed = 0;
+}
+
+/**
+ * @brief Submit page reads and writes as one batch.
+ *
+ * @retval 0: successful
+ * @retval others: failed
+ *
+ * @details The requests are sorted by (table_id, page_num), and runs of
+ * adjacent pages in the same direction are coalesced into one vectored I/O of
+ * up to AIO_MAX_RUN_PAGES pages. Each request's callback is called from an
+ * I/O thread when it completes.
+ *
+ * The requests and their pages must stay valid until aio_wait() returns for
+ * the batch. With a nullptr batch, nobody waits for the requests, and each
+ * must stay valid until its callback is called.
+ */
+int aio_submit(aio_request_t *requests, uint32_t num_requests, aio_batch_t *batch) {
+    if (!aio_initialized || !aio_enabled.load(std::memory_order_relaxed))
+        return 1;
+    if (num_requests == 0)
+        return 0;
+
+    std::vector<aio_request_t *> sorted(num_requests);
+    for (uint32_t i = 0; i < num_requests; i++) {
+        requests[i].batch = batch;
+        sorted[i] = &requests[i];
+    }
+    std::sort(sorted.begin(), sorted.end(), [](aio_request_t *a, aio_request_t *b) {
+        if (a->table_id != b->table_id)
+            return a->table_id < b->table_id;
+        if (a->is_write != b->is_write)
+            return a->is_write < b->is_write;
+        return a->page_num < b->page_num;
+    });
+
+    if (batch) {
+        std::lock_guard<std::mutex> guard(batch->latch);
+        batch->num_pending += num_requests;
+    }
+
+    aio_run_t *run = nullptr;
+    pagenum_t last_page_num = -1;
+    for (aio_request_t *request : sorted) {
+        uint32_t page_size;
+        int fd = get_table_fd(request->table_id, &page_size);
+        if (fd < 0) {
+            complete_request(request, -EBADF);
+            continue;
+        }
+
+        // 이어지지 않는 page를 만나면 지금까지 묶은 run을 제출
+        if (run == nullptr || run->fd != fd || run->is_write != request->is_write ||
+            run->num_pages == AIO_MAX_RUN_PAGES || request->page_num != last_page_num + 1) {
+            if (run)
+                submit_run(run);
+            run = new aio_run_t;
+            run->fd = fd;
+            run->is_write = request->is_write;
+            run->offset = (off_t)request->page_num * page_size;
+            run->page_size = page_size;
+            run->num_pages = 0;
+        }
+        run->iov[run->num_pages].iov_base = request->page;
+        run->iov[run->num_pages].iov_len = page_size;
+        run->requests[run->num_pages++] = request;
+        last_page_num = request->page_num;
+    }
+    if (run)
+        submit_run(run);
+
+#ifdef HAVE_LIBURING
+    if (use_io_uring) {
+        std::lock_guard<std::mutex> guard(ring_latch);
+        io_uring_submit(&ring);
+    }
+#endif
+    return 0;
+}
+
+/**
+ * @brief Wait until every request of the batch has completed.
+ *
+ * @return The number of failed requests.
+ */
+uint32_t aio_wait(aio_batch_t *batch) {
+    std::unique_lock<std::mutex> lock(batch->latch);
+    batch->cond.wait(lock, [batch] { return batch->num_pending == 0; });
+    return batch->num_failed;
+}
@@ -0,0 +1,54 @@
+#ifndef DB_AIO_H_
+#define DB_AIO_H_
+
+#include "page.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+// 한 번의 vectored I/O로 묶는 연속 page 수의 상한 (IOV_MAX보다 작아야 함)
+#define AIO_MAX_RUN_PAGES (64)
+// io_uring을 쓸 수 없을 때 I/O를 처리하는 worker thread 수
+#define AIO_NUM_WORKERS (4)
+// io_uring submission queue 크기
+#define AIO_QUEUE_DEPTH (256)
+
+// 함께 제출한 request들의 완료를 기다리기 위한 묶음
+typedef struct aio_batch_t {
+    std::mutex latch;
+    std::condition_variable cond;
+    uint32_t num_pending;
+    uint32_t num_failed;
+} aio_batch_t;
+
+typedef struct aio_request_t {
+    int64_t table_id;
+    pagenum_t page_num;
+    page_t *page;
+    bool is_write;
+    // 완료 시 I/O thread에서 호출됨, result는 0(성공) 또는 -errno
+    void (*callback)(struct aio_request_t *request, int result);
+    void *arg;
+    // aio_submit()이 채움
+    aio_batch_t *batch;
+} aio_request_t;
+
+// For stat
+extern std::atomic<int64_t> stat_aio_read_page;
+extern std::atomic<int64_t> stat_aio_write_page;
+
+int aio_init();
+void aio_shutdown();
+int aio_open_table(int64_t table_id, const char *pathname, uint32_t page_size = PAGE_SIZE);
+int64_t aio_get_num_pages(int64_t table_id);
+int aio_extend_table(int64_t table_id, uint64_t num_pages);
+int aio_sync();
+void aio_set_enabled(bool enabled);
+
+void aio_init_batch(aio_batch_t *batch);
+int aio_submit(aio_request_t *requests, uint32_t num_requests, aio_batch_t *batch);
+uint32_t aio_wait(aio_batch_t *batch);
+
+#endif // DB_AIO_H_
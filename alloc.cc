@@ -0,0 +1,519 @@
+#include "alloc.h"
+#include "aio.h"
+#include "buffer.h"
+#include "log.h"
+#include "metrics.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// space map page 하나가 담당하는 page 수
+#define map_bits(page_size) ((uint64_t)((page_size) - sizeof(alloc_map_header_t)) * 8)
+
+// table 하나의 space map 상태, 처음 할당하거나 해제할 때 읽어 옴
+typedef struct alloc_table_t {
+    // 아래 항목들과 table의 space map page, file 늘리기를 보호
+    std::mutex latch;
+    bool is_loaded;
+    uint32_t page_size;
+    // header page의 num_of_pages
+    uint64_t num_pages;
+    // space map에서 비어 있는 page 수, thread cache에 있는 page는 사용 중으로 셈
+    uint64_t num_free;
+    // i번째 space map page의 page 번호
+    std::vector<pagenum_t> map_pages;
+    // 다음에 빈 page를 찾기 시작할 page
+    uint64_t hint;
+    // 끝난 thread의 cache에 남아 있던 page, 다음 할당에 먼저 씀
+    std::vector<pagenum_t> orphans;
+} alloc_table_t;
+
+static std::mutex tables_latch;
+// table_id를 index로 하는 space map 상태, 아직 쓰지 않은 table은 nullptr
+static std::vector<alloc_table_t *> tables;
+
+/*
+ * Free pages a thread took from the space maps, by table. Allocating and
+ * freeing pages only touches this cache, and the space map is latched once
+ * per ALLOC_CACHE_PAGES pages. The pages stay marked used in the space map
+ * while they are cached, so a crash leaks the cached pages of each thread
+ * instead of handing a page out twice.
+ */
+typedef struct alloc_cache_t {
+    std::unordered_map<int64_t, std::vector<pagenum_t>> pages;
+    alloc_cache_t();
+    ~alloc_cache_t();
+} alloc_cache_t;
+
+static std::mutex caches_latch;
+// alloc_close()가 모든 thread의 cache를 비울 수 있도록 등록해 둠
+static std::vector<alloc_cache_t *> caches;
+static thread_local alloc_cache_t local_cache;
+
+static alloc_table_t *find_table(int64_t table_id) {
+    std::lock_guard<std::mutex> guard(tables_latch);
+    return table_id >= 0 && (uint64_t)table_id < tables.size() ? tables[table_id] : nullptr;
+}
+
+static alloc_table_t *get_alloc_table(int64_t table_id) {
+    std::lock_guard<std::mutex> guard(tables_latch);
+    if ((uint64_t)table_id >= tables.size())
+        tables.resize(table_id + 1, nullptr);
+    if (tables[table_id] == nullptr)
+        tables[table_id] = new alloc_table_t();
+    return tables[table_id];
+}
+
+alloc_cache_t::alloc_cache_t() {
+    std::lock_guard<std::mutex> guard(caches_latch);
+    caches.push_back(this);
+}
+
+// 끝나는 thread의 page는 buffer pool을 쓰지 않고 table의 orphans로 넘김
+alloc_cache_t::~alloc_cache_t() {
+    std::lock_guard<std::mutex> guard(caches_latch);
+    caches.erase(std::find(caches.begin(), caches.end(), this));
+    for (auto &entry : pages) {
+        alloc_table_t *table = find_table(entry.first);
+        if (table == nullptr || entry.second.empty())
+            continue;
+        std::lock_guard<std::mutex> table_guard(table->latch);
+        table->orphans.insert(table->orphans.end(), entry.second.begin(), entry.second.end());
+    }
+}
+
+static inline alloc_map_header_t *get_map_header(buf_descriptor_t *map_buf) {
+    return (alloc_map_header_t *)map_buf->buf_page;
+}
+
+static inline uint64_t *get_map_words(buf_descriptor_t *map_buf) {
+    return (uint64_t *)((char *)map_buf->buf_page + sizeof(alloc_map_header_t));
+}
+
+// bitmap의 [first_word, last_word) 구간을 log에 남기고 dirty로 표시
+static inline void log_map_words(buf_descriptor_t *map_buf, uint64_t first_word, uint64_t last_word) {
+    log_buffer_update(map_buf, sizeof(alloc_map_header_t) + first_word * sizeof(uint64_t),
+                      (last_word - first_word) * sizeof(uint64_t));
+}
+
+// 앞의 num_bits개 bit 중 1인 bit 수
+static uint64_t count_used(const uint64_t *words, uint64_t num_bits) {
+    uint64_t num_used = 0;
+    for (uint64_t w = 0; w < num_bits / 64; w++)
+        num_used += __builtin_popcountll(words[w]);
+    if (num_bits % 64 != 0)
+        num_used += __builtin_popcountll(words[num_bits / 64] & ((1ULL << (num_bits % 64)) - 1));
+    return num_used;
+}
+
+/**
+ * @brief Write a new space map page.
+ *
+ * @param num_used The pages below this number are marked used
+ *
+ * @details The whole page is logged, since its old content is garbage.
+ */
+static int init_map_page(alloc_table_t *table, int64_t table_id, pagenum_t page_num,
+                         uint64_t group, uint64_t num_used, pagenum_t next_map_page) {
+    buf_descriptor_t *map_buf = get_buffer(table_id, page_num, BUF_LATCH_EXCLUSIVE);
+    if (map_buf == nullptr)
+        return 1;
+    uint64_t bits = map_bits(table->page_size);
+    memset(map_buf->buf_page, 0, table->page_size);
+    get_map_header(map_buf)->next_map_page = next_map_page;
+    get_map_header(map_buf)->magic = ALLOC_MAGIC;
+    uint64_t *words = get_map_words(map_buf);
+    for (uint64_t bit = 0; group * bits + bit < num_used && bit < bits; bit++)
+        words[bit / 64] |= 1ULL << (bit % 64);
+    log_buffer_update(map_buf, 0, table->page_size);
+    release_buffer(map_buf, BUF_LATCH_EXCLUSIVE);
+    return 0;
+}
+
+/**
+ * @brief Mark pages used or free in the space map.
+ *
+ * @param page_nums The pages, sorted
+ *
+ * @details Each space map page is latched once for all its pages, and only
+ * the changed range of its bitmap is logged. A page already in the requested
+ * state is reported and skipped.
+ */
+static void update_map(alloc_table_t *table, int64_t table_id,
+                       const std::vector<pagenum_t> &page_nums, bool used) {
+    uint64_t bits = map_bits(table->page_size);
+    size_t i = 0;
+    while (i < page_nums.size()) {
+        uint64_t group = page_nums[i] / bits;
+        if (page_nums[i] <= 0 || group >= table->map_pages.size()) {
+            buf_log_error("Error: page " << page_nums[i] << " is not in table " << table_id);
+            i++;
+            continue;
+        }
+        buf_descriptor_t *map_buf = get_buffer(table_id, table->map_pages[group], BUF_LATCH_EXCLUSIVE);
+        if (map_buf == nullptr)
+            return;
+        uint64_t *words = get_map_words(map_buf);
+        uint64_t first_word = UINT64_MAX, last_word = 0;
+        for (; i < page_nums.size() && page_nums[i] / bits == group; i++) {
+            uint64_t bit = page_nums[i] % bits;
+            uint64_t mask = 1ULL << (bit % 64);
+            if (((words[bit / 64] & mask) != 0) == used) {
+                buf_log_error("Error: page " << page_nums[i] << " of table " << table_id
+                              << (used ? " is already used" : " is already free"));
+                continue;
+            }
+            words[bit / 64] ^= mask;
+            table->num_free += used ? -1 : 1;
+            first_word = std::min(first_word, bit / 64);
+            last_word = std::max(last_word, bit / 64);
+        }
+        if (first_word <= last_word)
+            log_map_words(map_buf, first_word, last_word + 1);
+        release_buffer(map_buf, BUF_LATCH_EXCLUSIVE);
+    }
+}
+
+/**
+ * @brief Replace the header free list of a table with space map pages.
+ *
+ * @details Tables written before the space map keep their free pages in a
+ * list through the header page. The pages of the list are collected once,
+ * space map pages covering the whole file are appended to it, and the
+ * header's free_page_num points at the first of them.
+ */
+static int convert_table(alloc_table_t *table, int64_t table_id, buf_descriptor_t *header_buf) {
+    page_t *header_page = header_buf->buf_page;
+    uint64_t num_pages = header_page->num_of_pages;
+    uint64_t bits = map_bits(table->page_size);
+
+    std::vector<pagenum_t> free_pages;
+    for (pagenum_t page_num = header_page->free_page_num; page_num != -1; ) {
+        if (page_num <= 0 || (uint64_t)page_num >= num_pages || free_pages.size() >= num_pages) {
+            buf_log_error("Error: broken free page list in table " << table_id);
+            return 1;
+        }
+        free_pages.push_back(page_num);
+        buf_descriptor_t *buf_desc = get_buffer(table_id, page_num, BUF_LATCH_SHARED);
+        if (buf_desc == nullptr)
+            return 1;
+        page_num = buf_desc->buf_page->next_free_page_num;
+        release_buffer(buf_desc, BUF_LATCH_SHARED);
+    }
+
+    // space map page들은 file 끝에 이어 붙이며, 자신도 담당 범위에 들어감
+    uint64_t num_maps = 1;
+    while (num_maps * bits < num_pages + num_maps)
+        num_maps++;
+    uint64_t new_num_pages = num_pages + num_maps;
+    if (aio_extend_table(table_id, new_num_pages) != 0)
+        return 1;
+    for (uint64_t i = 0; i < num_maps; i++) {
+        pagenum_t next_map_page = i + 1 < num_maps ? num_pages + i + 1 : -1;
+        if (init_map_page(table, table_id, num_pages + i, i, new_num_pages, next_map_page) != 0)
+            return 1;
+        table->map_pages.push_back(num_pages + i);
+    }
+    table->num_pages = new_num_pages;
+    table->num_free = 0;
+    std::sort(free_pages.begin(), free_pages.end());
+    update_map(table, table_id, free_pages, false);
+
+    // free page list 대신 첫 space map page를 가리킴
+    header_page->free_page_num = num_pages;
+    header_page->num_of_pages = new_num_pages;
+    log_buffer_update(header_buf, 0, sizeof(pagenum_t) + sizeof(uint64_t));
+    return 0;
+}
+
+// header의 free_page_num이 space map page를 가리키는지 확인
+static bool has_space_map(int64_t table_id, buf_descriptor_t *header_buf) {
+    pagenum_t page_num = header_buf->buf_page->free_page_num;
+    if (page_num <= 0 || (uint64_t)page_num >= header_buf->buf_page->num_of_pages)
+        return false;
+    buf_descriptor_t *map_buf = get_buffer(table_id, page_num, BUF_LATCH_SHARED);
+    if (map_buf == nullptr)
+        return false;
+    bool is_map = get_map_header(map_buf)->magic == ALLOC_MAGIC;
+    release_buffer(map_buf, BUF_LATCH_SHARED);
+    return is_map;
+}
+
+// table->latch를 잡고 호출, header와 space map page들을 읽어 상태를 채움
+static int load_table(alloc_table_t *table, int64_t table_id) {
+    buf_descriptor_t *header_buf = get_buffer(table_id, 0, BUF_LATCH_EXCLUSIVE);
+    if (header_buf == nullptr)
+        return 1;
+    table->page_size = buf_page_size(header_buf);
+    table->map_pages.clear();
+    table->num_free = 0;
+
+    int ret = 0;
+    if (!has_space_map(table_id, header_buf)) {
+        ret = convert_table(table, table_id, header_buf);
+    } else {
+        uint64_t bits = map_bits(table->page_size);
+        table->num_pages = header_buf->buf_page->num_of_pages;
+        uint64_t num_groups = (table->num_pages + bits - 1) / bits;
+        pagenum_t page_num = header_buf->buf_page->free_page_num;
+        while (page_num != -1 && table->map_pages.size() < num_groups) {
+            buf_descriptor_t *map_buf = get_buffer(table_id, page_num, BUF_LATCH_SHARED);
+            if (map_buf == nullptr) {
+                ret = 1;
+                break;
+            }
+            if (get_map_header(map_buf)->magic != ALLOC_MAGIC) {
+                release_buffer(map_buf, BUF_LATCH_SHARED);
+                buf_log_error("Error: page " << page_num << " of table " << table_id
+                              << " is not a space map page");
+                ret = 1;
+                break;
+            }
+            uint64_t first = table->map_pages.size() * bits;
+            uint64_t num_bits = std::min(bits, table->num_pages - first);
+            table->num_free += num_bits - count_used(get_map_words(map_buf), num_bits);
+            table->map_pages.push_back(page_num);
+            page_num = get_map_header(map_buf)->next_map_page;
+            release_buffer(map_buf, BUF_LATCH_SHARED);
+        }
+        if (ret == 0 && table->map_pages.size() < num_groups) {
+            buf_log_error("Error: space map of table " << table_id << " is too short");
+            ret = 1;
+        }
+    }
+    release_buffer(header_buf, BUF_LATCH_EXCLUSIVE);
+    table->is_loaded = ret == 0;
+    table->hint = 0;
+    return ret;
+}
+
+/**
+ * @brief Extend the file of a table by one extent.
+ *
+ * @details A file smaller than ALLOC_MAX_EXTENT_BYTES doubles, and a larger
+ * one grows by that much. The extent is reserved with aio_extend_table()
+ * without writing its pages, which read as zero. A table not open for async
+ * I/O cannot reserve the extent and fails instead of growing, since a full
+ * disk would otherwise only show up when its dirty pages are evicted. If the
+ * extent reaches a range no space map page covers yet, the new space map
+ * page is the first page of the extent.
+ */
+static int grow_table(alloc_table_t *table, int64_t table_id) {
+    uint64_t start_ns = metrics_now_ns();
+    uint64_t bits = map_bits(table->page_size);
+    uint64_t old_num_pages = table->num_pages;
+    uint64_t extent = std::max<uint64_t>(2, std::min<uint64_t>(
+        old_num_pages, ALLOC_MAX_EXTENT_BYTES / table->page_size));
+    uint64_t new_num_pages = old_num_pages + extent;
+
+    buf_descriptor_t *header_buf = get_buffer(table_id, 0, BUF_LATCH_EXCLUSIVE);
+    if (header_buf == nullptr)
+        return 1;
+    if (aio_extend_table(table_id, new_num_pages) != 0) {
+        release_buffer(header_buf, BUF_LATCH_EXCLUSIVE);
+        return 1;
+    }
+
+    std::vector<pagenum_t> new_map_pages;
+    for (uint64_t group = table->map_pages.size(); group < (new_num_pages + bits - 1) / bits; group++) {
+        pagenum_t page_num = old_num_pages + new_map_pages.size();
+        if (init_map_page(table, table_id, page_num, group, 0, -1) != 0) {
+            release_buffer(header_buf, BUF_LATCH_EXCLUSIVE);
+            return 1;
+        }
+        buf_descriptor_t *prev_buf = get_buffer(table_id, table->map_pages.back(), BUF_LATCH_EXCLUSIVE);
+        get_map_header(prev_buf)->next_map_page = page_num;
+        log_buffer_update(prev_buf, 0, sizeof(pagenum_t));
+        release_buffer(prev_buf, BUF_LATCH_EXCLUSIVE);
+        table->map_pages.push_back(page_num);
+        new_map_pages.push_back(page_num);
+    }
+    table->num_pages = new_num_pages;
+    table->num_free += extent;
+    update_map(table, table_id, new_map_pages, true);
+
+    header_buf->buf_page->num_of_pages = new_num_pages;
+    log_buffer_update(header_buf, 0, sizeof(pagenum_t) + sizeof(uint64_t));
+    release_buffer(header_buf, BUF_LATCH_EXCLUSIVE);
+    table->hint = old_num_pages;
+    metric_latency(LATENCY_GROW, start_ns);
+    return 0;
+}
+
+/**
+ * @brief Take up to num_pages free pages from the space map.
+ *
+ * @details Searches from the hint to the end of the file and then from the
+ * start, so pages are handed out in file order and freed pages are found
+ * again once the file is full.
+ */
+static void claim_pages(alloc_table_t *table, int64_t table_id, uint32_t num_pages,
+                        std::vector<pagenum_t> *pages) {
+    uint64_t bits = map_bits(table->page_size);
+    uint64_t num_groups = table->map_pages.size();
+    uint64_t hint = table->hint < table->num_pages ? table->hint : 0;
+    size_t num_wanted = pages->size() + num_pages;
+
+    for (uint64_t step = 0; step <= num_groups && pages->size() < num_wanted && table->num_free > 0; step++) {
+        uint64_t group = (hint / bits + step) % num_groups;
+        uint64_t start = step == 0 ? hint % bits : 0;
+        uint64_t limit = std::min(bits, table->num_pages - group * bits);
+        buf_descriptor_t *map_buf = get_buffer(table_id, table->map_pages[group], BUF_LATCH_EXCLUSIVE);
+        if (map_buf == nullptr)
+            return;
+        uint64_t *words = get_map_words(map_buf);
+        uint64_t first_word = UINT64_MAX, last_word = 0;
+
+        for (uint64_t w = start / 64; w * 64 < limit && pages->size() < num_wanted; w++) {
+            uint64_t free_bits = ~words[w];
+            if (w == start / 64)
+                free_bits &= ~0ULL << (start % 64);
+            if (limit - w * 64 < 64)
+                free_bits &= (1ULL << (limit - w * 64)) - 1;
+            while (free_bits != 0 && pages->size() < num_wanted) {
+                uint64_t bit = __builtin_ctzll(free_bits);
+                free_bits &= free_bits - 1;
+                words[w] |= 1ULL << bit;
+                pages->push_back(group * bits + w * 64 + bit);
+                table->num_free--;
+                first_word = std::min(first_word, w);
+                last_word = w;
+            }
+        }
+        if (first_word <= last_word)
+            log_map_words(map_buf, first_word, last_word + 1);
+        release_buffer(map_buf, BUF_LATCH_EXCLUSIVE);
+    }
+    if (!pages->empty())
+        table->hint = pages->back() + 1;
+}
+
+// 빈 thread cache를 orphans, space map, 늘린 file의 순서로 채움
+static int refill_cache(int64_t table_id, std::vector<pagenum_t> *pages) {
+    alloc_table_t *table = get_alloc_table(table_id);
+    std::lock_guard<std::mutex> guard(table->latch);
+    if (!table->is_loaded && load_table(table, table_id) != 0)
+        return 1;
+
+    while (!table->orphans.empty() && pages->size() < ALLOC_CACHE_PAGES) {
+        pages->push_back(table->orphans.back());
+        table->orphans.pop_back();
+    }
+    while (pages->size() < ALLOC_CACHE_PAGES) {
+        if (table->num_free == 0 && grow_table(table, table_id) != 0)
+            break;
+        size_t num_cached = pages->size();
+        claim_pages(table, table_id, ALLOC_CACHE_PAGES - num_cached, pages);
+        if (pages->size() == num_cached) {
+            // 세어 둔 빈 page 수가 space map과 어긋난 경우, 다시 늘려서 진행
+            buf_log_error("Error: space map of table " << table_id << " has no free page left");
+            table->num_free = 0;
+        }
+    }
+    if (pages->empty())
+        return 1;
+    // 뒤에서부터 꺼내 쓰므로 번호가 작은 page가 먼저 나가도록 정렬
+    std::sort(pages->begin(), pages->end(), std::greater<pagenum_t>());
+    return 0;
+}
+
+static void release_pages(int64_t table_id, std::vector<pagenum_t> *page_nums) {
+    alloc_table_t *table = get_alloc_table(table_id);
+    std::lock_guard<std::mutex> guard(table->latch);
+    if (!table->is_loaded && load_table(table, table_id) != 0)
+        return;
+    std::sort(page_nums->begin(), page_nums->end());
+    update_map(table, table_id, *page_nums, false);
+    // 앞쪽의 빈 page부터 다시 쓰도록 함
+    table->hint = std::min<uint64_t>(table->hint, page_nums->front());
+}
+
+/**
+ * @brief Allocate a page of a table.
+ *
+ * @return The page number, or -1 if the file cannot grow.
+ *
+ * @details Pages come from the calling thread's cache, which is refilled with
+ * ALLOC_CACHE_PAGES pages of the space map at a time. Concurrent inserts
+ * therefore neither latch the header page nor the space map on most
+ * allocations. The header page is only written when the file grows.
+ */
+pagenum_t alloc_page(int64_t table_id) {
+    std::vector<pagenum_t> &pages = local_cache.pages[table_id];
+    if (pages.empty() && refill_cache(table_id, &pages) != 0) {
+        buf_log_error("Error: cannot allocate a page of table " << table_id);
+        return -1;
+    }
+    pagenum_t page_num = pages.back();
+    pages.pop_back();
+    return page_num;
+}
+
+/**
+ * @brief Free a page of a table.
+ *
+ * @details The page goes to the calling thread's cache and is the next one
+ * the thread allocates. Once the cache holds more than ALLOC_MAX_CACHE_PAGES
+ * pages, its older half is marked free in the space map.
+ */
+void alloc_free_page(int64_t table_id, pagenum_t page_num) {
+    if (page_num <= 0) {
+        buf_log_error("Error: cannot free page " << page_num << " of table " << table_id);
+        return;
+    }
+    std::vector<pagenum_t> &pages = local_cache.pages[table_id];
+    pages.push_back(page_num);
+    if (pages.size() <= ALLOC_MAX_CACHE_PAGES)
+        return;
+    std::vector<pagenum_t> released(pages.begin(), pages.begin() + pages.size() / 2);
+    pages.erase(pages.begin(), pages.begin() + released.size());
+    release_pages(table_id, &released);
+}
+
+// space map에서 비어 있는 page 수, thread cache의 page는 세지 않음
+int64_t alloc_get_num_free(int64_t table_id) {
+    alloc_table_t *table = get_alloc_table(table_id);
+    std::lock_guard<std::mutex> guard(table->latch);
+    if (!table->is_loaded && load_table(table, table_id) != 0)
+        return -1;
+    return table->num_free + table->orphans.size();
+}
+
+/**
+ * @brief Give the cached pages of all threads back to the space maps.
+ *
+ * @details Called by close_buffer_pool() before the final checkpoint, while
+ * no other thread uses the buffer pool.
+ */
+void alloc_close() {
+    {
+        std::lock_guard<std::mutex> guard(caches_latch);
+        for (alloc_cache_t *cache : caches) {
+            for (auto &entry : cache->pages) {
+                if (!entry.second.empty())
+                    release_pages(entry.first, &entry.second);
+            }
+            cache->pages.clear();
+        }
+    }
+
+    std::vector<alloc_table_t *> closed;
+    {
+        std::lock_guard<std::mutex> guard(tables_latch);
+        closed.swap(tables);
+    }
+    for (size_t table_id = 0; table_id < closed.size(); table_id++) {
+        alloc_table_t *table = closed[table_id];
+        if (table == nullptr)
+            continue;
+        if (table->is_loaded && !table->orphans.empty()) {
+            std::sort(table->orphans.begin(), table->orphans.end());
+            update_map(table, table_id, table->orphans, false);
+        }
+        delete table;
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef DB_ALLOC_H_
+#define DB_ALLOC_H_
+
+#include "page.h"
+
+#include <cstdint>
+
+// space map page의 header에 두어 header page의 free_page_num이 space map을 가리킴을 나타냄 ("BUFALLOC")
+#define ALLOC_MAGIC (0x434f4c4c41465542ULL)
+// thread가 한 번에 space map에서 가져와 두는 page 수
+#define ALLOC_CACHE_PAGES (32)
+// thread에 쌓인 page가 이보다 많아지면 절반을 space map에 돌려놓음
+#define ALLOC_MAX_CACHE_PAGES (2 * ALLOC_CACHE_PAGES)
+// file을 한 번에 늘리는 크기의 상한 (64MB), 그보다 작은 file은 두 배로 늘림
+#define ALLOC_MAX_EXTENT_BYTES (64ULL << 20)
+
+/*
+ * The allocator keeps all of its state in space map pages and takes no
+ * bytes of the header page. Once a table has space maps, the header's
+ * free_page_num no longer heads a list of free pages but holds the first
+ * space map page, and every space map page carries ALLOC_MAGIC to tell it
+ * apart from the first page of such a list.
+ */
+
+// space map page의 앞부분, 뒤에 page마다 1bit(1이면 사용 중)인 bitmap이 이어짐
+// i번째 space map page는 page [i * bits, (i + 1) * bits)를 담당
+typedef struct alloc_map_header_t {
+    // 다음 space map page, 마지막이면 -1
+    pagenum_t next_map_page;
+    uint64_t magic;
+} alloc_map_header_t;
+
+pagenum_t alloc_page(int64_t table_id);
+void alloc_free_page(int64_t table_id, pagenum_t page_num);
+int64_t alloc_get_num_free(int64_t table_id);
+void alloc_close();
+
+#endif // DB_ALLOC_H_
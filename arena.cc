@@ -0,0 +1,208 @@
+#include "arena.h"
+#include "log.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <sys/mman.h>
+
+#ifdef HAVE_LIBNUMA
+#include <numa.h>
+#endif
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT (26)
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+
+// false면 explicit huge page도 THP도 쓰지 않음, 이후의 할당부터 적용
+static bool use_huge_pages = true;
+
+static void *map_anonymous(size_t size, int flags) {
+    void *addr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+    return addr == MAP_FAILED ? nullptr : addr;
+}
+
+/**
+ * @brief Turn huge pages for the arenas allocated from now on on or off.
+ *
+ * @details With huge pages off, areas are mapped with 4KB pages and
+ * transparent huge pages are refused with madvise(), which lets the TLB cost
+ * of a large buffer pool be compared.
+ */
+void arena_set_huge_pages(bool enabled) {
+    use_huge_pages = enabled;
+}
+
+// THP를 쓸 수 없어도 동작에는 문제 없음
+static void advise_huge_pages(void *addr, size_t map_size) {
+#if defined(MADV_HUGEPAGE) && defined(MADV_NOHUGEPAGE)
+    if (map_size >= HUGE_PAGE_SIZE_2MB)
+        madvise(addr, map_size, use_huge_pages ? MADV_HUGEPAGE : MADV_NOHUGEPAGE);
+#endif
+}
+
+/**
+ * @brief Allocate a large zero-filled memory area with mmap.
+ *
+ * @retval 0: successful
+ * @retval others: failed
+ *
+ * @details Explicit huge pages are tried first, 1GB pages if the area is at
+ * least 1GB and then 2MB pages, so that a large buffer pool needs few TLB
+ * entries. They are only available if the administrator reserved them
+ * (vm.nr_hugepages), so otherwise normal pages are mapped and transparent
+ * huge pages are requested with madvise().
+ *
+ * The memory is not touched here. Pages are allocated on the NUMA node of
+ * the thread that first writes them, unless arena_place() is called before.
+ */
+int arena_alloc(arena_t *arena, size_t size) {
+    static const struct {
+        size_t page_size;
+        int flags;
+    } huge_pages[] = {
+        {HUGE_PAGE_SIZE_1GB, MAP_HUGETLB | MAP_HUGE_1GB},
+        {HUGE_PAGE_SIZE_2MB, MAP_HUGETLB | MAP_HUGE_2MB},
+    };
+
+    for (const auto &huge_page : huge_pages) {
+        if (!use_huge_pages || size < huge_page.page_size)
+            continue;
+        size_t map_size = (size + huge_page.page_size - 1) & ~(huge_page.page_size - 1);
+        void *addr = map_anonymous(map_size, huge_page.flags);
+        if (addr != nullptr) {
+            arena->addr = addr;
+            arena->size = map_size;
+            arena->page_size = huge_page.page_size;
+            return 0;
+        }
+    }
+
+    size_t page_size = 4096;
+    size_t map_size = (size + page_size - 1) & ~(page_size - 1);
+    void *addr = map_anonymous(map_size, 0);
+    if (addr == nullptr) {
+        buf_log_error("Error: mmap of " << map_size << " bytes failed: " << strerror(errno));
+        return 1;
+    }
+    advise_huge_pages(addr, map_size);
+    arena->addr = addr;
+    arena->size = map_size;
+    arena->page_size = page_size;
+    return 0;
+}
+
+/**
+ * @brief Reserve a large zero-filled memory area that is mostly never used.
+ *
+ * @retval 0: successful
+ * @retval others: failed
+ *
+ * @details Unlike arena_alloc(), explicit huge pages are never used, since
+ * they would be allocated for the whole area at once. Only the pages that
+ * are written take memory, so the area can be sized for the most the buffer
+ * pool may ever grow to.
+ */
+int arena_reserve(arena_t *arena, size_t size) {
+    size_t page_size = 4096;
+    size_t map_size = (size + page_size - 1) & ~(page_size - 1);
+    void *addr = map_anonymous(map_size, MAP_NORESERVE);
+    if (addr == nullptr) {
+        buf_log_error("Error: mmap of " << map_size << " bytes failed: " << strerror(errno));
+        return 1;
+    }
+    advise_huge_pages(addr, map_size);
+    arena->addr = addr;
+    arena->size = map_size;
+    arena->page_size = page_size;
+    return 0;
+}
+
+void arena_free(arena_t *arena) {
+    if (arena->addr != nullptr)
+        munmap(arena->addr, arena->size);
+    arena->addr = nullptr;
+    arena->size = 0;
+}
+
+/**
+ * @brief Get the number of NUMA nodes, 1 if NUMA is not supported.
+ */
+int arena_num_nodes() {
+#ifdef HAVE_LIBNUMA
+    if (numa_available() >= 0)
+        return std::max(1, numa_num_configured_nodes());
+#endif
+    return 1;
+}
+
+/**
+ * @brief Get the elements [first, last) that BUF_NUMA_PARTITION puts on node.
+ */
+void arena_node_range(uint64_t num_elems, int node, int num_nodes,
+                      uint64_t *first, uint64_t *last) {
+    *first = num_elems * node / num_nodes;
+    *last = num_elems * (node + 1) / num_nodes;
+}
+
+/**
+ * @brief Set the NUMA placement of an arena of num_elems elements.
+ *
+ * @retval 0: successful
+ * @retval others: NUMA is not supported, the OS default placement is kept
+ *
+ * @details Must be called before the memory is touched. With
+ * BUF_NUMA_PARTITION, the boundaries of the nodes' ranges are rounded down to
+ * the arena's page size, so an element at a boundary may sit on the
+ * neighboring node.
+ */
+int arena_place(arena_t *arena, size_t elem_size, uint64_t num_elems, buf_numa_mode_t mode) {
+    if (mode == BUF_NUMA_NONE)
+        return 0;
+#ifdef HAVE_LIBNUMA
+    if (numa_available() < 0)
+        return 1;
+
+    if (mode == BUF_NUMA_INTERLEAVE) {
+        numa_interleave_memory(arena->addr, arena->size, numa_all_nodes_ptr);
+        return 0;
+    }
+
+    int num_nodes = arena_num_nodes();
+    for (int node = 0; node < num_nodes; node++) {
+        uint64_t first, last;
+        arena_node_range(num_elems, node, num_nodes, &first, &last);
+        size_t begin = (first * elem_size) & ~(arena->page_size - 1);
+        size_t end = node == num_nodes - 1 ? arena->size
+                                           : (last * elem_size) & ~(arena->page_size - 1);
+        if (begin < end)
+            numa_tonode_memory((char *)arena->addr + begin, end - begin, node);
+    }
+    return 0;
+#else
+    (void)arena;
+    (void)elem_size;
+    (void)num_elems;
+    return 1;
+#endif
+}
+
+/**
+ * @brief Run the calling thread on the CPUs of a NUMA node.
+ */
+void arena_bind_thread(int node) {
+#ifdef HAVE_LIBNUMA
+    if (numa_available() >= 0)
+        numa_run_on_node(node);
+#else
+    (void)node;
+#endif
+}
@@ -0,0 +1,37 @@
+#ifndef DB_ARENA_H_
+#define DB_ARENA_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#define HUGE_PAGE_SIZE_2MB (2UL << 20)
+#define HUGE_PAGE_SIZE_1GB (1UL << 30)
+
+// buffer pool 메모리를 NUMA node에 배치하는 방식
+typedef enum buf_numa_mode_t {
+    BUF_NUMA_NONE,          // 처음 쓰는 thread의 node에 배치 (OS 기본 동작)
+    BUF_NUMA_INTERLEAVE,    // 모든 node에 page 단위로 번갈아 배치
+    BUF_NUMA_PARTITION      // 배열을 node 수만큼 연속 구간으로 나누어 node마다 하나씩
+} buf_numa_mode_t;
+
+// mmap으로 할당한 큰 연속 메모리
+typedef struct arena_t {
+    void *addr;
+    // mmap한 크기, page_size의 배수
+    size_t size;
+    // 실제로 쓰인 page 크기: 1GB, 2MB 또는 4KB (4KB면 transparent huge page를 요청)
+    size_t page_size;
+} arena_t;
+
+void arena_set_huge_pages(bool enabled);
+int arena_alloc(arena_t *arena, size_t size);
+int arena_reserve(arena_t *arena, size_t size);
+void arena_free(arena_t *arena);
+
+int arena_num_nodes();
+void arena_node_range(uint64_t num_elems, int node, int num_nodes,
+                      uint64_t *first, uint64_t *last);
+int arena_place(arena_t *arena, size_t elem_size, uint64_t num_elems, buf_numa_mode_t mode);
+void arena_bind_thread(int node);
+
+#endif // DB_ARENA_H_
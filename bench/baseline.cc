@@ -0,0 +1,157 @@
+#include "baseline.h"
+#include "aio.h"
+#include "file.h"
+#include "metrics.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+void baseline_init_freelist(baseline_freelist_t *freelist) {
+    freelist->head = nullptr;
+}
+
+void baseline_add_to_freelist(baseline_freelist_t *freelist, buf_descriptor_t *buf_desc) {
+    std::lock_guard<std::mutex> guard(freelist->latch);
+    freelist->head = new baseline_free_node_t{buf_desc, freelist->head};
+}
+
+// freelist가 비어 있으면 nullptr
+buf_descriptor_t *baseline_get_from_freelist(baseline_freelist_t *freelist) {
+    std::lock_guard<std::mutex> guard(freelist->latch);
+    baseline_free_node_t *node = freelist->head;
+    if (node == nullptr)
+        return nullptr;
+    freelist->head = node->next;
+    buf_descriptor_t *buf_desc = node->buf_desc;
+    delete node;
+    return buf_desc;
+}
+
+void baseline_free_freelist(baseline_freelist_t *freelist) {
+    while (baseline_get_from_freelist(freelist) != nullptr) {
+    }
+}
+
+// table_id와 page_num을 섞지 않고 나머지로 bucket을 정함
+static uint32_t baseline_hash(const baseline_hashtable_t *hashtable, int64_t table_id,
+                              pagenum_t page_num) {
+    return (((uint64_t)table_id) * 100000 + page_num) % hashtable->num_ht_entries;
+}
+
+void baseline_init_hashtable(baseline_hashtable_t *hashtable, uint32_t num_ht_entries,
+                             uint32_t num_partitions) {
+    hashtable->num_ht_entries = num_ht_entries;
+    hashtable->ht_entries = new baseline_ht_entry_t[num_ht_entries];
+    for (uint32_t i = 0; i < num_ht_entries; i++) {
+        hashtable->ht_entries[i].buf_desc = nullptr;
+        hashtable->ht_entries[i].next = nullptr;
+    }
+    hashtable->num_partitions = num_partitions;
+    hashtable->partition_latches = new std::mutex[num_partitions];
+}
+
+// page가 hashtable에 없다고 가정, bucket이 차 있으면 node를 할당해 chain에 연결
+void baseline_hashtable_insert(baseline_hashtable_t *hashtable, buf_descriptor_t *buf_desc) {
+    uint32_t bucket = baseline_hash(hashtable, buf_desc->table_id, buf_desc->page_num);
+    std::lock_guard<std::mutex> guard(hashtable->partition_latches[bucket % hashtable->num_partitions]);
+    baseline_ht_entry_t *ht_entry = &hashtable->ht_entries[bucket];
+    if (ht_entry->buf_desc == nullptr) {
+        ht_entry->buf_desc = buf_desc;
+        return;
+    }
+    ht_entry->next = new baseline_ht_entry_t{buf_desc, ht_entry->next};
+}
+
+// is_buffer_resident()와 같이 partition latch를 잡고 chain을 따라가며 찾음
+bool baseline_is_resident(baseline_hashtable_t *hashtable, int64_t table_id, pagenum_t page_num) {
+    uint32_t bucket = baseline_hash(hashtable, table_id, page_num);
+    std::lock_guard<std::mutex> guard(hashtable->partition_latches[bucket % hashtable->num_partitions]);
+    for (baseline_ht_entry_t *ht_entry = &hashtable->ht_entries[bucket]; ht_entry;
+         ht_entry = ht_entry->next) {
+        if (ht_entry->buf_desc && ht_entry->buf_desc->table_id == table_id &&
+            ht_entry->buf_desc->page_num == page_num)
+            return true;
+    }
+    return false;
+}
+
+void baseline_free_hashtable(baseline_hashtable_t *hashtable) {
+    for (uint32_t i = 0; i < hashtable->num_ht_entries; i++) {
+        baseline_ht_entry_t *ht_entry = hashtable->ht_entries[i].next;
+        while (ht_entry) {
+            baseline_ht_entry_t *next = ht_entry->next;
+            delete ht_entry;
+            ht_entry = next;
+        }
+    }
+    delete[] hashtable->ht_entries;
+    delete[] hashtable->partition_latches;
+}
+
+/**
+ * @brief Allocate a page the way get_buffer_of_new_page() did before the
+ * extent allocator.
+ *
+ * @param grow_ns Set to the time spent doubling the file, or 0 if it did not
+ * grow
+ * @return The page number, or -1 if the header page cannot be read.
+ *
+ * @details Every allocation takes the header page's exclusive latch, so
+ * allocations are serialized on it, and reads the next free page to unlink
+ * it. An empty list doubles the file by writing each new free page, linked
+ * to the previous one, in async batches of BASELINE_GROW_BATCH_PAGES.
+ */
+pagenum_t baseline_alloc_page(int64_t table_id, uint64_t *grow_ns) {
+    *grow_ns = 0;
+    buf_descriptor_t *header_buf = get_buffer(table_id, 0, BUF_LATCH_EXCLUSIVE);
+    if (header_buf == nullptr)
+        return -1;
+    page_t *header_page = header_buf->buf_page;
+    pagenum_t page_num = header_page->free_page_num;
+
+    if (page_num != -1) {
+        buf_descriptor_t *buf_desc = get_buffer(table_id, page_num);
+        if (buf_desc == nullptr) {
+            release_buffer(header_buf, BUF_LATCH_EXCLUSIVE);
+            return -1;
+        }
+        header_page->free_page_num = buf_desc->buf_page->next_free_page_num;
+        unpin_buffer(buf_desc);
+        log_buffer_update(header_buf, 0, sizeof(pagenum_t));
+        release_buffer(header_buf, BUF_LATCH_EXCLUSIVE);
+        return page_num;
+    }
+
+    // 새 page 중 첫 page가 list의 끝이고 나머지는 앞 page를 가리킴, 마지막 page를 반환
+    uint64_t start_ns = metrics_now_ns();
+    uint64_t num_of_pages = 2 * header_page->num_of_pages;
+    uint32_t num_batch_pages = std::min<uint64_t>(BASELINE_GROW_BATCH_PAGES, num_of_pages);
+    std::vector<page_t> tmp_pages(num_batch_pages);
+    std::vector<aio_request_t> requests(num_batch_pages);
+    for (pagenum_t first = header_page->num_of_pages; first < (pagenum_t)num_of_pages - 1;
+         first += num_batch_pages) {
+        uint32_t num_pages = std::min<uint64_t>(num_batch_pages, num_of_pages - 1 - first);
+        for (uint32_t j = 0; j < num_pages; j++) {
+            pagenum_t free_page_num = first + j;
+            memset(&tmp_pages[j], 0, sizeof(page_t));
+            tmp_pages[j].next_free_page_num =
+                free_page_num == (pagenum_t)header_page->num_of_pages ? -1 : free_page_num - 1;
+            requests[j] = {table_id, free_page_num, &tmp_pages[j], true, nullptr, nullptr, nullptr};
+        }
+        aio_batch_t batch;
+        aio_init_batch(&batch);
+        if (aio_submit(requests.data(), num_pages, &batch) != 0 || aio_wait(&batch) != 0) {
+            for (uint32_t j = 0; j < num_pages; j++)
+                file_write_page(table_id, first + j, &tmp_pages[j]);
+        }
+    }
+    // 1 page에서 늘리면 반환할 page 외에 새 page가 없음
+    uint64_t old_num_of_pages = header_page->num_of_pages;
+    header_page->free_page_num = num_of_pages - 2 >= old_num_of_pages ? num_of_pages - 2 : -1;
+    header_page->num_of_pages = num_of_pages;
+    log_buffer_update(header_buf, 0, sizeof(pagenum_t) + sizeof(uint64_t));
+    release_buffer(header_buf, BUF_LATCH_EXCLUSIVE);
+    *grow_ns = metrics_now_ns() - start_ns;
+    return num_of_pages - 1;
+}
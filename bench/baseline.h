@@ -0,0 +1,58 @@
+#ifndef DB_BENCH_BASELINE_H_
+#define DB_BENCH_BASELINE_H_
+
+#include "buffer.h"
+
+#include <cstdint>
+#include <mutex>
+
+/*
+ * Earlier implementations of parts of the pool, kept only as baselines for
+ * bench.cc. They are the code the pool used before it was replaced, without
+ * the per-call logging to std::cout of the original.
+ */
+
+// linked list형의 free_list 구현, node를 push마다 heap에 할당
+typedef struct baseline_free_node_t {
+    buf_descriptor_t *buf_desc;
+    baseline_free_node_t *next;
+} baseline_free_node_t;
+
+// mutex 하나로 보호하는 freelist
+typedef struct baseline_freelist_t {
+    std::mutex latch;
+    baseline_free_node_t *head;
+} baseline_freelist_t;
+
+void baseline_init_freelist(baseline_freelist_t *freelist);
+void baseline_add_to_freelist(baseline_freelist_t *freelist, buf_descriptor_t *buf_desc);
+buf_descriptor_t *baseline_get_from_freelist(baseline_freelist_t *freelist);
+void baseline_free_freelist(baseline_freelist_t *freelist);
+
+// bucket 배열과 충돌 시 heap에 할당하는 chain, 해시 충돌 해결을 위한 체이닝 포인터
+typedef struct baseline_ht_entry_t {
+    buf_descriptor_t *buf_desc;
+    baseline_ht_entry_t *next;
+} baseline_ht_entry_t;
+
+// bucket마다 chain을 둔 hashtable, bucket 번호로 정한 partition마다 latch
+typedef struct baseline_hashtable_t {
+    uint32_t num_ht_entries;
+    baseline_ht_entry_t *ht_entries;
+    uint32_t num_partitions;
+    std::mutex *partition_latches;
+} baseline_hashtable_t;
+
+void baseline_init_hashtable(baseline_hashtable_t *hashtable, uint32_t num_ht_entries,
+                             uint32_t num_partitions);
+void baseline_hashtable_insert(baseline_hashtable_t *hashtable, buf_descriptor_t *buf_desc);
+bool baseline_is_resident(baseline_hashtable_t *hashtable, int64_t table_id, pagenum_t page_num);
+void baseline_free_hashtable(baseline_hashtable_t *hashtable);
+
+// file을 두 배로 늘릴 때 한 번에 써 넣는 free page 수
+#define BASELINE_GROW_BATCH_PAGES (256)
+
+// header page의 free page list에서 page를 꺼내고, 비었으면 file을 두 배로 늘림 (PAGE_SIZE table만)
+pagenum_t baseline_alloc_page(int64_t table_id, uint64_t *grow_ns);
+
+#endif // DB_BENCH_BASELINE_H_
@@ -0,0 +1,2040 @@
+#include "aio.h"
+#include "alloc.h"
+#include "arena.h"
+#include "baseline.h"
+#include "buffer.h"
+#include "metrics.h"
+#include "trace.h"
+#include "wal.h"
+#include "warm.h"
+#include "workload.h"
+#include "zcache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// page마다 자기 page 번호를 써 두는 위치, read가 맞는 page를 읽었는지 확인
+#define BENCH_MARK_OFFSET (64)
+// write가 고치는 8 bytes의 위치
+#define BENCH_COUNTER_OFFSET (128)
+// fill_table()이 random bytes를 채우기 시작하는 위치
+#define BENCH_RANDOM_OFFSET (256)
+// 측정 전에 같은 workload로 pool을 채우는 op 수의 비율 (num_ops / n)
+#define BENCH_WARMUP_DIVISOR (2)
+
+// read가 page에 닿는 방법
+typedef enum bench_access_t {
+    BENCH_ACCESS_GET_BUFFER,    // get_buffer()와 shared latch
+    BENCH_ACCESS_OPTIMISTIC,    // read_buffer()의 낙관적 읽기
+    BENCH_ACCESS_SWIP           // page마다 둔 swip으로 get_buffer_swip()
+} bench_access_t;
+
+// 명령행으로 받는 설정
+typedef struct bench_options_t {
+    const char *experiment;
+    const char *dir;
+    uint32_t num_threads;
+    // thread 하나가 하는 op 수
+    uint64_t num_ops;
+    uint64_t num_pages;
+    uint32_t num_buf;
+    // ckpt_large에서 checkpoint하는 dirty page 수
+    uint64_t num_dirty_pages;
+    // alloc에서 할당하는 page 수
+    uint64_t num_alloc_pages;
+    bench_workload_kind_t workload;
+    buf_policy_kind_t policy;
+    buf_ht_latch_mode_t latch_mode;
+    const char *record;
+    const char *replay;
+} bench_options_t;
+
+// benchmark가 채운 table 하나
+typedef struct bench_table_t {
+    std::string pathname;
+    int64_t table_id;
+    // 채운 순서대로의 page 번호, op의 page는 이 배열의 index
+    std::vector<pagenum_t> pages;
+} bench_table_t;
+
+// 한 번의 측정
+typedef struct bench_run_t {
+    const char *experiment;
+    // 결과 JSON에 그대로 들어가는 변형의 설정, 예: "\"policy\":\"CLOCK\""
+    std::string config;
+    bench_workload_config_t workload;
+    bench_access_t access;
+    // scan을 BUF_STRATEGY_BULK_READ ring으로 읽음
+    bool use_ring;
+    uint32_t num_threads;
+    uint64_t num_ops;
+    bench_table_t *table;
+    // scan은 이 table을 읽음, nullptr이면 table
+    bench_table_t *scan_table;
+    // BENCH_ACCESS_SWIP에서 table의 page마다 하나
+    buf_swip_t *swips;
+    // warm-up과 init_buffer_stat() 뒤, 재는 op를 시작하기 직전에 호출
+    std::function<void()> on_start;
+    // nullptr이 아니면 num_ops를 마친 뒤에도 true가 될 때까지 op를 계속함
+    const std::atomic<bool> *run_until;
+} bench_run_t;
+
+typedef struct bench_result_t {
+    uint64_t num_ops;
+    // nullptr을 받았거나 다른 page를 읽은 op 수
+    uint64_t num_failures;
+    uint64_t elapsed_ns;
+    // op 종류마다의 latency histogram (metrics.h의 bucket)
+    std::vector<uint64_t> buckets[BENCH_OP_INSERT + 1];
+    uint64_t max_ns;
+    buf_stat_snapshot_t *stat;
+} bench_result_t;
+
+static bench_options_t options;
+// fill_tables()가 채운 table의 경로마다 채운 순서대로의 page 번호
+static std::map<std::string, std::vector<pagenum_t>> filled_tables;
+
+static const char *op_names[] = {"read", "write", "scan", "insert"};
+
+static void init_result(bench_result_t *result) {
+    result->num_ops = 0;
+    result->num_failures = 0;
+    result->elapsed_ns = 0;
+    for (std::vector<uint64_t> &buckets : result->buckets)
+        buckets.assign(HIST_NUM_BUCKETS, 0);
+    result->max_ns = 0;
+    result->stat = new buf_stat_snapshot_t;
+}
+
+static void free_result(bench_result_t *result) {
+    delete result->stat;
+    result->stat = nullptr;
+}
+
+// buckets에서 q 분위수가 들어 있는 bucket의 상한
+static uint64_t percentile(const std::vector<uint64_t> &buckets, double q) {
+    uint64_t count = 0;
+    for (uint64_t n : buckets)
+        count += n;
+    if (count == 0)
+        return 0;
+    uint64_t rank = (uint64_t)(q * count);
+    uint64_t seen = 0;
+    for (uint32_t b = 0; b < buckets.size(); b++) {
+        seen += buckets[b];
+        if (seen > rank)
+            return hist_bucket_upper(b);
+    }
+    return hist_bucket_upper(buckets.size() - 1);
+}
+
+static std::string latency_json(const std::vector<uint64_t> &buckets) {
+    char text[160];
+    snprintf(text, sizeof(text), "{\"p50\":%" PRIu64 ",\"p90\":%" PRIu64 ",\"p99\":%" PRIu64
+             ",\"p999\":%" PRIu64 "}", percentile(buckets, 0.5), percentile(buckets, 0.9),
+             percentile(buckets, 0.99), percentile(buckets, 0.999));
+    return text;
+}
+
+// 익명 메모리 사용량 (kB), /proc이 없으면 -1
+// /proc의 file에서 "name: N kB" 줄의 N, 없으면 -1
+static int64_t get_proc_kb(const char *path, const char *name) {
+    FILE *file = fopen(path, "r");
+    if (file == nullptr)
+        return -1;
+    char line[256];
+    int64_t kb = -1;
+    size_t name_len = strlen(name);
+    while (fgets(line, sizeof(line), file)) {
+        if (strncmp(line, name, name_len) == 0 && line[name_len] == ':' &&
+            sscanf(line + name_len + 1, "%" SCNd64, &kb) == 1)
+            break;
+    }
+    fclose(file);
+    return kb;
+}
+
+static int64_t get_rss_anon_kb() {
+    return get_proc_kb("/proc/self/status", "RssAnon");
+}
+
+/**
+ * @brief Print one measurement as a line of JSON.
+ *
+ * @param extra More fields, each starting with a comma, or ""
+ *
+ * @details Throughput and the latency percentiles are measured per operation
+ * by the benchmark, and the hit ratio, page I/O and write counts come from
+ * the pool's statistics of the same interval.
+ */
+static void print_result(const bench_run_t *run, const bench_result_t *result,
+                         const std::string &extra) {
+    const buf_stat_snapshot_t *s = result->stat;
+    std::vector<uint64_t> all(HIST_NUM_BUCKETS, 0);
+    std::string by_op;
+    for (int kind = 0; kind <= BENCH_OP_INSERT; kind++) {
+        uint64_t count = 0;
+        for (uint32_t b = 0; b < HIST_NUM_BUCKETS; b++) {
+            all[b] += result->buckets[kind][b];
+            count += result->buckets[kind][b];
+        }
+        if (count == 0)
+            continue;
+        by_op += std::string(by_op.empty() ? "" : ",") + "\"" + op_names[kind] + "\":" +
+                 latency_json(result->buckets[kind]);
+    }
+    double ops_per_sec = result->elapsed_ns == 0 ? 0 : result->num_ops * 1e9 / result->elapsed_ns;
+    std::string latency = latency_json(all);
+    latency.insert(latency.size() - 1, ",\"max\":" + std::to_string(result->max_ns));
+
+    printf("{\"experiment\":\"%s\",%s,\"workload\":\"%s\",\"threads\":%u,\"cpus\":%u,\"ops\":%" PRIu64
+           ",\"failures\":%" PRIu64 ",\"elapsed_ns\":%" PRIu64 ",\"ops_per_sec\":%.0f,"
+           "\"num_buf\":%u,\"hit_ratio\":%.2f,\"hits\":%" PRIu64 ",\"misses\":%" PRIu64 ","
+           "\"page_io\":{\"read\":%" PRId64 ",\"write\":%" PRId64 ",\"async_read\":%" PRId64
+           ",\"async_write\":%" PRId64 "},\"writes\":{\"foreground\":%" PRIu64 ",\"background\":%"
+           PRIu64 ",\"checkpoint\":%" PRIu64 "},\"latency_ns\":%s,\"latency_by_op_ns\":{%s}%s}\n",
+           run->experiment, run->config.c_str(), workload_name(run->workload.kind),
+           run->num_threads, std::thread::hardware_concurrency(), result->num_ops,
+           result->num_failures, result->elapsed_ns,
+           ops_per_sec, s->num_buf, s->hit_ratio, s->hits,
+           s->counters[METRIC_MISS], s->read_pages, s->write_pages, s->aio_read_pages,
+           s->aio_write_pages, s->counters[METRIC_FG_WRITE], s->counters[METRIC_BG_WRITE],
+           s->counters[METRIC_CHECKPOINT_WRITE], latency.c_str(), by_op.c_str(),
+           extra.c_str());
+    fflush(stdout);
+}
+
+static std::string table_path(const char *name) {
+    return std::string(options.dir) + "/" + name + ".db";
+}
+
+// table file을 page cache에서 내보내 다음 읽기가 disk까지 가게 함
+static void drop_page_cache(const char *name) {
+    int fd = open(table_path(name).c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+static int open_pool(uint32_t num_buf, buf_policy_kind_t policy = BUF_POLICY_CLOCK,
+                     buf_ht_latch_mode_t latch_mode = BUF_HT_PARTITIONED) {
+    set_ht_latch_mode(latch_mode);
+    if (init_buffer_pool(2 * num_buf, num_buf, policy) != 0) {
+        fprintf(stderr, "cannot initialize a pool of %u buffers\n", num_buf);
+        return 1;
+    }
+    return 0;
+}
+
+// size class 설정으로 pool을 엶
+static int open_pool(const buf_size_class_config_t *size_classes, uint32_t num_size_classes) {
+    set_ht_latch_mode(BUF_HT_PARTITIONED);
+    uint32_t num_buf = 0;
+    for (uint32_t i = 0; i < num_size_classes; i++)
+        num_buf += size_classes[i].num_buf;
+    if (init_buffer_pool(2 * num_buf, size_classes, num_size_classes) != 0) {
+        fprintf(stderr, "cannot initialize a pool of %u buffers\n", num_buf);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Create a benchmark table of num_pages pages.
+ *
+ * @details Each page holds its own page number at BENCH_MARK_OFFSET, so a
+ * read can tell that it got the right page. The pages are made in a pool
+ * large enough to hold them all, and written out by closing that pool, so
+ * this runs while no other pool is open. A table of another page_size must
+ * be opened with the same page_size by open_table(). random_bytes bytes of
+ * each page from BENCH_RANDOM_OFFSET are random, so the page does not
+ * compress to almost nothing; the rest is zero.
+ */
+static int fill_table(const char *name, uint64_t num_pages, uint32_t page_size = PAGE_SIZE,
+                      uint32_t random_bytes = 0) {
+    std::string pathname = table_path(name);
+    fprintf(stderr, "filling %s with %" PRIu64 " pages\n", pathname.c_str(), num_pages);
+    unlink(pathname.c_str());
+    buf_size_class_config_t size_class = {page_size, (uint32_t)num_pages + 64, 0};
+    if (open_pool(&size_class, 1) != 0)
+        return 1;
+    int64_t table_id = buffer_open_table(pathname.c_str(), page_size);
+    std::vector<pagenum_t> pages;
+    std::mt19937_64 rng(0x5eed);
+    for (uint64_t i = 0; i < num_pages && table_id >= 0; i++) {
+        buf_descriptor_t *buf_desc = get_buffer_of_new_page(table_id);
+        if (buf_desc == nullptr)
+            break;
+        latch_buffer(buf_desc, BUF_LATCH_EXCLUSIVE);
+        memcpy(buf_desc->buf_page->data + BENCH_MARK_OFFSET, &buf_desc->page_num, sizeof(pagenum_t));
+        for (uint32_t offset = 0; offset + sizeof(uint64_t) <= random_bytes; offset += sizeof(uint64_t)) {
+            uint64_t value = rng();
+            memcpy(buf_desc->buf_page->data + BENCH_RANDOM_OFFSET + offset, &value, sizeof(value));
+        }
+        mark_buffer_dirty(buf_desc);
+        pages.push_back(buf_desc->page_num);
+        release_buffer(buf_desc, BUF_LATCH_EXCLUSIVE);
+    }
+    close_buffer_pool();
+    if (pages.size() != num_pages) {
+        fprintf(stderr, "cannot fill %s\n", pathname.c_str());
+        return 1;
+    }
+    filled_tables[pathname] = std::move(pages);
+    return 0;
+}
+
+// 모든 experiment가 쓰는 table을 채움, 채운 page 번호는 process가 끝날 때까지 기억
+static int fill_tables() {
+    return fill_table("main", options.num_pages) || fill_table("scan", options.num_pages) ||
+           fill_table("hot", options.num_buf / 2) ||
+           fill_table("ckpt", std::min<uint64_t>(options.num_pages, options.num_buf));
+}
+
+// fill_tables()가 채운 table을 열린 pool에 엶
+static int open_table(bench_table_t *table, const char *name,
+                      buf_table_mode_t mode = BUF_TABLE_READ_WRITE, uint32_t page_size = PAGE_SIZE) {
+    table->pathname = table_path(name);
+    auto filled = filled_tables.find(table->pathname);
+    if (filled == filled_tables.end())
+        return 1;
+    table->pages = filled->second;
+    table->table_id = buffer_open_table(table->pathname.c_str(), page_size, mode);
+    return table->table_id < 0;
+}
+
+// 한 thread의 상태
+typedef struct bench_thread_t {
+    const bench_run_t *run;
+    bench_generator_t generator;
+    buf_strategy_t *strategy;
+    // BENCH_INSERT에서 이 thread가 만든 page
+    std::vector<pagenum_t> inserted;
+    uint64_t num_failures;
+} bench_thread_t;
+
+static bool check_mark(const page_t *page, pagenum_t page_num) {
+    pagenum_t mark;
+    memcpy(&mark, page->data + BENCH_MARK_OFFSET, sizeof(pagenum_t));
+    return mark == page_num;
+}
+
+static bool read_page(bench_thread_t *thread, bench_table_t *table, uint64_t page) {
+    const bench_run_t *run = thread->run;
+    pagenum_t page_num = table->pages[page];
+    if (run->access == BENCH_ACCESS_OPTIMISTIC) {
+        pagenum_t mark;
+        return read_buffer(table->table_id, page_num, BENCH_MARK_OFFSET, sizeof(mark), &mark) == 0 &&
+               mark == page_num;
+    }
+    buf_descriptor_t *buf_desc = run->access == BENCH_ACCESS_SWIP && table == run->table ?
+        get_buffer_swip(&run->swips[page], BUF_LATCH_SHARED) :
+        get_buffer(table->table_id, page_num, BUF_LATCH_SHARED);
+    if (buf_desc == nullptr)
+        return false;
+    bool is_right = check_mark(buf_desc->buf_page, page_num);
+    release_buffer(buf_desc, BUF_LATCH_SHARED);
+    return is_right;
+}
+
+static bool write_page(bench_table_t *table, pagenum_t page_num) {
+    buf_descriptor_t *buf_desc = get_buffer(table->table_id, page_num, BUF_LATCH_EXCLUSIVE);
+    if (buf_desc == nullptr)
+        return false;
+    uint64_t counter;
+    memcpy(&counter, buf_desc->buf_page->data + BENCH_COUNTER_OFFSET, sizeof(counter));
+    counter++;
+    memcpy(buf_desc->buf_page->data + BENCH_COUNTER_OFFSET, &counter, sizeof(counter));
+    log_buffer_update(buf_desc, BENCH_COUNTER_OFFSET, sizeof(counter));
+    bool is_right = check_mark(buf_desc->buf_page, page_num);
+    release_buffer(buf_desc, BUF_LATCH_EXCLUSIVE);
+    return is_right;
+}
+
+static bool scan_pages(bench_thread_t *thread, uint64_t first, uint32_t length) {
+    const bench_run_t *run = thread->run;
+    bench_table_t *table = run->scan_table ? run->scan_table : run->table;
+    bool is_right = true;
+    for (uint32_t i = 0; i < length; i++) {
+        pagenum_t page_num = table->pages[(first + i) % table->pages.size()];
+        buf_descriptor_t *buf_desc = get_buffer(table->table_id, page_num, BUF_LATCH_NONE, thread->strategy);
+        if (buf_desc == nullptr)
+            return false;
+        is_right = is_right && check_mark(buf_desc->buf_page, page_num);
+        unpin_buffer(buf_desc);
+    }
+    return is_right;
+}
+
+static bool insert_page(bench_thread_t *thread) {
+    bench_table_t *table = thread->run->table;
+    buf_descriptor_t *buf_desc = get_buffer_of_new_page(table->table_id);
+    if (buf_desc == nullptr)
+        return false;
+    latch_buffer(buf_desc, BUF_LATCH_EXCLUSIVE);
+    memcpy(buf_desc->buf_page->data + BENCH_MARK_OFFSET, &buf_desc->page_num, sizeof(pagenum_t));
+    log_buffer_update(buf_desc, BENCH_MARK_OFFSET, sizeof(pagenum_t));
+    thread->inserted.push_back(buf_desc->page_num);
+    release_buffer(buf_desc, BUF_LATCH_EXCLUSIVE);
+    return true;
+}
+
+static bool run_op(bench_thread_t *thread, const bench_op_t &op) {
+    bench_table_t *table = thread->run->table;
+    switch (op.kind) {
+    case BENCH_OP_READ:
+        if (thread->run->workload.kind == BENCH_INSERT) {
+            if (thread->inserted.empty())
+                return true;
+            pagenum_t page_num = thread->inserted[op.page % thread->inserted.size()];
+            buf_descriptor_t *buf_desc = get_buffer(table->table_id, page_num, BUF_LATCH_SHARED);
+            if (buf_desc == nullptr)
+                return false;
+            bool is_right = check_mark(buf_desc->buf_page, page_num);
+            release_buffer(buf_desc, BUF_LATCH_SHARED);
+            return is_right;
+        }
+        return read_page(thread, table, op.page);
+    case BENCH_OP_WRITE:
+        return write_page(table, table->pages[op.page]);
+    case BENCH_OP_SCAN:
+        return scan_pages(thread, op.page, op.length);
+    case BENCH_OP_INSERT:
+        return insert_page(thread);
+    }
+    return false;
+}
+
+/**
+ * @brief Run a workload on the open pool and measure it.
+ *
+ * @details Each thread first runs num_ops / BENCH_WARMUP_DIVISOR operations
+ * of the same workload untimed, so the pool is in its steady state. The
+ * pool's statistics are reset when all threads are warm, and every thread's
+ * operations are then timed one by one.
+ */
+static int run_workload(const bench_run_t *run, bench_result_t *result) {
+    init_result(result);
+    std::vector<bench_thread_t> threads(run->num_threads);
+    std::vector<std::vector<uint64_t>> buckets(run->num_threads * (BENCH_OP_INSERT + 1),
+                                               std::vector<uint64_t>(HIST_NUM_BUCKETS, 0));
+    std::vector<uint64_t> max_ns(run->num_threads, 0);
+    std::vector<uint64_t> num_ops(run->num_threads, 0);
+    std::atomic<uint32_t> num_warm{0};
+    std::atomic<bool> is_started{false};
+    uint64_t start_ns = 0;
+
+    std::vector<std::thread> workers;
+    for (uint32_t t = 0; t < run->num_threads; t++) {
+        workers.emplace_back([&, t] {
+            bench_thread_t *thread = &threads[t];
+            thread->run = run;
+            thread->num_failures = 0;
+            thread->strategy = run->use_ring ? get_buffer_strategy(BUF_STRATEGY_BULK_READ) : nullptr;
+            workload_init_generator(&thread->generator, &run->workload, 0x5eed + t);
+            for (uint64_t i = 0; i < run->num_ops / BENCH_WARMUP_DIVISOR; i++)
+                run_op(thread, workload_next(&thread->generator));
+
+            num_warm++;
+            while (!is_started.load())
+                std::this_thread::yield();
+            for (uint64_t &i = num_ops[t];
+                 i < run->num_ops || (run->run_until && !run->run_until->load()); i++) {
+                bench_op_t op = workload_next(&thread->generator);
+                uint64_t op_start_ns = metrics_now_ns();
+                if (!run_op(thread, op))
+                    thread->num_failures++;
+                uint64_t elapsed_ns = metrics_now_ns() - op_start_ns;
+                buckets[t * (BENCH_OP_INSERT + 1) + op.kind][hist_bucket_of(elapsed_ns)]++;
+                max_ns[t] = std::max(max_ns[t], elapsed_ns);
+            }
+            if (thread->strategy)
+                free_buffer_strategy(thread->strategy);
+        });
+    }
+    while (num_warm.load() < run->num_threads)
+        std::this_thread::yield();
+    init_buffer_stat();
+    if (run->on_start)
+        run->on_start();
+    start_ns = metrics_now_ns();
+    is_started = true;
+    for (std::thread &worker : workers)
+        worker.join();
+    result->elapsed_ns = metrics_now_ns() - start_ns;
+    get_buffer_stat_snapshot(result->stat);
+
+    for (uint32_t t = 0; t < run->num_threads; t++) {
+        result->num_ops += num_ops[t];
+        result->num_failures += threads[t].num_failures;
+        result->max_ns = std::max(result->max_ns, max_ns[t]);
+        for (int kind = 0; kind <= BENCH_OP_INSERT; kind++) {
+            for (uint32_t b = 0; b < HIST_NUM_BUCKETS; b++)
+                result->buckets[kind][b] += buckets[t * (BENCH_OP_INSERT + 1) + kind][b];
+        }
+    }
+    return 0;
+}
+
+static void init_run(bench_run_t *run, const char *experiment, bench_workload_kind_t kind,
+                     bench_table_t *table) {
+    run->experiment = experiment;
+    workload_default_config(&run->workload, kind, table->pages.size());
+    run->access = BENCH_ACCESS_GET_BUFFER;
+    run->use_ring = false;
+    run->num_threads = options.num_threads;
+    run->num_ops = options.num_ops;
+    run->table = table;
+    run->scan_table = nullptr;
+    run->swips = nullptr;
+    run->on_start = nullptr;
+    run->run_until = nullptr;
+}
+
+// 열린 pool에서 workload를 한 번 재고 출력
+static int measure(bench_run_t *run, bench_result_t *result, const std::string &extra = "") {
+    if (run_workload(run, result) != 0)
+        return 1;
+    print_result(run, result, extra);
+    return 0;
+}
+
+/**
+ * @brief Run work(t) on num_threads threads at once and time them.
+ *
+ * @return The time from the start of the first thread to the end of the last
+ */
+template <typename Work>
+static uint64_t time_threads(uint32_t num_threads, Work work) {
+    std::atomic<uint32_t> num_ready{0};
+    std::atomic<bool> is_started{false};
+    std::vector<std::thread> workers;
+    for (uint32_t t = 0; t < num_threads; t++) {
+        workers.emplace_back([&, t] {
+            num_ready++;
+            while (!is_started.load())
+                std::this_thread::yield();
+            work(t);
+        });
+    }
+    while (num_ready.load() < num_threads)
+        std::this_thread::yield();
+    uint64_t start_ns = metrics_now_ns();
+    is_started = true;
+    for (std::thread &worker : workers)
+        worker.join();
+    return metrics_now_ns() - start_ns;
+}
+
+// 여러 thread가 나눠 한 num_ops번의 연산 한 번에 걸린 평균 시간 (ns)
+static double ns_per_op(uint64_t elapsed_ns, uint64_t num_ops, uint32_t num_threads) {
+    return num_ops == 0 ? 0 : (double)elapsed_ns * num_threads / num_ops;
+}
+
+static std::string policy_config(buf_policy_kind_t policy) {
+    return std::string("\"policy\":\"") + get_buf_policy(policy)->name + "\"";
+}
+
+//  experiments ----------------------------------------------------------------
+
+/*
+ * Each experiment compares the variants of one feature on the same workload
+ * and prints one line per variant. The pool holds options.num_buf buffers
+ * and the table options.num_pages pages unless an experiment needs the
+ * working set to fit in the pool.
+ */
+
+/*
+ * Partitioned vs single-latch hashtable on a hot set that fits in the pool,
+ * at 1, 2, 4, ... threads up to --threads, and at least up to 4. Scaling only shows when the host
+ * has that many CPUs; every line records the CPU count.
+ */
+static int bench_latch() {
+    const buf_ht_latch_mode_t modes[] = {BUF_HT_PARTITIONED, BUF_HT_SINGLE_LATCH};
+    const char *names[] = {"partitioned", "single"};
+    for (uint32_t num_threads = 1; num_threads <= std::max(options.num_threads, 4u); num_threads *= 2) {
+        for (int m = 0; m < 2; m++) {
+            if (open_pool(options.num_buf, BUF_POLICY_CLOCK, modes[m]) != 0)
+                return 1;
+            bench_table_t table;
+            if (open_table(&table, "hot") != 0)
+                return 1;
+            bench_run_t run;
+            init_run(&run, "latch", BENCH_UNIFORM, &table);
+            run.num_threads = num_threads;
+            run.config = std::string("\"latch\":\"") + names[m] + "\"";
+            bench_result_t result;
+            measure(&run, &result);
+            free_result(&result);
+            close_buffer_pool();
+        }
+    }
+    set_ht_latch_mode(BUF_HT_PARTITIONED);
+    return 0;
+}
+
+// 네 교체 정책을 uniform, zipf, scan+point에서, scan은 따로 둔 큰 table을 읽음
+static int bench_policy() {
+    const bench_workload_kind_t kinds[] = {BENCH_UNIFORM, BENCH_ZIPF, BENCH_SCAN_POINT};
+    for (bench_workload_kind_t kind : kinds) {
+        for (int p = BUF_POLICY_CLOCK; p <= BUF_POLICY_ARC; p++) {
+            if (open_pool(options.num_buf, (buf_policy_kind_t)p) != 0)
+                return 1;
+            bench_table_t table, scan_table;
+            if (open_table(&table, "main") != 0 ||
+                open_table(&scan_table, "scan") != 0)
+                return 1;
+            bench_run_t run;
+            init_run(&run, "policy", kind, &table);
+            run.scan_table = &scan_table;
+            run.workload.scan_num_pages = scan_table.pages.size();
+            run.config = policy_config((buf_policy_kind_t)p);
+            bench_result_t result;
+            run_workload(&run, &result);
+            const buf_table_stat_t *point = &result.stat->tables[table.table_id];
+            char extra[96];
+            snprintf(extra, sizeof(extra), ",\"point_hit_ratio\":%.2f",
+                     point->hits + point->misses == 0 ? 0 : 100.0 * point->hits / (point->hits + point->misses));
+            print_result(&run, &result, extra);
+            free_result(&result);
+            close_buffer_pool();
+        }
+    }
+    return 0;
+}
+
+/*
+ * Records a zipf workload under CLOCK and replays the same access stream
+ * under each policy. This is the trace-driven comparison of the policies:
+ * every policy sees exactly the same pages in the same order.
+ */
+static int bench_replay() {
+    std::string trace_path = std::string(options.dir) + "/policy.trace";
+    if (open_pool(options.num_buf) != 0)
+        return 1;
+    bench_table_t table;
+    if (open_table(&table, "main") != 0)
+        return 1;
+    if (trace_enable(true) != 0) {
+        fprintf(stderr, "replay needs a build with BUF_TRACE\n");
+        close_buffer_pool();
+        return 1;
+    }
+    bench_run_t run;
+    init_run(&run, "replay", BENCH_ZIPF, &table);
+    // 한 thread의 ring이 담을 수 있는 만큼만 기록
+    run.num_ops = std::min<uint64_t>(options.num_ops, TRACE_RING_SIZE / 2);
+    run.num_threads = 1;
+    bench_result_t result;
+    run_workload(&run, &result);
+    free_result(&result);
+    trace_enable(false);
+    int ret = trace_dump(trace_path.c_str());
+    close_buffer_pool();
+    if (ret != 0)
+        return 1;
+
+    for (int p = BUF_POLICY_CLOCK; p <= BUF_POLICY_ARC; p++) {
+        if (open_pool(options.num_buf, (buf_policy_kind_t)p) != 0)
+            return 1;
+        if (open_table(&table, "main") != 0)
+            return 1;
+        trace_replay_stat_t stat;
+        if (trace_replay(trace_path.c_str(), &stat) != 0) {
+            close_buffer_pool();
+            return 1;
+        }
+        buf_stat_snapshot_t *s = new buf_stat_snapshot_t;
+        get_buffer_stat_snapshot(s);
+        printf("{\"experiment\":\"replay\",%s,\"accesses\":%" PRIu64 ",\"failures\":%" PRIu64
+               ",\"accesses_per_sec\":%.0f,\"hit_ratio\":%.2f,\"page_io\":{\"read\":%" PRId64
+               ",\"async_read\":%" PRId64 "},\"latency_ns\":{\"hit_p99\":%" PRIu64
+               ",\"miss_p99\":%" PRIu64 "}}\n",
+               policy_config((buf_policy_kind_t)p).c_str(), stat.num_accesses, stat.num_failures,
+               stat.accesses_per_sec, s->hit_ratio, s->read_pages, s->aio_read_pages,
+               s->latencies[LATENCY_HIT].p99_ns, s->latencies[LATENCY_MISS].p99_ns);
+        fflush(stdout);
+        delete s;
+        close_buffer_pool();
+    }
+    return 0;
+}
+
+// 한 table을 처음부터 끝까지 읽는 시간
+static void time_scan(bench_run_t *run, const char *config) {
+    bench_result_t result;
+    init_result(&result);
+    bench_thread_t thread;
+    thread.run = run;
+    thread.strategy = nullptr;
+    thread.num_failures = 0;
+    run->access = BENCH_ACCESS_GET_BUFFER;
+    run->config = config;
+    run->num_threads = 1;
+    init_buffer_stat();
+    uint64_t start_ns = metrics_now_ns();
+    for (uint64_t first = 0; first < run->table->pages.size(); first += WORKLOAD_SCAN_LENGTH) {
+        uint64_t op_start_ns = metrics_now_ns();
+        uint32_t length = std::min<uint64_t>(WORKLOAD_SCAN_LENGTH, run->table->pages.size() - first);
+        if (!scan_pages(&thread, first, length))
+            thread.num_failures++;
+        uint64_t elapsed_ns = metrics_now_ns() - op_start_ns;
+        result.buckets[BENCH_OP_SCAN][hist_bucket_of(elapsed_ns)]++;
+        result.max_ns = std::max(result.max_ns, elapsed_ns);
+        result.num_ops++;
+    }
+    result.elapsed_ns = metrics_now_ns() - start_ns;
+    result.num_failures = thread.num_failures;
+    get_buffer_stat_snapshot(result.stat);
+    char extra[96];
+    snprintf(extra, sizeof(extra), ",\"pages_per_sec\":%.0f,\"prefetch_hits\":%" PRIu64,
+             run->table->pages.size() * 1e9 / std::max<uint64_t>(result.elapsed_ns, 1),
+             result.stat->counters[METRIC_PREFETCH_HIT]);
+    print_result(run, &result, extra);
+    free_result(&result);
+}
+
+// 비동기 I/O와 동기 경로의 checkpoint 쓰기
+static int bench_aio() {
+    for (int enabled = 1; enabled >= 0; enabled--) {
+        aio_set_enabled(enabled);
+        const char *config = enabled ? "\"io\":\"async\"" : "\"io\":\"sync\"";
+
+        // pool에 다 들어가는 table의 모든 page를 고친 뒤 checkpoint
+        uint64_t num_pages = std::min<uint64_t>(options.num_pages, options.num_buf);
+        if (open_pool(num_pages + 64) != 0)
+            return 1;
+        bench_table_t table;
+        if (open_table(&table, "ckpt") != 0)
+            return 1;
+        for (pagenum_t page_num : table.pages)
+            write_page(&table, page_num);
+        init_buffer_stat();
+        uint64_t start_ns = metrics_now_ns();
+        int ret = checkpoint_buffer_pool(0);
+        uint64_t elapsed_ns = metrics_now_ns() - start_ns;
+        buf_stat_snapshot_t *s = new buf_stat_snapshot_t;
+        get_buffer_stat_snapshot(s);
+        printf("{\"experiment\":\"aio\",%s,\"workload\":\"checkpoint\",\"ret\":%d,\"pages\":%" PRIu64
+               ",\"elapsed_ns\":%" PRIu64 ",\"pages_per_sec\":%.0f,\"page_io\":{\"write\":%" PRId64
+               ",\"async_write\":%" PRId64 "}}\n", config, ret, num_pages, elapsed_ns,
+               num_pages * 1e9 / std::max<uint64_t>(elapsed_ns, 1), s->write_pages, s->aio_write_pages);
+        fflush(stdout);
+        delete s;
+        close_buffer_pool();
+    }
+    aio_set_enabled(true);
+    return 0;
+}
+
+/*
+ * Sequential scans with read-ahead off and on, first with the table in the
+ * OS page cache and then with it dropped from there before each scan, so
+ * each read goes to the disk. A uniform workload, whose misses never form a
+ * run, shows what the trigger costs when it does not fire.
+ */
+static int bench_readahead() {
+    for (int is_cold = 0; is_cold <= 1; is_cold++) {
+        for (int on = 0; on <= 1; on++) {
+            if (open_pool(options.num_buf) != 0)
+                return 1;
+            bench_table_t table;
+            if (open_table(&table, "main") != 0)
+                return 1;
+            if (!on)
+                set_readahead_window(0);
+            if (is_cold)
+                drop_page_cache("main");
+            bench_run_t run;
+            init_run(&run, "readahead", BENCH_SCAN_POINT, &table);
+            std::string config = std::string("\"readahead\":\"") + (on ? "on" : "off") +
+                                 "\",\"page_cache\":\"" + (is_cold ? "cold" : "warm") + "\"";
+            time_scan(&run, config.c_str());
+            close_buffer_pool();
+        }
+    }
+    for (int on = 0; on <= 1; on++) {
+        if (open_pool(options.num_buf) != 0)
+            return 1;
+        bench_table_t table;
+        if (open_table(&table, "main") != 0)
+            return 1;
+        if (!on)
+            set_readahead_window(0);
+        bench_run_t run;
+        init_run(&run, "readahead", BENCH_UNIFORM, &table);
+        run.config = on ? "\"readahead\":\"on\"" : "\"readahead\":\"off\"";
+        bench_result_t result;
+        measure(&run, &result);
+        free_result(&result);
+        close_buffer_pool();
+    }
+    return 0;
+}
+
+// scan을 공유 pool로 읽을 때와 BULK_READ ring으로 읽을 때의 point lookup hit ratio
+static int bench_ring() {
+    for (int use_ring = 0; use_ring <= 1; use_ring++) {
+        if (open_pool(options.num_buf) != 0)
+            return 1;
+        bench_table_t table, scan_table;
+        if (open_table(&table, "hot") != 0 ||
+            open_table(&scan_table, "scan") != 0)
+            return 1;
+        bench_run_t run;
+        init_run(&run, "ring", BENCH_SCAN_POINT, &table);
+        run.scan_table = &scan_table;
+        run.workload.scan_num_pages = scan_table.pages.size();
+        run.workload.scan_percent = 20;
+        run.use_ring = use_ring;
+        run.config = use_ring ? "\"scan\":\"ring\"" : "\"scan\":\"shared\"";
+        bench_result_t result;
+        run_workload(&run, &result);
+        const buf_table_stat_t *point = &result.stat->tables[table.table_id];
+        char extra[96];
+        snprintf(extra, sizeof(extra), ",\"point_hit_ratio\":%.2f",
+                 100.0 * point->hits / std::max<uint64_t>(point->hits + point->misses, 1));
+        print_result(&run, &result, extra);
+        free_result(&result);
+        close_buffer_pool();
+    }
+    return 0;
+}
+
+// hot table과 큰 scan table, 정책마다 scan table에 hard quota를 둘 때와 두지 않을 때
+static int bench_quota() {
+    for (int p = BUF_POLICY_CLOCK; p <= BUF_POLICY_ARC; p++) {
+        for (int has_quota = 0; has_quota <= 1; has_quota++) {
+            if (open_pool(options.num_buf, (buf_policy_kind_t)p) != 0)
+                return 1;
+            bench_table_t table, scan_table;
+            if (open_table(&table, "hot") != 0 ||
+                open_table(&scan_table, "scan") != 0)
+                return 1;
+            if (has_quota)
+                set_table_quota(scan_table.table_id, options.num_buf / 8, options.num_buf / 4);
+            bench_run_t run;
+            init_run(&run, "quota", BENCH_SCAN_POINT, &table);
+            run.scan_table = &scan_table;
+            run.workload.scan_num_pages = scan_table.pages.size();
+            run.workload.scan_percent = 20;
+            run.config = policy_config((buf_policy_kind_t)p) +
+                         (has_quota ? ",\"scan_quota\":\"num_buf/4\"" : ",\"scan_quota\":\"none\"");
+            bench_result_t result;
+            run_workload(&run, &result);
+            const buf_table_stat_t *point = &result.stat->tables[table.table_id];
+            char extra[96];
+            snprintf(extra, sizeof(extra), ",\"point_hit_ratio\":%.2f",
+                     100.0 * point->hits / std::max<uint64_t>(point->hits + point->misses, 1));
+            print_result(&run, &result, extra);
+            free_result(&result);
+            close_buffer_pool();
+        }
+    }
+    return 0;
+}
+
+/*
+ * Zipf with half writes, with the background writer off and on. Without it
+ * about half the victims are dirty and get_buffer() writes them itself. The
+ * writer gets a quarter of the pool per 1 ms round, enough to stay ahead of
+ * the clock hand at the miss rate of this workload, so the victims it leaves
+ * are clean. dirty_victim_percent is the share of misses that had to write
+ * their victim in the foreground.
+ */
+static int bench_bg_writer() {
+    for (int on = 0; on <= 1; on++) {
+        if (open_pool(options.num_buf) != 0)
+            return 1;
+        bench_table_t table;
+        if (open_table(&table, "main") != 0)
+            return 1;
+        if (on)
+            start_bg_writer(std::max<uint32_t>(1, options.num_buf / 4), 1);
+        bench_run_t run;
+        init_run(&run, "bg_writer", BENCH_ZIPF, &table);
+        run.workload.write_percent = 50;
+        run.config = on ? "\"bg_writer\":\"on\"" : "\"bg_writer\":\"off\"";
+        bench_result_t result;
+        run_workload(&run, &result);
+        stop_bg_writer();
+        const buf_stat_snapshot_t *s = result.stat;
+        char extra[64];
+        snprintf(extra, sizeof(extra), ",\"dirty_victim_percent\":%.2f",
+                 100.0 * s->counters[METRIC_FG_WRITE] / std::max<uint64_t>(s->counters[METRIC_MISS], 1));
+        print_result(&run, &result, extra);
+        free_result(&result);
+        close_buffer_pool();
+    }
+    return 0;
+}
+
+/*
+ * One checkpoint during a zipf workload with 50% writes, at full speed and
+ * with its writes spread over a second. The checkpoint starts once the
+ * workload is warm and the counters are reset, and the workload runs until
+ * it is done, so the whole checkpoint is measured against the workload.
+ * A checkpoint that wrote no pages fails the experiment.
+ */
+static int bench_checkpoint() {
+    const uint32_t durations[] = {0, 1000};
+    for (uint32_t duration_ms : durations) {
+        if (open_pool(options.num_buf) != 0)
+            return 1;
+        bench_table_t table;
+        if (open_table(&table, "ckpt") != 0)
+            return 1;
+        std::atomic<bool> is_done{false};
+        int ret = 0;
+        uint64_t checkpoint_ns = 0;
+        std::thread checkpointer;
+        bench_run_t run;
+        init_run(&run, "checkpoint", BENCH_ZIPF, &table);
+        run.workload.write_percent = 50;
+        run.config = "\"checkpoint_duration_ms\":" + std::to_string(duration_ms);
+        run.on_start = [&] {
+            checkpointer = std::thread([&] {
+                uint64_t start_ns = metrics_now_ns();
+                ret = checkpoint_buffer_pool(duration_ms);
+                checkpoint_ns = metrics_now_ns() - start_ns;
+                is_done = true;
+            });
+        };
+        run.run_until = &is_done;
+        bench_result_t result;
+        run_workload(&run, &result);
+        checkpointer.join();
+        uint64_t num_writes = result.stat->counters[METRIC_CHECKPOINT_WRITE];
+        char extra[96];
+        snprintf(extra, sizeof(extra), ",\"checkpoint_ret\":%d,\"checkpoint_ms\":%.1f", ret,
+                 checkpoint_ns / 1e6);
+        print_result(&run, &result, extra);
+        free_result(&result);
+        close_buffer_pool();
+        if (ret != 0 || num_writes == 0) {
+            fprintf(stderr, "the checkpoint returned %d and wrote %" PRIu64 " pages\n", ret,
+                    num_writes);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Working sets of 2, 3 and 4 times the pool, without and with a compressed
+ * cache of half the pool's memory. The table's pages are half random bytes,
+ * so they compress to about half their size, where the nearly empty pages of
+ * the other tables would compress to almost nothing. The table stays in the
+ * OS page cache, so a miss read from the file costs a copy from there, not a
+ * disk read; miss_ns and zcache_miss_ns are get_buffer() misses read from
+ * the file and decompressed from the cache.
+ *
+ * effective_capacity is the share of accesses found in the pool or the cache
+ * times the working set, over num_buf: the pool's own capacity is 1. Under
+ * uniform access every page is equally likely, so this is the number of
+ * pages the pool and the cache hold together; under zipf it only shows how
+ * much of the skewed workload they serve.
+ */
+static int bench_zcache() {
+    uint32_t max_multiple = 4;
+    if (fill_table("zcache", (uint64_t)max_multiple * options.num_buf, PAGE_SIZE, PAGE_SIZE / 2))
+        return 1;
+    const bench_workload_kind_t kinds[] = {BENCH_UNIFORM, BENCH_ZIPF};
+    for (bench_workload_kind_t kind : kinds) {
+        for (uint32_t multiple = 2; multiple <= max_multiple; multiple++) {
+            for (int on = 0; on <= 1; on++) {
+                if (open_pool(options.num_buf) != 0)
+                    return 1;
+                size_t budget_bytes = on ? (size_t)options.num_buf * PAGE_SIZE / 2 : 0;
+                if (on && zcache_open(budget_bytes) != 0)
+                    return 1;
+                bench_table_t table;
+                if (open_table(&table, "zcache") != 0)
+                    return 1;
+                bench_run_t run;
+                init_run(&run, "zcache", kind, &table);
+                run.workload.num_pages = (uint64_t)multiple * options.num_buf;
+                run.config = std::string(on ? "\"zcache\":\"num_buf/2\"" : "\"zcache\":\"off\"") +
+                             ",\"working_set\":\"" + std::to_string(multiple) + "x\"";
+                bench_result_t result;
+                run_workload(&run, &result);
+                const buf_stat_snapshot_t *s = result.stat;
+                const buf_histogram_t *miss = &s->latencies[LATENCY_MISS];
+                const buf_histogram_t *zcache_miss = &s->latencies[LATENCY_ZCACHE_MISS];
+                double found = (double)(s->hits + s->counters[METRIC_ZCACHE_HIT]) /
+                               std::max<uint64_t>(s->accesses, 1);
+                char extra[512];
+                snprintf(extra, sizeof(extra), ",\"memory_bytes\":%zu,\"zcache_hit_ratio\":%.2f,"
+                         "\"compression_ratio\":%.2f,\"zcache_pages\":%" PRIu64
+                         ",\"effective_capacity\":%.2f,\"miss_ns\":{\"count\":%" PRIu64
+                         ",\"mean\":%.0f,\"p50\":%" PRIu64 ",\"p99\":%" PRIu64 "},"
+                         "\"zcache_miss_ns\":{\"count\":%" PRIu64 ",\"mean\":%.0f,\"p50\":%" PRIu64
+                         ",\"p99\":%" PRIu64 "}",
+                         (size_t)options.num_buf * PAGE_SIZE + budget_bytes, s->zcache_hit_ratio,
+                         s->compression_ratio, s->zcache.num_pages,
+                         found * run.workload.num_pages / options.num_buf, miss->count,
+                         (double)miss->sum_ns / std::max<uint64_t>(miss->count, 1), miss->p50_ns,
+                         miss->p99_ns, zcache_miss->count,
+                         (double)zcache_miss->sum_ns / std::max<uint64_t>(zcache_miss->count, 1),
+                         zcache_miss->p50_ns, zcache_miss->p99_ns);
+                print_result(&run, &result, extra);
+                free_result(&result);
+                close_buffer_pool();
+            }
+        }
+    }
+    return 0;
+}
+
+// ht_lookup이 찾는 page 하나
+typedef struct bench_ht_key_t {
+    int64_t table_id;
+    pagenum_t page_num;
+} bench_ht_key_t;
+
+// ht_lookup의 key 집합, table마다 page를 page_span 안에서 고름
+typedef struct bench_ht_key_set_t {
+    const char *name;
+    uint32_t num_tables;
+    uint64_t page_span;
+    bool is_random;
+} bench_ht_key_set_t;
+
+// keys를 모두 찾는 데 걸린 lookup 하나의 평균 시간 (ns), 찾은 수는 num_found에
+template <typename Lookup>
+static double time_lookups(const std::vector<bench_ht_key_t> &keys, uint64_t *num_found,
+                           Lookup lookup) {
+    uint64_t found = 0;
+    uint64_t start_ns = metrics_now_ns();
+    for (const bench_ht_key_t &key : keys)
+        found += lookup(key.table_id, key.page_num);
+    uint64_t elapsed_ns = metrics_now_ns() - start_ns;
+    *num_found = found;
+    return keys.empty() ? 0 : (double)elapsed_ns / keys.size();
+}
+
+// key 집합의 page 하나, page 0(header)은 고르지 않음
+static bench_ht_key_t next_ht_key(const bench_ht_key_set_t *key_set, const int64_t *table_ids,
+                                  uint64_t i, std::mt19937_64 *rng) {
+    uint32_t t = i % key_set->num_tables;
+    pagenum_t page_num = key_set->is_random ? 1 + (*rng)() % key_set->page_span
+                                            : 1 + (i / key_set->num_tables) % key_set->page_span;
+    return {table_ids[t], page_num};
+}
+
+/*
+ * Lookup cost of the Robin Hood hashtable at load factors of 50 to 95%,
+ * against the chained hashtable it replaced with as many buckets. The pool
+ * has a single partition, so the load is exact, and is filled with as many
+ * pages as it has buffers. Lookups of resident and of absent pages are timed
+ * separately, each under the partition latch.
+ *
+ * Each load runs three key sets: sequential page numbers of one table,
+ * random page numbers of one table, and random page numbers of several
+ * tables of a million pages each. The chained table's hash is
+ * (table_id * 100000 + page_num) % buckets, which never collides on the
+ * first set but does on the others. The tables are empty files, which the
+ * bench file layer reads as zeroed pages. Every line reports the mean and
+ * maximum number of slots or chain nodes a hit looks at.
+ */
+static int bench_ht_lookup() {
+    const uint32_t loads[] = {50, 70, 80, 90, 95};
+    const bench_ht_key_set_t key_sets[] = {
+        {"sequential", 1, UINT64_MAX, false},
+        {"random", 1, 1ULL << 30, true},
+        {"tables", 8, 1000000, true},
+    };
+    uint32_t num_slots = 1;
+    while (num_slots * 4 <= options.num_pages)
+        num_slots *= 2;
+    for (const bench_ht_key_set_t &key_set : key_sets) {
+        for (uint32_t load : loads) {
+            uint32_t num_buf = (uint64_t)num_slots * load / 100;
+            set_ht_latch_mode(BUF_HT_SINGLE_LATCH);
+            if (init_buffer_pool(num_slots, num_buf) != 0)
+                return 1;
+            // 고른 page만 hashtable에 들어가도록 read-ahead는 끔
+            set_readahead_window(0);
+            int64_t table_ids[8];
+            for (uint32_t t = 0; t < key_set.num_tables; t++) {
+                std::string pathname = table_path(("ht" + std::to_string(t)).c_str());
+                unlink(pathname.c_str());
+                table_ids[t] = buffer_open_table(pathname.c_str());
+                if (table_ids[t] < 0)
+                    return 1;
+            }
+
+            // 서로 다른 page num_buf개를 올림, 있는 page는 올린 page 중에서 고르고
+            // 없는 page는 같은 분포에서 이어서 고름
+            std::mt19937_64 rng(load);
+            std::vector<bench_ht_key_t> loaded_keys, hit_keys, miss_keys;
+            uint64_t i = 0;
+            while (loaded_keys.size() < num_buf) {
+                bench_ht_key_t key = next_ht_key(&key_set, table_ids, i++, &rng);
+                if (is_buffer_resident(key.table_id, key.page_num))
+                    continue;
+                buf_descriptor_t *buf_desc = get_buffer(key.table_id, key.page_num);
+                if (buf_desc == nullptr)
+                    return 1;
+                unpin_buffer(buf_desc);
+                loaded_keys.push_back(key);
+            }
+            uint32_t num_used = buffer_pool.hashtable.partitions[0].num_used;
+            while (hit_keys.size() < options.num_ops / 2)
+                hit_keys.push_back(loaded_keys[rng() % loaded_keys.size()]);
+            while (miss_keys.size() < options.num_ops / 2) {
+                bench_ht_key_t key = next_ht_key(&key_set, table_ids, i++, &rng);
+                if (!is_buffer_resident(key.table_id, key.page_num))
+                    miss_keys.push_back(key);
+            }
+
+            // 같은 descriptor들로 chained hashtable을 만듦
+            baseline_hashtable_t baseline;
+            baseline_init_hashtable(&baseline, num_slots, 1);
+            for (uint32_t b = 0; b < buffer_pool.num_buf; b++) {
+                if (buffer_pool.buf_descriptors[b].table_id >= 0)
+                    baseline_hashtable_insert(&baseline, &buffer_pool.buf_descriptors[b]);
+            }
+
+            // hit이 보는 slot 수: Robin Hood는 entry의 probe_len, chained는 chain 안의 위치
+            uint64_t probe_sums[2] = {0, 0}, probe_maxes[2] = {0, 0};
+            ht_slots_t *ht_slots = buffer_pool.hashtable.partitions[0].slots.load();
+            for (uint32_t s = 0; s < ht_slots->num_slots; s++) {
+                uint32_t probe_len = ht_slots->entries[s].probe_len;
+                probe_sums[0] += probe_len;
+                probe_maxes[0] = std::max<uint64_t>(probe_maxes[0], probe_len);
+            }
+            for (uint32_t b = 0; b < baseline.num_ht_entries; b++) {
+                uint64_t position = 0;
+                for (baseline_ht_entry_t *ht_entry = &baseline.ht_entries[b]; ht_entry;
+                     ht_entry = ht_entry->next) {
+                    if (ht_entry->buf_desc == nullptr)
+                        continue;
+                    position++;
+                    probe_sums[1] += position;
+                    probe_maxes[1] = std::max(probe_maxes[1], position);
+                }
+            }
+
+            uint64_t found[4];
+            double ns[4] = {
+                time_lookups(hit_keys, &found[0], is_buffer_resident),
+                time_lookups(miss_keys, &found[1], is_buffer_resident),
+                time_lookups(hit_keys, &found[2], [&](int64_t t, pagenum_t p) {
+                    return baseline_is_resident(&baseline, t, p);
+                }),
+                time_lookups(miss_keys, &found[3], [&](int64_t t, pagenum_t p) {
+                    return baseline_is_resident(&baseline, t, p);
+                }),
+            };
+            uint64_t num_failures = (hit_keys.size() - found[0]) + found[1] +
+                                    (hit_keys.size() - found[2]) + found[3];
+            for (int is_baseline = 0; is_baseline <= 1; is_baseline++) {
+                printf("{\"experiment\":\"ht_lookup\",\"hashtable\":\"%s\",\"keys\":\"%s\","
+                       "\"tables\":%u,\"slots\":%u,\"entries\":%u,\"load_percent\":%.1f,"
+                       "\"hit_lookups\":%zu,\"miss_lookups\":%zu,\"failures\":%" PRIu64
+                       ",\"hit_ns\":%.1f,\"miss_ns\":%.1f,\"hit_probe\":{\"mean\":%.2f,"
+                       "\"max\":%" PRIu64 "}}\n", is_baseline ? "chained" : "robin_hood",
+                       key_set.name, key_set.num_tables, num_slots, num_used,
+                       100.0 * num_used / num_slots, hit_keys.size(), miss_keys.size(),
+                       num_failures, ns[2 * is_baseline], ns[2 * is_baseline + 1],
+                       (double)probe_sums[is_baseline] / std::max<uint32_t>(num_used, 1),
+                       probe_maxes[is_baseline]);
+            }
+            fflush(stdout);
+            baseline_free_hashtable(&baseline);
+            close_buffer_pool();
+            if (num_failures != 0)
+                return 1;
+        }
+    }
+    set_ht_latch_mode(BUF_HT_PARTITIONED);
+    return 0;
+}
+
+/*
+ * Pops a buffer from the freelist and pushes it back, with the lock-free
+ * intrusive stack of the pool and with the mutex-protected list of heap
+ * nodes it replaced, at 1, 2, 4, ... threads.
+ */
+static int bench_freelist() {
+    for (uint32_t num_threads = 1; num_threads <= std::max(options.num_threads, 4u); num_threads *= 2) {
+        if (open_pool(options.num_buf) != 0)
+            return 1;
+        baseline_freelist_t baseline;
+        baseline_init_freelist(&baseline);
+        for (uint32_t i = 0; i < options.num_buf; i++)
+            baseline_add_to_freelist(&baseline, &buffer_pool.buf_descriptors[i]);
+
+        for (int is_baseline = 0; is_baseline <= 1; is_baseline++) {
+            std::atomic<uint64_t> num_empty{0};
+            uint64_t elapsed_ns = time_threads(num_threads, [&](uint32_t) {
+                for (uint64_t i = 0; i < options.num_ops; i++) {
+                    buf_descriptor_t *buf_desc = is_baseline ?
+                        baseline_get_from_freelist(&baseline) : get_from_freelist(0);
+                    if (buf_desc == nullptr) {
+                        num_empty++;
+                        continue;
+                    }
+                    if (is_baseline)
+                        baseline_add_to_freelist(&baseline, buf_desc);
+                    else
+                        add_to_freelist(buf_desc);
+                }
+            });
+            uint64_t num_ops = options.num_ops * num_threads;
+            printf("{\"experiment\":\"freelist\",\"freelist\":\"%s\",\"threads\":%u,"
+                   "\"cpus\":%u,\"pop_push_pairs\":%" PRIu64 ",\"failures\":%" PRIu64
+                   ",\"ns_per_pair\":%.1f,\"pairs_per_sec\":%.0f}\n",
+                   is_baseline ? "mutex_heap_list" : "lock_free_stack", num_threads,
+                   std::thread::hardware_concurrency(), num_ops, num_empty.load(),
+                   ns_per_op(elapsed_ns, num_ops, num_threads),
+                   num_ops * 1e9 / std::max<uint64_t>(elapsed_ns, 1));
+            fflush(stdout);
+        }
+        baseline_free_freelist(&baseline);
+        close_buffer_pool();
+    }
+    return 0;
+}
+
+// pool에 다 들어가는 zipf read를 latch, 낙관적 읽기, swip으로
+static int bench_access() {
+    const bench_access_t accesses[] = {BENCH_ACCESS_GET_BUFFER, BENCH_ACCESS_OPTIMISTIC, BENCH_ACCESS_SWIP};
+    const char *names[] = {"latched", "optimistic", "swip"};
+    for (int a = 0; a < 3; a++) {
+        if (open_pool(options.num_buf) != 0)
+            return 1;
+        bench_table_t table;
+        if (open_table(&table, "hot") != 0)
+            return 1;
+        std::vector<buf_swip_t> swips(table.pages.size());
+        for (size_t i = 0; i < swips.size(); i++)
+            init_swip(&swips[i], table.table_id, table.pages[i]);
+        bench_run_t run;
+        init_run(&run, "access", BENCH_ZIPF, &table);
+        run.access = accesses[a];
+        run.swips = swips.data();
+        run.config = std::string("\"access\":\"") + names[a] + "\"";
+        bench_result_t result;
+        run_workload(&run, &result);
+        char extra[128];
+        snprintf(extra, sizeof(extra), ",\"optimistic_reads\":%" PRIu64 ",\"swip_hits\":%" PRIu64,
+                 result.stat->counters[METRIC_OPTIMISTIC_READ], result.stat->counters[METRIC_SWIP_HIT]);
+        print_result(&run, &result, extra);
+        free_result(&result);
+        close_buffer_pool();
+    }
+    return 0;
+}
+
+// 열린 pool에서 warm-up 없이 한 thread로 run->num_ops개의 op를 재고 출력
+static void measure_first_ops(bench_run_t *run, const std::string &extra) {
+    bench_result_t first;
+    init_result(&first);
+    bench_thread_t thread;
+    thread.run = run;
+    thread.strategy = nullptr;
+    thread.num_failures = 0;
+    workload_init_generator(&thread.generator, &run->workload, 0xfeed);
+    init_buffer_stat();
+    uint64_t start_ns = metrics_now_ns();
+    for (uint64_t i = 0; i < run->num_ops; i++) {
+        bench_op_t op = workload_next(&thread.generator);
+        uint64_t op_start_ns = metrics_now_ns();
+        if (!run_op(&thread, op))
+            thread.num_failures++;
+        uint64_t elapsed_ns = metrics_now_ns() - op_start_ns;
+        first.buckets[op.kind][hist_bucket_of(elapsed_ns)]++;
+        first.max_ns = std::max(first.max_ns, elapsed_ns);
+    }
+    first.elapsed_ns = metrics_now_ns() - start_ns;
+    first.num_ops = run->num_ops;
+    first.num_failures = thread.num_failures;
+    run->num_threads = 1;
+    get_buffer_stat_snapshot(first.stat);
+    print_result(run, &first, extra);
+    free_result(&first);
+}
+
+/*
+ * Restarts the pool after a zipf workload, once empty and once with the pages
+ * of a warm dump loaded, and measures the first num_ops / 10 operations.
+ */
+static int bench_warm() {
+    std::string dump_path = std::string(options.dir) + "/warm.dump";
+    if (open_pool(options.num_buf) != 0)
+        return 1;
+    bench_table_t table;
+    if (open_table(&table, "main") != 0)
+        return 1;
+    bench_run_t run;
+    init_run(&run, "warm", BENCH_ZIPF, &table);
+    bench_result_t result;
+    run_workload(&run, &result);
+    free_result(&result);
+    int ret = warm_dump(dump_path.c_str());
+    close_buffer_pool();
+    if (ret != 0)
+        return 1;
+
+    for (int is_warm = 0; is_warm <= 1; is_warm++) {
+        if (open_pool(options.num_buf) != 0 || open_table(&table, "main") != 0)
+            return 1;
+        int64_t num_loaded = is_warm ? warm_load(dump_path.c_str()) : 0;
+        init_run(&run, "warm", BENCH_ZIPF, &table);
+        // 다시 시작한 직후만 보므로 warm-up 없이 잼
+        run.num_ops = std::max<uint64_t>(options.num_ops / 10, 1);
+        run.config = is_warm ? "\"restart\":\"warm\"" : "\"restart\":\"cold\"";
+        measure_first_ops(&run, ",\"loaded\":" + std::to_string(num_loaded));
+        close_buffer_pool();
+    }
+    return 0;
+}
+
+/*
+ * Hashtable lookups (is_buffer_resident() of uniformly chosen pages) on one
+ * thread while another thread does nothing, resizes the hashtable back and
+ * forth between 2x and 8x the pool's buffers, or resizes the pool between
+ * the main table's size and twice that, for a second each. The pool starts
+ * with the whole main table in it, so a shrink drains every removed buffer.
+ * On a host with fewer CPUs than threads the lookups also wait for the CPU.
+ */
+static int bench_resize_latency() {
+    uint32_t num_buf = options.num_pages + 64;
+    if (open_pool(num_buf) != 0)
+        return 1;
+    bench_table_t table;
+    if (open_table(&table, "main") != 0)
+        return 1;
+    for (pagenum_t page_num : table.pages) {
+        buf_descriptor_t *buf_desc = get_buffer(table.table_id, page_num);
+        if (buf_desc != nullptr)
+            unpin_buffer(buf_desc);
+    }
+
+    const char *phases[] = {"none", "hashtable", "pool"};
+    for (int phase = 0; phase < 3; phase++) {
+        std::atomic<bool> is_done{false};
+        std::vector<uint64_t> buckets(HIST_NUM_BUCKETS, 0);
+        uint64_t num_lookups = 0, max_ns = 0;
+        std::thread reader([&] {
+            std::mt19937_64 rng(phase);
+            while (!is_done.load(std::memory_order_relaxed)) {
+                pagenum_t page_num = table.pages[rng() % table.pages.size()];
+                uint64_t start_ns = metrics_now_ns();
+                is_buffer_resident(table.table_id, page_num);
+                uint64_t elapsed_ns = metrics_now_ns() - start_ns;
+                buckets[hist_bucket_of(elapsed_ns)]++;
+                max_ns = std::max(max_ns, elapsed_ns);
+                num_lookups++;
+            }
+        });
+        uint64_t start_ns = metrics_now_ns();
+        uint64_t end_ns = start_ns + 1000000000ULL;
+        uint32_t num_resizes = 0, num_failed = 0;
+        uint64_t resize_ns = 0, max_resize_ns = 0;
+        if (phase == 0)
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+        while (phase > 0 && metrics_now_ns() < end_ns) {
+            bool is_grow = num_resizes % 2 == 0;
+            uint64_t resize_start_ns = metrics_now_ns();
+            int ret = phase == 1 ? resize_hashtable((is_grow ? 8 : 2) * num_buf) :
+                                   resize_buffer_pool((is_grow ? 2 : 1) * num_buf);
+            uint64_t elapsed_ns = metrics_now_ns() - resize_start_ns;
+            num_failed += ret != 0;
+            num_resizes++;
+            resize_ns += elapsed_ns;
+            max_resize_ns = std::max(max_resize_ns, elapsed_ns);
+        }
+        uint64_t elapsed_ns = metrics_now_ns() - start_ns;
+        is_done = true;
+        reader.join();
+        std::string latency = latency_json(buckets);
+        latency.insert(latency.size() - 1, ",\"max\":" + std::to_string(max_ns));
+        printf("{\"experiment\":\"resize\",\"resize\":\"%s\",\"num_buf\":%u,\"cpus\":%u,"
+               "\"resizes\":%u,\"failed_resizes\":%u,\"resize_ms\":{\"mean\":%.2f,\"max\":%.2f},"
+               "\"lookups\":%" PRIu64 ",\"lookups_per_sec\":%.0f,\"lookup_latency_ns\":%s}\n",
+               phases[phase], num_buf, std::thread::hardware_concurrency(), num_resizes, num_failed,
+               num_resizes ? resize_ns / 1e6 / num_resizes : 0, max_resize_ns / 1e6, num_lookups,
+               num_lookups * 1e9 / std::max<uint64_t>(elapsed_ns, 1), latency.c_str());
+        fflush(stdout);
+        if (num_failed != 0) {
+            close_buffer_pool();
+            return 1;
+        }
+    }
+    close_buffer_pool();
+    return 0;
+}
+
+/*
+ * The hit ratio of the first num_ops / 10 zipf operations after the pool of
+ * num_buf buffers, warm from a zipf workload, is grown to twice or shrunk to
+ * half that size: online with resize_buffer_pool(), or by closing it and
+ * opening an empty pool of the new size. "steady" is the hit ratio of a pool
+ * of the new size after a full warm-up, the most a resize could keep.
+ */
+static int bench_resize_retention() {
+    const uint32_t targets[] = {2 * options.num_buf, options.num_buf / 2};
+    const char *modes[] = {"online", "restart", "steady"};
+    for (uint32_t target : targets) {
+        for (int mode = 0; mode < 3; mode++) {
+            bench_table_t table;
+            if (open_pool(mode == 2 ? target : options.num_buf) != 0 || open_table(&table, "main") != 0)
+                return 1;
+            bench_run_t run;
+            init_run(&run, "resize", BENCH_ZIPF, &table);
+            run.num_threads = 1;
+            bench_result_t result;
+            run_workload(&run, &result);
+            if (mode == 2) {
+                run.config = std::string("\"resize\":\"steady\",\"target_num_buf\":") + std::to_string(target);
+                print_result(&run, &result, "");
+                free_result(&result);
+                close_buffer_pool();
+                continue;
+            }
+            free_result(&result);
+            if (mode == 0 && resize_buffer_pool(target) != 0) {
+                close_buffer_pool();
+                return 1;
+            }
+            if (mode == 1) {
+                close_buffer_pool();
+                if (open_pool(target) != 0 || open_table(&table, "main") != 0)
+                    return 1;
+            }
+            init_run(&run, "resize", BENCH_ZIPF, &table);
+            run.num_ops = std::max<uint64_t>(options.num_ops / 10, 1);
+            run.config = std::string("\"resize\":\"") + modes[mode] + "\",\"target_num_buf\":" +
+                         std::to_string(target);
+            measure_first_ops(&run, "");
+            close_buffer_pool();
+        }
+    }
+    return 0;
+}
+
+static int bench_resize() {
+    return bench_resize_latency() || bench_resize_retention();
+}
+
+/*
+ * Hit cost with tracing compiled in, off and on. A build without BUF_TRACE
+ * (buffer_bench_notrace) runs it once with tracing compiled out, the
+ * baseline for the cost of the disabled trace_event() checks.
+ */
+static int bench_trace() {
+#ifdef BUF_TRACE
+    const int last = 1;
+#else
+    const int last = 0;
+#endif
+    for (int on = 0; on <= last; on++) {
+        if (open_pool(options.num_buf) != 0)
+            return 1;
+        bench_table_t table;
+        if (open_table(&table, "hot") != 0)
+            return 1;
+        if (on && trace_enable(true) != 0) {
+            close_buffer_pool();
+            fprintf(stderr, "trace needs a build with BUF_TRACE\n");
+            return 1;
+        }
+        bench_run_t run;
+        init_run(&run, "trace", BENCH_ZIPF, &table);
+#ifdef BUF_TRACE
+        run.config = on ? "\"trace\":\"on\"" : "\"trace\":\"off\"";
+#else
+        run.config = "\"trace\":\"compiled_out\"";
+#endif
+        bench_result_t result;
+        measure(&run, &result);
+        free_result(&result);
+        trace_enable(false);
+        close_buffer_pool();
+    }
+    return 0;
+}
+
+// table의 모든 page를 고쳐 dirty로 만듦
+static bool dirty_pages(const bench_table_t *table) {
+    for (pagenum_t page_num : table->pages) {
+        buf_descriptor_t *buf_desc = get_buffer(table->table_id, page_num, BUF_LATCH_EXCLUSIVE);
+        if (buf_desc == nullptr)
+            return false;
+        uint64_t counter;
+        memcpy(&counter, buf_desc->buf_page->data + BENCH_COUNTER_OFFSET, sizeof(counter));
+        counter++;
+        memcpy(buf_desc->buf_page->data + BENCH_COUNTER_OFFSET, &counter, sizeof(counter));
+        log_buffer_update(buf_desc, BENCH_COUNTER_OFFSET, sizeof(counter));
+        release_buffer(buf_desc, BUF_LATCH_EXCLUSIVE);
+    }
+    return true;
+}
+
+/*
+ * Checkpoint of a pool holding --dirty-pages dirty pages (1M by default, 4GB
+ * of frames), while a reader thread keeps reading the hot table. The reader
+ * is first timed for a second without a checkpoint, then during a checkpoint
+ * at full speed and during one spread over twice the time the full-speed one
+ * took. The pool needs memory for every frame and the table as much disk.
+ */
+static int bench_checkpoint_large() {
+    std::string pathname = table_path("dirty");
+    unlink(pathname.c_str());
+    bench_table_t hot;
+    set_ht_latch_mode(BUF_HT_PARTITIONED);
+    uint64_t num_buf = options.num_dirty_pages + options.num_buf + 64;
+    if (num_buf > UINT32_MAX / 2 || init_buffer_pool(2 * num_buf, num_buf) != 0)
+        return 1;
+    if (open_table(&hot, "hot") != 0)
+        return 1;
+    bench_table_t table;
+    table.pathname = pathname;
+    table.table_id = buffer_open_table(pathname.c_str());
+    if (table.table_id < 0)
+        return 1;
+    for (uint64_t i = 0; i < options.num_dirty_pages; i++) {
+        buf_descriptor_t *buf_desc = get_buffer_of_new_page(table.table_id);
+        if (buf_desc == nullptr)
+            return 1;
+        latch_buffer(buf_desc, BUF_LATCH_EXCLUSIVE);
+        memcpy(buf_desc->buf_page->data + BENCH_MARK_OFFSET, &buf_desc->page_num, sizeof(pagenum_t));
+        log_buffer_update(buf_desc, BENCH_MARK_OFFSET, sizeof(pagenum_t));
+        table.pages.push_back(buf_desc->page_num);
+        release_buffer(buf_desc, BUF_LATCH_EXCLUSIVE);
+    }
+
+    uint32_t full_speed_ms = 0;
+    for (int round = 0; round < 3; round++) {
+        if (round == 2 && !dirty_pages(&table))
+            return 1;
+        uint32_t duration_ms = round == 2 ? std::max<uint32_t>(1, 2 * full_speed_ms) : 0;
+        std::atomic<bool> is_done{false};
+        std::vector<uint64_t> buckets(HIST_NUM_BUCKETS, 0);
+        uint64_t num_reads = 0, num_failures = 0;
+        std::thread reader([&] {
+            std::mt19937_64 rng(round);
+            while (!is_done.load(std::memory_order_relaxed)) {
+                pagenum_t page_num = hot.pages[rng() % hot.pages.size()];
+                uint64_t start_ns = metrics_now_ns();
+                buf_descriptor_t *buf_desc = get_buffer(hot.table_id, page_num, BUF_LATCH_SHARED);
+                if (buf_desc == nullptr || !check_mark(buf_desc->buf_page, page_num))
+                    num_failures++;
+                if (buf_desc != nullptr)
+                    release_buffer(buf_desc, BUF_LATCH_SHARED);
+                buckets[hist_bucket_of(metrics_now_ns() - start_ns)]++;
+                num_reads++;
+            }
+        });
+        init_buffer_stat();
+        uint64_t start_ns = metrics_now_ns();
+        int ret = 0;
+        if (round == 0)
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+        else
+            ret = checkpoint_buffer_pool(duration_ms);
+        uint64_t elapsed_ns = metrics_now_ns() - start_ns;
+        is_done = true;
+        reader.join();
+        buf_stat_snapshot_t snapshot;
+        get_buffer_stat_snapshot(&snapshot);
+        uint64_t num_written = snapshot.counters[METRIC_CHECKPOINT_WRITE];
+        if (round == 1)
+            full_speed_ms = elapsed_ns / 1000000;
+
+        const char *names[] = {"none", "full_speed", "throttled"};
+        printf("{\"experiment\":\"ckpt_large\",\"checkpoint\":\"%s\",\"dirty_pages\":%zu,"
+               "\"target_ms\":%u,\"ret\":%d,\"elapsed_ms\":%.1f,\"checkpoint_writes\":%" PRIu64
+               ",\"write_mb_per_sec\":%.1f,\"reads\":%" PRIu64 ",\"failures\":%" PRIu64
+               ",\"reads_per_sec\":%.0f,\"read_latency_ns\":%s}\n", names[round],
+               table.pages.size(), duration_ms, ret, elapsed_ns / 1e6, num_written,
+               num_written * (double)PAGE_SIZE / (1 << 20) / (elapsed_ns / 1e9), num_reads,
+               num_failures, num_reads * 1e9 / elapsed_ns, latency_json(buckets).c_str());
+        fflush(stdout);
+        if (ret != 0 || num_failures != 0 || (round > 0 && num_written < table.pages.size()))
+            return 1;
+    }
+    close_buffer_pool();
+    unlink(pathname.c_str());
+    return 0;
+}
+
+/*
+ * Allocation of --alloc-pages pages (512K by default, a 2GB table) into an
+ * empty table by 1 and 4 threads, with the header free list that the extent
+ * allocator replaced (see bench/baseline.cc) and with the extent allocator.
+ * The pages are only allocated, not written, so this times the allocators
+ * alone. The free list serializes every allocation on the header page, reads
+ * each page to unlink it, and writes every new page when it doubles the
+ * file; the extent allocator reserves each extent with fallocate() and marks
+ * pages in its space map. grow_ns is the latency of one file growth.
+ */
+static int bench_alloc() {
+    const uint32_t thread_counts[] = {1, 4};
+    std::string pathname = table_path("alloc");
+    for (int is_extent = 0; is_extent <= 1; is_extent++) {
+        for (uint32_t num_threads : thread_counts) {
+            unlink(pathname.c_str());
+            if (open_pool(options.num_buf) != 0)
+                return 1;
+            int64_t table_id = buffer_open_table(pathname.c_str());
+            if (table_id < 0)
+                return 1;
+            uint64_t num_pages = options.num_alloc_pages / num_threads;
+            std::vector<std::vector<uint64_t>> grow_ns(num_threads);
+            std::atomic<uint64_t> num_failures{0};
+            init_buffer_stat();
+            uint64_t elapsed_ns = time_threads(num_threads, [&](uint32_t t) {
+                for (uint64_t i = 0; i < num_pages; i++) {
+                    uint64_t ns = 0;
+                    pagenum_t page_num = is_extent ? alloc_page(table_id) :
+                                                     baseline_alloc_page(table_id, &ns);
+                    if (page_num <= 0)
+                        num_failures++;
+                    if (ns != 0)
+                        grow_ns[t].push_back(ns);
+                }
+            });
+            buf_stat_snapshot_t snapshot;
+            get_buffer_stat_snapshot(&snapshot);
+
+            // 늘린 시간은 extent allocator면 pool의 통계에서, free list면 직접 잰 것에서
+            std::vector<uint64_t> buckets(HIST_NUM_BUCKETS, 0);
+            uint64_t num_grows = 0, sum_ns = 0, max_ns = 0;
+            if (is_extent) {
+                const buf_histogram_t *grow = &snapshot.latencies[LATENCY_GROW];
+                buckets.assign(grow->buckets, grow->buckets + HIST_NUM_BUCKETS);
+                num_grows = grow->count;
+                sum_ns = grow->sum_ns;
+                max_ns = grow->max_ns;
+            } else {
+                for (const std::vector<uint64_t> &thread_ns : grow_ns) {
+                    for (uint64_t ns : thread_ns) {
+                        buckets[hist_bucket_of(ns)]++;
+                        num_grows++;
+                        sum_ns += ns;
+                        max_ns = std::max(max_ns, ns);
+                    }
+                }
+            }
+            uint64_t num_allocs = num_pages * num_threads;
+            std::string grow = latency_json(buckets);
+            grow.insert(grow.size() - 1, ",\"mean\":" + std::to_string(num_grows ? sum_ns / num_grows : 0) +
+                        ",\"max\":" + std::to_string(max_ns));
+            printf("{\"experiment\":\"alloc\",\"allocator\":\"%s\",\"threads\":%u,\"cpus\":%u,"
+                   "\"allocs\":%" PRIu64 ",\"failures\":%" PRIu64 ",\"elapsed_ns\":%" PRIu64
+                   ",\"allocs_per_sec\":%.0f,\"file_mb\":%.0f,\"page_io\":{\"read\":%" PRId64
+                   ",\"write\":%" PRId64 ",\"async_read\":%" PRId64 ",\"async_write\":%" PRId64
+                   "},\"grows\":%" PRIu64 ",\"grow_ns\":%s}\n",
+                   is_extent ? "extent" : "header_free_list", num_threads,
+                   std::thread::hardware_concurrency(), num_allocs, num_failures.load(), elapsed_ns,
+                   num_allocs * 1e9 / std::max<uint64_t>(elapsed_ns, 1),
+                   aio_get_num_pages(table_id) * (double)PAGE_SIZE / (1 << 20), snapshot.read_pages,
+                   snapshot.write_pages, snapshot.aio_read_pages, snapshot.aio_write_pages, num_grows,
+                   grow.c_str());
+            fflush(stdout);
+            close_buffer_pool();
+            unlink(pathname.c_str());
+            if (num_failures != 0)
+                return 1;
+        }
+    }
+    return 0;
+}
+
+// get_buffer_of_new_page()로 page를 늘리는 workload, log 없이와 log를 열고
+static int bench_insert() {
+    for (int has_wal = 0; has_wal <= 1; has_wal++) {
+        std::string wal_path = std::string(options.dir) + "/insert.wal";
+        std::string pathname = table_path("insert");
+        unlink(wal_path.c_str());
+        unlink(pathname.c_str());
+        if (open_pool(options.num_buf) != 0)
+            return 1;
+        if (has_wal && wal_open(wal_path.c_str()) != 0)
+            return 1;
+        bench_table_t table;
+        table.pathname = pathname;
+        table.table_id = buffer_open_table(pathname.c_str());
+        if (table.table_id < 0)
+            return 1;
+        bench_run_t run;
+        init_run(&run, "insert", BENCH_INSERT, &table);
+        run.config = has_wal ? "\"wal\":\"on\"" : "\"wal\":\"off\"";
+        bench_result_t result;
+        run_workload(&run, &result);
+        char extra[128];
+        snprintf(extra, sizeof(extra), ",\"wal_records\":%" PRIu64 ",\"wal_syncs\":%" PRIu64,
+                 result.stat->counters[METRIC_WAL_RECORD], result.stat->counters[METRIC_WAL_SYNC]);
+        print_result(&run, &result, extra);
+        free_result(&result);
+        close_buffer_pool();
+    }
+    return 0;
+}
+
+// 읽기 전용 mmap table과 frame에 복사하는 table의 uniform read와 익명 메모리
+static int bench_mmap() {
+    const buf_table_mode_t modes[] = {BUF_TABLE_READ_WRITE, BUF_TABLE_MMAP_RANDOM};
+    const char *names[] = {"read_write", "mmap"};
+    for (int m = 0; m < 2; m++) {
+        if (open_pool(options.num_buf) != 0)
+            return 1;
+        bench_table_t table;
+        if (open_table(&table, "main", modes[m]) != 0)
+            return 1;
+        bench_run_t run;
+        init_run(&run, "mmap", BENCH_UNIFORM, &table);
+        run.config = std::string("\"table_mode\":\"") + names[m] + "\"";
+        bench_result_t result;
+        run_workload(&run, &result);
+        print_result(&run, &result, ",\"rss_anon_kb\":" + std::to_string(get_rss_anon_kb()));
+        free_result(&result);
+        close_buffer_pool();
+    }
+    return 0;
+}
+
+/*
+ * Uniform reads of a table that fits in the pool, with the arenas on 4KB
+ * pages and on huge pages. The frames span far more 4KB pages than the TLB
+ * holds, so the difference is the cost of the TLB misses. The kind of huge
+ * page is whatever arena_alloc() got: explicit ones only if vm.nr_hugepages
+ * reserved them, otherwise transparent ones, which anon_huge_kb counts. The
+ * TLB misses themselves are not counted, since perf_event_open() may not
+ * offer hardware counters (it does not in a VM without a PMU). The NUMA
+ * modes only differ on a host with more than one node.
+ */
+static int bench_arena() {
+    for (int is_huge = 0; is_huge <= 1; is_huge++) {
+        arena_set_huge_pages(is_huge);
+        int64_t anon_huge_kb = get_proc_kb("/proc/self/smaps_rollup", "AnonHugePages");
+        set_ht_latch_mode(BUF_HT_PARTITIONED);
+        uint32_t num_buf = options.num_pages + 64;
+        if (init_buffer_pool(2 * num_buf, num_buf) != 0)
+            return 1;
+        bench_table_t table;
+        if (open_table(&table, "main") != 0)
+            return 1;
+        for (pagenum_t page_num : table.pages) {
+            buf_descriptor_t *buf_desc = get_buffer(table.table_id, page_num);
+            if (buf_desc != nullptr)
+                unpin_buffer(buf_desc);
+        }
+        anon_huge_kb = get_proc_kb("/proc/self/smaps_rollup", "AnonHugePages") - anon_huge_kb;
+
+        bench_run_t run;
+        init_run(&run, "arena", BENCH_UNIFORM, &table);
+        run.config = std::string("\"huge_pages\":\"") + (is_huge ? "on" : "off") + "\"";
+        bench_result_t result;
+        run_workload(&run, &result);
+        char extra[128];
+        snprintf(extra, sizeof(extra), ",\"frame_page_size\":%zu,\"anon_huge_kb\":%" PRId64
+                 ",\"numa_nodes\":%d", buffer_pool.size_classes[0].page_arenas[0].page_size,
+                 anon_huge_kb, arena_num_nodes());
+        print_result(&run, &result, extra);
+        free_result(&result);
+        close_buffer_pool();
+    }
+    arena_set_huge_pages(true);
+    return 0;
+}
+
+// table의 page 중 pool에 남아 있는 것의 수
+static uint64_t count_resident(const bench_table_t *table) {
+    uint64_t num_resident = 0;
+    for (pagenum_t page_num : table->pages)
+        num_resident += is_buffer_resident(table->table_id, page_num);
+    return num_resident;
+}
+
+/*
+ * A mixed workload of small and large pages: zipf point reads of an index
+ * of 4KB pages, with a fifth of the operations reading a uniformly chosen
+ * 64KB value instead (a "scan" of one page of the value table). Both pools
+ * get the same num_buf * 4KB of frames. The single-size pool has only 64KB
+ * frames, so the index must use 64KB pages too and each of them holds 4KB
+ * of data; the other splits the memory in half between a 4KB and a 64KB
+ * size class. memory_efficiency is the pool's share of frames in use, and
+ * payload_efficiency the share of frame bytes holding data the workload
+ * wrote: 4KB per resident index page, 64KB per resident value.
+ */
+static int bench_size_classes() {
+    const uint32_t value_size = MAX_BUF_PAGE_SIZE;
+    uint64_t num_index_pages = std::max<uint64_t>(options.num_pages / 4, 1);
+    uint64_t num_values = std::max<uint64_t>(options.num_pages / 64, 1);
+    if (fill_table("index", num_index_pages) || fill_table("index_large", num_index_pages, value_size) ||
+        fill_table("value", num_values, value_size))
+        return 1;
+    uint32_t num_large_buf = options.num_buf * PAGE_SIZE / value_size;
+    for (int has_classes = 0; has_classes <= 1; has_classes++) {
+        buf_size_class_config_t size_classes[2];
+        uint32_t num_size_classes;
+        if (has_classes) {
+            size_classes[0] = {PAGE_SIZE, options.num_buf / 2, 0};
+            size_classes[1] = {value_size, num_large_buf / 2, 0};
+            num_size_classes = 2;
+        } else {
+            size_classes[0] = {value_size, num_large_buf, 0};
+            num_size_classes = 1;
+        }
+        if (open_pool(size_classes, num_size_classes) != 0)
+            return 1;
+        uint32_t index_page_size = has_classes ? PAGE_SIZE : value_size;
+        bench_table_t index, value;
+        if (open_table(&index, has_classes ? "index" : "index_large", BUF_TABLE_READ_WRITE,
+                       index_page_size) != 0 ||
+            open_table(&value, "value", BUF_TABLE_READ_WRITE, value_size) != 0)
+            return 1;
+        bench_run_t run;
+        init_run(&run, "size_classes", BENCH_SCAN_POINT, &index);
+        run.scan_table = &value;
+        run.workload.scan_num_pages = value.pages.size();
+        run.workload.scan_percent = 20;
+        run.workload.scan_length = 1;
+        run.config = has_classes ? "\"size_classes\":\"4KB+64KB\"" : "\"size_classes\":\"64KB\"";
+        bench_result_t result;
+        run_workload(&run, &result);
+        const buf_stat_snapshot_t *s = result.stat;
+        uint64_t frame_bytes = 0;
+        for (uint32_t i = 0; i < s->num_size_classes; i++)
+            frame_bytes += (uint64_t)s->size_classes[i].num_buf * s->size_classes[i].page_size;
+        uint64_t payload_bytes = count_resident(&index) * PAGE_SIZE + count_resident(&value) * value_size;
+        const buf_table_stat_t *index_stat = &s->tables[std::min<int64_t>(index.table_id, MAX_METRIC_TABLES)];
+        const buf_table_stat_t *value_stat = &s->tables[std::min<int64_t>(value.table_id, MAX_METRIC_TABLES)];
+        char extra[256];
+        snprintf(extra, sizeof(extra), ",\"frame_bytes\":%" PRIu64 ",\"memory_efficiency\":%.2f,"
+                 "\"payload_efficiency\":%.2f,\"index_hit_ratio\":%.2f,\"value_hit_ratio\":%.2f",
+                 frame_bytes, s->memory_efficiency, 100.0 * payload_bytes / std::max<uint64_t>(frame_bytes, 1),
+                 100.0 * index_stat->hits / std::max<uint64_t>(index_stat->hits + index_stat->misses, 1),
+                 100.0 * value_stat->hits / std::max<uint64_t>(value_stat->hits + value_stat->misses, 1));
+        print_result(&run, &result, extra);
+        free_result(&result);
+        close_buffer_pool();
+    }
+    return 0;
+}
+
+// --workload, --policy, --latch로 고른 하나의 측정, --record가 있으면 trace를 남김
+static int bench_run() {
+    if (open_pool(options.num_buf, options.policy, options.latch_mode) != 0)
+        return 1;
+    bench_table_t table, scan_table;
+    if (open_table(&table, "main") != 0)
+        return 1;
+    bench_run_t run;
+    init_run(&run, "run", options.workload, &table);
+    if (options.workload == BENCH_SCAN_POINT) {
+        if (open_table(&scan_table, "scan") != 0)
+            return 1;
+        run.scan_table = &scan_table;
+        run.workload.scan_num_pages = scan_table.pages.size();
+    }
+    run.config = policy_config(options.policy) + ",\"latch\":\"" +
+                 (options.latch_mode == BUF_HT_PARTITIONED ? "partitioned" : "single") + "\"";
+    if (options.record && trace_enable(true) != 0) {
+        fprintf(stderr, "--record needs a build with BUF_TRACE\n");
+        close_buffer_pool();
+        return 1;
+    }
+    bench_result_t result;
+    measure(&run, &result);
+    free_result(&result);
+    int ret = 0;
+    if (options.record) {
+        trace_enable(false);
+        ret = trace_dump(options.record);
+    }
+    close_buffer_pool();
+    return ret;
+}
+
+// --replay의 trace를 --policy의 pool에서 재생, table은 기록할 때처럼 main과 scan 순서로 엶
+static int bench_replay_file() {
+    if (open_pool(options.num_buf, options.policy, options.latch_mode) != 0)
+        return 1;
+    bench_table_t table, scan_table;
+    if (open_table(&table, "main") != 0)
+        return 1;
+    if (options.workload == BENCH_SCAN_POINT && open_table(&scan_table, "scan") != 0)
+        return 1;
+    trace_replay_stat_t stat;
+    int ret = trace_replay(options.replay, &stat);
+    if (ret == 0) {
+        printf("%s\n", trace_replay_json(&stat).c_str());
+        fflush(stdout);
+    }
+    close_buffer_pool();
+    return ret;
+}
+
+typedef struct bench_experiment_t {
+    const char *name;
+    int (*run)();
+    const char *description;
+} bench_experiment_t;
+
+static const bench_experiment_t experiments[] = {
+    {"latch", bench_latch, "partitioned vs single-latch hashtable, hot set in the pool"},
+    {"ht_lookup", bench_ht_lookup, "Robin Hood vs chained lookups at 50-95% load, three key sets"},
+    {"freelist", bench_freelist, "lock-free freelist vs the mutex-protected heap list"},
+    {"policy", bench_policy, "CLOCK, LRU-K, 2Q and ARC on uniform, zipf and scan+point"},
+    {"replay", bench_replay, "one recorded zipf trace replayed under each policy"},
+    {"aio", bench_aio, "async vs sync I/O for a checkpoint"},
+    {"readahead", bench_readahead, "sequential scan with read-ahead off and on"},
+    {"ring", bench_ring, "scans through the shared pool vs a BULK_READ ring"},
+    {"quota", bench_quota, "hot table next to a scanned table, per policy, with and without a quota"},
+    {"bg_writer", bench_bg_writer, "write-heavy zipf with the background writer off and on"},
+    {"checkpoint", bench_checkpoint, "a checkpoint under writes, at full speed vs throttled"},
+    {"zcache", bench_zcache, "working sets 2-4x the pool, compressed cache off and on"},
+    {"access", bench_access, "latched get_buffer() vs optimistic reads vs swips"},
+    {"warm", bench_warm, "first operations after a cold and a warm restart"},
+    {"resize", bench_resize, "lookups during online resizes, hit ratio kept vs a restart"},
+    {"trace", bench_trace, "hit cost with tracing compiled in, off and on, or compiled out"},
+    {"ckpt_large", bench_checkpoint_large, "checkpoint of 1M dirty pages with reads going on"},
+    {"alloc", bench_alloc, "page allocation and file growth, header free list vs extents"},
+    {"insert", bench_insert, "get_buffer_of_new_page() inserts without and with the log"},
+    {"arena", bench_arena, "uniform hits with the pool on 4KB pages vs huge pages"},
+    {"size_classes", bench_size_classes, "4KB index and 64KB values, one 64KB class vs two classes"},
+    {"mmap", bench_mmap, "read-write vs read-only mmap table, uniform reads"},
+};
+
+static void usage(const char *program) {
+    fprintf(stderr,
+            "usage: %s [options] [experiment|all|run]\n"
+            "  --threads=N     threads per measurement (default: hardware threads)\n"
+            "  --ops=N         timed operations per thread (default 200000)\n"
+            "  --pages=N       pages of the main table (default 16384)\n"
+            "  --buffers=N     buffers of the pool (default pages / 8)\n"
+            "  --dirty-pages=N dirty pages of ckpt_large (default 1048576)\n"
+            "  --alloc-pages=N pages allocated by alloc (default 524288)\n"
+            "  --dir=PATH      directory of the table files (default /tmp/buffer_bench)\n"
+            "  --workload=W    for run: uniform, zipf, scan_point or insert\n"
+            "  --policy=P      for run and --replay: CLOCK, LRU-K, 2Q or ARC\n"
+            "  --latch=L       for run and --replay: partitioned or single\n"
+            "  --record=FILE   for run: write a trace of the run (BUF_TRACE builds)\n"
+            "  --replay=FILE   replay a trace recorded with --record\n"
+            "experiments:\n", program);
+    for (const bench_experiment_t &experiment : experiments)
+        fprintf(stderr, "  %-12s %s\n", experiment.name, experiment.description);
+}
+
+// "--name=value"이면 value를, 아니면 nullptr
+static const char *option_value(const char *arg, const char *name) {
+    size_t length = strlen(name);
+    if (strncmp(arg, name, length) == 0 && arg[length] == '=')
+        return arg + length + 1;
+    return nullptr;
+}
+
+static int parse_options(int argc, char **argv) {
+    options.experiment = "all";
+    options.dir = "/tmp/buffer_bench";
+    options.num_threads = std::max(1u, std::thread::hardware_concurrency());
+    options.num_ops = 200000;
+    options.num_pages = 16384;
+    options.num_buf = 0;
+    options.num_dirty_pages = 1 << 20;
+    options.num_alloc_pages = 1 << 19;
+    options.workload = BENCH_ZIPF;
+    options.policy = BUF_POLICY_CLOCK;
+    options.latch_mode = BUF_HT_PARTITIONED;
+    options.record = nullptr;
+    options.replay = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        const char *value;
+        if ((value = option_value(argv[i], "--threads")))
+            options.num_threads = std::max(1, atoi(value));
+        else if ((value = option_value(argv[i], "--ops")))
+            options.num_ops = strtoull(value, nullptr, 10);
+        else if ((value = option_value(argv[i], "--pages")))
+            options.num_pages = strtoull(value, nullptr, 10);
+        else if ((value = option_value(argv[i], "--buffers")))
+            options.num_buf = atoi(value);
+        else if ((value = option_value(argv[i], "--dirty-pages")))
+            options.num_dirty_pages = strtoull(value, nullptr, 10);
+        else if ((value = option_value(argv[i], "--alloc-pages")))
+            options.num_alloc_pages = strtoull(value, nullptr, 10);
+        else if ((value = option_value(argv[i], "--dir")))
+            options.dir = value;
+        else if ((value = option_value(argv[i], "--record")))
+            options.record = value;
+        else if ((value = option_value(argv[i], "--replay")))
+            options.replay = value;
+        else if ((value = option_value(argv[i], "--workload"))) {
+            if (workload_parse(value, &options.workload) != 0)
+                return 1;
+        } else if ((value = option_value(argv[i], "--policy"))) {
+            int p = BUF_POLICY_CLOCK;
+            while (p <= BUF_POLICY_ARC && strcmp(value, get_buf_policy((buf_policy_kind_t)p)->name) != 0)
+                p++;
+            if (p > BUF_POLICY_ARC)
+                return 1;
+            options.policy = (buf_policy_kind_t)p;
+        } else if ((value = option_value(argv[i], "--latch"))) {
+            if (strcmp(value, "partitioned") != 0 && strcmp(value, "single") != 0)
+                return 1;
+            options.latch_mode = strcmp(value, "single") == 0 ? BUF_HT_SINGLE_LATCH : BUF_HT_PARTITIONED;
+        } else if (argv[i][0] == '-') {
+            return 1;
+        } else {
+            options.experiment = argv[i];
+        }
+    }
+    if (options.num_buf == 0)
+        options.num_buf = std::max<uint64_t>(options.num_pages / 8, 64);
+    return options.num_pages < 2 * WORKLOAD_SCAN_LENGTH || options.num_ops == 0;
+}
+
+int main(int argc, char **argv) {
+    if (parse_options(argc, argv) != 0) {
+        usage(argv[0]);
+        return 2;
+    }
+    mkdir(options.dir, 0755);
+    if (fill_tables() != 0)
+        return 1;
+
+    if (options.replay)
+        return bench_replay_file();
+    if (strcmp(options.experiment, "run") == 0)
+        return bench_run();
+
+    int ret = 0;
+    bool is_found = false;
+    for (const bench_experiment_t &experiment : experiments) {
+        if (strcmp(options.experiment, "all") != 0 && strcmp(options.experiment, experiment.name) != 0)
+            continue;
+        is_found = true;
+        fprintf(stderr, "running %s\n", experiment.name);
+        if (experiment.run() != 0) {
+            fprintf(stderr, "experiment %s failed\n", experiment.name);
+            ret = 1;
+        }
+    }
+    if (!is_found) {
+        usage(argv[0]);
+        return 2;
+    }
+    return ret;
+}
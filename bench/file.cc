@@ -0,0 +1,87 @@
+#include "file.h"
+#include "log.h"
+
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// For stat
+int64_t stat_read_page;
+int64_t stat_write_page;
+
+// table_id를 index로 하는 file descriptor, 열린 뒤에는 바뀌지 않으므로 latch 없이 읽음
+static int table_fds[FILE_MAX_TABLES];
+static int num_tables;
+// 새 table id를 나눠 줄 때만 잡음
+static std::mutex open_latch;
+
+int init_tables() {
+    std::lock_guard<std::mutex> guard(open_latch);
+    num_tables = 0;
+    return 0;
+}
+
+/**
+ * @brief Open the file of a table, creating it if it does not exist.
+ *
+ * @return The table id, or -1 if the file cannot be opened.
+ *
+ * @details A new file gets a header page with an empty free page list and a
+ * size of one page. The ids count up from 0 again after
+ * file_close_table_files().
+ */
+int64_t file_open_table_file(const char *pathname) {
+    std::lock_guard<std::mutex> guard(open_latch);
+    if (num_tables >= FILE_MAX_TABLES) {
+        buf_log_error("Error: too many open table files for " << pathname);
+        return -1;
+    }
+    int fd = open(pathname, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        buf_log_error("Error: cannot open " << pathname << ": " << strerror(errno));
+        return -1;
+    }
+    if (lseek(fd, 0, SEEK_END) == 0) {
+        page_t header;
+        memset(&header, 0, sizeof(header));
+        header.free_page_num = -1;
+        header.num_of_pages = 1;
+        if (pwrite(fd, &header, PAGE_SIZE, 0) != PAGE_SIZE) {
+            buf_log_error("Error: cannot write the header page of " << pathname);
+            close(fd);
+            return -1;
+        }
+    }
+    table_fds[num_tables] = fd;
+    return num_tables++;
+}
+
+// file 끝을 넘는 page는 0으로 채워 읽음
+void file_read_page(int64_t table_id, pagenum_t page_num, page_t *dest) {
+    __atomic_fetch_add(&stat_read_page, 1, __ATOMIC_RELAXED);
+    ssize_t num_read = pread(table_fds[table_id], dest, PAGE_SIZE, (off_t)page_num * PAGE_SIZE);
+    if (num_read < 0) {
+        buf_log_error("Error: cannot read page " << page_num << " of table " << table_id
+                      << ": " << strerror(errno));
+        num_read = 0;
+    }
+    if (num_read < PAGE_SIZE)
+        memset(dest->data + num_read, 0, PAGE_SIZE - num_read);
+}
+
+void file_write_page(int64_t table_id, pagenum_t page_num, const page_t *src) {
+    __atomic_fetch_add(&stat_write_page, 1, __ATOMIC_RELAXED);
+    if (pwrite(table_fds[table_id], src, PAGE_SIZE, (off_t)page_num * PAGE_SIZE) != PAGE_SIZE)
+        buf_log_error("Error: cannot write page " << page_num << " of table " << table_id
+                      << ": " << strerror(errno));
+}
+
+void file_close_table_files() {
+    std::lock_guard<std::mutex> guard(open_latch);
+    for (int i = 0; i < num_tables; i++)
+        close(table_fds[i]);
+    num_tables = 0;
+}
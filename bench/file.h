@@ -0,0 +1,27 @@
+#ifndef DB_FILE_H_
+#define DB_FILE_H_
+
+#include "page.h"
+
+#include <cstdint>
+
+/*
+ * Stand-in for the file layer, backed by one regular file per table. Page
+ * page_num of a table is at page_num * PAGE_SIZE in its file. Only the
+ * functions the buffer pool calls are provided.
+ */
+
+// 한 번에 열 수 있는 table file 수
+#define FILE_MAX_TABLES (1024)
+
+// For stat
+extern int64_t stat_read_page;
+extern int64_t stat_write_page;
+
+int init_tables();
+int64_t file_open_table_file(const char *pathname);
+void file_read_page(int64_t table_id, pagenum_t page_num, page_t *dest);
+void file_write_page(int64_t table_id, pagenum_t page_num, const page_t *src);
+void file_close_table_files();
+
+#endif // DB_FILE_H_
@@ -0,0 +1,33 @@
+#ifndef DB_PAGE_H_
+#define DB_PAGE_H_
+
+#include <cstdint>
+
+/*
+ * Stand-in for the page.h of the file layer, which is not part of this tree.
+ * It has only what the buffer pool uses: PAGE_SIZE, pagenum_t and the fields
+ * of the header page and of free pages. Set BUF_FILE_LAYER_DIR to build
+ * against the real file layer instead.
+ */
+
+// file layer가 한 번에 읽고 쓰는 page 크기
+#define PAGE_SIZE (4096)
+
+typedef int64_t pagenum_t;
+
+typedef struct page_t {
+    union {
+        // header page (page 0)
+        struct {
+            pagenum_t free_page_num;
+            uint64_t num_of_pages;
+        };
+        // free page list의 page
+        struct {
+            pagenum_t next_free_page_num;
+        };
+        char data[PAGE_SIZE];
+    };
+} page_t;
+
+#endif // DB_PAGE_H_
@@ -0,0 +1,127 @@
+#include "workload.h"
+
+#include <cmath>
+#include <cstring>
+
+// zipf의 rank를 page에 흩어 놓는 곱수, 소수라서 n이 이 수의 배수가 아니면 순열이 됨
+#define WORKLOAD_SCRAMBLE (2654435761ULL)
+
+static const char *workload_names[] = {
+    "uniform", "zipf", "scan_point", "insert"
+};
+
+/**
+ * @brief Fill a workload config with the defaults of a workload kind.
+ *
+ * @details Uniform and zipf only read. Scan+point reads zipf pages and makes
+ * 5% of the operations a scan of WORKLOAD_SCAN_LENGTH pages, and insert makes
+ * 80% of the operations a new page.
+ */
+void workload_default_config(bench_workload_config_t *config, bench_workload_kind_t kind,
+                             uint64_t num_pages) {
+    config->kind = kind;
+    config->num_pages = num_pages;
+    config->theta = WORKLOAD_ZIPF_THETA;
+    config->write_percent = 0;
+    config->scan_percent = kind == BENCH_SCAN_POINT ? 5 : 0;
+    config->scan_length = WORKLOAD_SCAN_LENGTH;
+    config->scan_num_pages = num_pages;
+    config->insert_percent = kind == BENCH_INSERT ? 80 : 0;
+}
+
+// zeta(n, theta) = 1/1^theta + ... + 1/n^theta
+static double zeta(uint64_t n, double theta) {
+    double sum = 0;
+    for (uint64_t i = 1; i <= n; i++)
+        sum += 1 / std::pow((double)i, theta);
+    return sum;
+}
+
+/**
+ * @brief Prepare a zipf distribution over [0, n).
+ *
+ * @details Computing zeta(n) takes O(n), after which each draw is O(1)
+ * ("Quickly Generating Billion-Record Synthetic Databases", Gray et al.).
+ */
+void workload_init_zipf(bench_zipf_t *zipf, uint64_t n, double theta) {
+    zipf->n = n;
+    zipf->theta = theta;
+    zipf->alpha = 1 / (1 - theta);
+    zipf->zetan = zeta(n, theta);
+    zipf->eta = (1 - std::pow(2.0 / n, 1 - theta)) / (1 - zeta(2, theta) / zipf->zetan);
+}
+
+uint64_t workload_next_zipf(bench_zipf_t *zipf, std::mt19937_64 *rng) {
+    double u = std::uniform_real_distribution<double>(0, 1)(*rng);
+    double uz = u * zipf->zetan;
+    if (uz < 1)
+        return 0;
+    if (uz < 1 + std::pow(0.5, zipf->theta))
+        return 1;
+    uint64_t rank = zipf->n * std::pow(zipf->eta * u - zipf->eta + 1, zipf->alpha);
+    return rank < zipf->n ? rank : zipf->n - 1;
+}
+
+void workload_init_generator(bench_generator_t *generator, const bench_workload_config_t *config,
+                             uint64_t seed) {
+    generator->config = config;
+    generator->rng.seed(seed);
+    if (config->kind == BENCH_ZIPF || config->kind == BENCH_SCAN_POINT)
+        workload_init_zipf(&generator->zipf, config->num_pages, config->theta);
+}
+
+/**
+ * @brief Draw the next operation of a thread.
+ *
+ * @details Zipf ranks are scrambled over the pages, so the hot pages are not
+ * adjacent and do not look like a scan to read-ahead.
+ */
+bench_op_t workload_next(bench_generator_t *generator) {
+    const bench_workload_config_t *config = generator->config;
+    std::mt19937_64 *rng = &generator->rng;
+    bench_op_t op = {BENCH_OP_READ, 0, 1};
+    uint32_t percent = (*rng)() % 100;
+
+    switch (config->kind) {
+    case BENCH_UNIFORM:
+        op.page = (*rng)() % config->num_pages;
+        break;
+    case BENCH_ZIPF:
+        op.page = workload_next_zipf(&generator->zipf, rng) * WORKLOAD_SCRAMBLE % config->num_pages;
+        break;
+    case BENCH_SCAN_POINT:
+        if (percent < config->scan_percent) {
+            op.kind = BENCH_OP_SCAN;
+            op.page = (*rng)() % config->scan_num_pages;
+            op.length = config->scan_length;
+            return op;
+        }
+        op.page = workload_next_zipf(&generator->zipf, rng) * WORKLOAD_SCRAMBLE % config->num_pages;
+        break;
+    case BENCH_INSERT:
+        if (percent < config->insert_percent) {
+            op.kind = BENCH_OP_INSERT;
+            return op;
+        }
+        op.page = (*rng)();
+        return op;
+    }
+    if ((*rng)() % 100 < config->write_percent)
+        op.kind = BENCH_OP_WRITE;
+    return op;
+}
+
+const char *workload_name(bench_workload_kind_t kind) {
+    return workload_names[kind];
+}
+
+// 이름에 맞는 workload를 kind에 넣음, 모르는 이름이면 1
+int workload_parse(const char *name, bench_workload_kind_t *kind) {
+    for (int i = 0; i < (int)(sizeof(workload_names) / sizeof(workload_names[0])); i++) {
+        if (strcmp(name, workload_names[i]) == 0) {
+            *kind = (bench_workload_kind_t)i;
+            return 0;
+        }
+    }
+    return 1;
+}
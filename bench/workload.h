@@ -0,0 +1,77 @@
+#ifndef DB_BENCH_WORKLOAD_H_
+#define DB_BENCH_WORKLOAD_H_
+
+#include <cstdint>
+#include <random>
+
+// zipf의 기본 skew, YCSB와 같은 값
+#define WORKLOAD_ZIPF_THETA (0.99)
+// scan 하나가 읽는 page 수
+#define WORKLOAD_SCAN_LENGTH (64)
+
+// benchmark가 만드는 접근 pattern
+typedef enum bench_workload_kind_t {
+    BENCH_UNIFORM,      // 모든 page를 같은 확률로
+    BENCH_ZIPF,         // 소수의 hot page에 몰림 (theta)
+    BENCH_SCAN_POINT,   // zipf point lookup 사이사이에 긴 sequential scan
+    BENCH_INSERT        // get_buffer_of_new_page()로 page를 늘리며 새로 만든 page를 다시 읽음
+} bench_workload_kind_t;
+
+typedef enum bench_op_kind_t {
+    BENCH_OP_READ,      // page 하나를 shared latch로 읽음
+    BENCH_OP_WRITE,     // page 하나를 exclusive latch로 고치고 dirty로 표시
+    BENCH_OP_SCAN,      // page부터 length개의 page를 차례로 읽음
+    BENCH_OP_INSERT     // 새 page를 만들어 채움
+} bench_op_kind_t;
+
+// page는 table의 page 번호가 아니라 benchmark가 채운 page들 중의 순번
+// BENCH_INSERT의 read는 thread가 만든 page들 중의 순번을 아무 큰 수로 주고 나머지로 고름
+typedef struct bench_op_t {
+    bench_op_kind_t kind;
+    uint64_t page;
+    uint32_t length;
+} bench_op_t;
+
+typedef struct bench_workload_config_t {
+    bench_workload_kind_t kind;
+    // 접근하는 page 수
+    uint64_t num_pages;
+    double theta;
+    // read 대신 write를 하는 비율 (0 ~ 100)
+    uint32_t write_percent;
+    // BENCH_SCAN_POINT에서 point lookup 대신 scan을 하는 비율 (0 ~ 100)
+    uint32_t scan_percent;
+    uint32_t scan_length;
+    // scan이 시작하는 page의 범위, scan이 다른 table을 읽으면 그 table의 page 수
+    uint64_t scan_num_pages;
+    // BENCH_INSERT에서 read 대신 insert를 하는 비율 (0 ~ 100)
+    uint32_t insert_percent;
+} bench_workload_config_t;
+
+// Gray et al.의 방법으로 [0, n)에서 rank를 뽑는 zipf 분포, 0이 가장 자주 나옴
+typedef struct bench_zipf_t {
+    uint64_t n;
+    double theta;
+    double alpha;
+    double zetan;
+    double eta;
+} bench_zipf_t;
+
+// thread마다 하나씩 두는 op 생성기
+typedef struct bench_generator_t {
+    const bench_workload_config_t *config;
+    std::mt19937_64 rng;
+    bench_zipf_t zipf;
+} bench_generator_t;
+
+void workload_default_config(bench_workload_config_t *config, bench_workload_kind_t kind,
+                             uint64_t num_pages);
+void workload_init_zipf(bench_zipf_t *zipf, uint64_t n, double theta);
+uint64_t workload_next_zipf(bench_zipf_t *zipf, std::mt19937_64 *rng);
+void workload_init_generator(bench_generator_t *generator, const bench_workload_config_t *config,
+                             uint64_t seed);
+bench_op_t workload_next(bench_generator_t *generator);
+const char *workload_name(bench_workload_kind_t kind);
+int workload_parse(const char *name, bench_workload_kind_t *kind);
+
+#endif // DB_BENCH_WORKLOAD_H_
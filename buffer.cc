@@ -1,150 +1,809 @@
 #include "buffer.h"
+#include "aio.h"
+#include "alloc.h"
 #include "file.h"
+#include "log.h"
+#include "mapped.h"
+#include "metrics.h"
+#include "trace.h"
+#include "warm.h"
 
-// For stats
-int64_t stat_get_buffer;
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <sys/mman.h>
 
 buffer_pool_t buffer_pool;
 
+// 함께 제출한 prefetch 읽기들, 마지막 읽기가 끝나면 I/O thread에서 해제됨
+typedef struct prefetch_t {
+    std::atomic<uint32_t> num_pending;
+    std::vector<aio_request_t> requests;
+    // requests와 같은 순서의 buffer
+    std::vector<buf_descriptor_t *> buf_descs;
+} prefetch_t;
+
+void readahead_buffer(int64_t table_id, pagenum_t page_num, buf_strategy_t *strategy);
+void evict_table_buffers(int64_t table_id);
+
+/**
+ * @brief Mark a buffer dirty and add it to the dirty-page index.
+ * 
+ * @details The index may still hold buffers that were cleaned meanwhile, but
+ * a dirty buffer is never missing from it: the bits are set after is_dirty,
+ * and clear_buffer_dirty() sets them again if the buffer became dirty while
+ * they were cleared. Marking a dirty buffer again does not touch the index.
+ * 
+ * A buffer being written is clean but stays in the index with its rec_lsn
+ * until the write is done (see begin_buffer_write()), so
+ * get_oldest_dirty_lsn() never passes a page that is not yet on disk.
+ */
+void inline set_buffer_dirty(buf_descriptor_t *buf_desc) {
+    if (buf_desc->is_dirty.exchange(true))
+        return;
+    uint32_t index = buf_desc - buffer_pool.buf_descriptors;
+    uint32_t word = index / 64;
+    buffer_pool.dirty_bitmap[word].fetch_or(1ULL << (index % 64));
+    buffer_pool.dirty_summary[word / 64].fetch_or(1ULL << (word % 64));
+}
+
+// page를 쓰기 전에 호출, 쓰는 도중 다시 dirty가 되면 알 수 있도록 clean으로만 표시
+// rec_lsn과 dirty-page index는 쓰기가 끝나 clear_buffer_dirty()를 부를 때까지 남김
+void inline begin_buffer_write(buf_descriptor_t *buf_desc) {
+    buf_desc->is_dirty = false;
+}
+
+// 쓰기가 끝난 뒤 shared content latch를 잡고 호출, 그 사이 다시 dirty가 되지 않았다면
+// rec_lsn을 지우고 dirty-page index에서 뺌 (실패한 쓰기는 dirty로 되돌려 rec_lsn이 남음)
+void inline clear_buffer_dirty(buf_descriptor_t *buf_desc) {
+    if (buf_desc->is_dirty)
+        return;
+    buf_desc->rec_lsn = 0;
+    uint32_t index = buf_desc - buffer_pool.buf_descriptors;
+    uint32_t word = index / 64;
+    uint64_t bits = buffer_pool.dirty_bitmap[word].fetch_and(~(1ULL << (index % 64)));
+    if (bits == 1ULL << (index % 64)) {
+        // word가 비었으면 summary bit도 끄고, 그 사이 켜진 bit가 있으면 되돌림
+        buffer_pool.dirty_summary[word / 64].fetch_and(~(1ULL << (word % 64)));
+        if (buffer_pool.dirty_bitmap[word].load() != 0)
+            buffer_pool.dirty_summary[word / 64].fetch_or(1ULL << (word % 64));
+    }
+    if (buf_desc->is_dirty) {
+        buffer_pool.dirty_bitmap[word].fetch_or(1ULL << (index % 64));
+        buffer_pool.dirty_summary[word / 64].fetch_or(1ULL << (word % 64));
+    }
+}
+
+/**
+ * @brief Call visit for every buffer in the dirty-page index.
+ * 
+ * @details Only the summary words and the bitmap words with dirty buffers
+ * are read, so this takes time proportional to the number of dirty buffers
+ * plus max_num_buf / 4096. visit must check is_dirty itself, since a buffer may
+ * be cleaned at any time.
+ */
+template<typename Visit>
+void for_each_dirty_buffer(Visit visit) {
+    uint32_t num_words = (buffer_pool.max_num_buf + 63) / 64;
+    for (uint32_t s = 0; s < (num_words + 63) / 64; s++) {
+        uint64_t summary = buffer_pool.dirty_summary[s].load();
+        while (summary != 0) {
+            uint32_t word = s * 64 + __builtin_ctzll(summary);
+            summary &= summary - 1;
+            uint64_t bits = buffer_pool.dirty_bitmap[word].load();
+            while (bits != 0) {
+                visit(&buffer_pool.buf_descriptors[word * 64 + __builtin_ctzll(bits)]);
+                bits &= bits - 1;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Read a page of a table through the file layer.
+ * 
+ * @details The file layer reads and writes PAGE_SIZE pages, so a table page
+ * of page_size bytes is kept as page_size / PAGE_SIZE file pages from
+ * page_num * (page_size / PAGE_SIZE) on.
+ */
+void read_table_page(int64_t table_id, pagenum_t page_num, page_t *dest) {
+    uint32_t num_file_pages = get_table_page_size(table_id) / PAGE_SIZE;
+    for (uint32_t i = 0; i < num_file_pages; i++)
+        file_read_page(table_id, page_num * num_file_pages + i, &dest[i]);
+}
+
+void write_table_page(int64_t table_id, pagenum_t page_num, const page_t *src) {
+    uint32_t num_file_pages = get_table_page_size(table_id) / PAGE_SIZE;
+    for (uint32_t i = 0; i < num_file_pages; i++)
+        file_write_page(table_id, page_num * num_file_pages + i, &src[i]);
+}
+
 void inline flush_buffer(buf_descriptor_t *buf_desc) {
-    std::cout << "Entering flush_buffer with buf_desc: " << buf_desc << std::endl;
+    buf_log_debug("Entering flush_buffer with buf_desc: " << buf_desc);
     if (buf_desc == nullptr) {
-        std::cerr << "Error: buf_desc is nullptr in flush_buffer." << std::endl;
+        buf_log_error("Error: buf_desc is nullptr in flush_buffer.");
         return;
     }
     if (buf_desc->buf_page == nullptr) {
-        std::cerr << "Error: buf_desc->buf_page is nullptr in flush_buffer." << std::endl;
+        buf_log_error("Error: buf_desc->buf_page is nullptr in flush_buffer.");
+        return;
+    }
+    uint64_t start_ns = metrics_now_ns();
+    // log-before-data: page의 update record들이 먼저 기록되어야 함
+    if (wal_flush(buf_desc->page_lsn) != 0) {
+        buf_log_error("Error: cannot write page " << buf_desc->page_num << " before its log records");
         return;
     }
-    file_write_page(buf_desc->table_id, buf_desc->page_num, buf_desc->buf_page);   
-    std::cout << "Exiting flush_buffer" << std::endl;
+    // 쓰기 전에 clean으로 바꿔 두어야 쓰는 도중 다시 dirty가 된 경우를 알 수 있다
+    begin_buffer_write(buf_desc);
+    trace_event(TRACE_FLUSH, buf_desc->table_id, buf_desc->page_num,
+                buf_desc - buffer_pool.buf_descriptors);
+    write_table_page(buf_desc->table_id, buf_desc->page_num, buf_desc->buf_page);
+    clear_buffer_dirty(buf_desc);
+    metric_latency(LATENCY_FLUSH, start_ns);
+    buf_log_debug("Exiting flush_buffer");
+}
+
+/**
+ * @brief Completion callback of the writes of checkpoint_batch().
+ * 
+ * @details A failed write leaves the buffer dirty again so that it is written
+ * synchronously afterwards.
+ */
+void write_buffer_done(aio_request_t *request, int result) {
+    if (result < 0) {
+        buf_log_error("Error: async write of page " << request->page_num << " failed: " << result);
+        set_buffer_dirty((buf_descriptor_t *)request->arg);
+    }
+}
+
+// wal_redo()가 update record마다 호출, arg는 table_id
+int redo_buffer_update(lsn_t lsn, pagenum_t page_num, uint32_t offset, uint32_t length,
+                       const char *data, void *arg) {
+    int64_t table_id = *(int64_t *)arg;
+    if (offset + length > get_table_page_size(table_id)) {
+        buf_log_error("Error: update record beyond page " << page_num << " of table " << table_id);
+        return 1;
+    }
+    buf_descriptor_t *buf_desc = get_buffer(table_id, page_num, BUF_LATCH_EXCLUSIVE);
+    if (buf_desc == nullptr)
+        return 1;
+    memcpy(buf_desc->buf_page->data + offset, data, length);
+    // record는 이미 log에 있으므로 다시 기록하지 않음
+    mark_buffer_dirty(buf_desc);
+    buf_desc->page_lsn = lsn;
+    if (buf_desc->rec_lsn == 0)
+        buf_desc->rec_lsn = lsn;
+    release_buffer(buf_desc, BUF_LATCH_EXCLUSIVE);
+    return 0;
+}
+
+// page_size의 page를 담는 size class, 없으면 -1
+int find_size_class(uint32_t page_size) {
+    for (uint32_t i = 0; i < buffer_pool.num_size_classes; i++) {
+        if (buffer_pool.size_classes[i].page_size == page_size)
+            return i;
+    }
+    return -1;
+}
+
+// table_latch를 잡고 호출, table_id가 속한 chunk가 없으면 0으로 채워 할당
+void init_table_chunk(int64_t table_id) {
+    std::atomic<buf_table_info_t *> *chunk = &buffer_pool.table_chunks[table_id / BUF_TABLE_CHUNK_SIZE];
+    if (chunk->load() == nullptr)
+        chunk->store(new buf_table_info_t[BUF_TABLE_CHUNK_SIZE](), std::memory_order_release);
+}
+
+/**
+ * @brief Open a table file.
+ * 
+ * @param page_size The size of the table's pages, which must be the page
+ * size of one of the pool's size classes
+ * @return The table id, or a negative value if the file cannot be opened,
+ * its id is too large for the pool (MAX_BUF_TABLES), or mapping or redoing
+ * the table fails. The file layer can only close all tables at once, so a
+ * file opened before such a failure stays open until
+ * file_close_table_files(), but the pool keeps nothing of the table.
+ * 
+ * @details The page size is a property of the file, so a table must be opened
+ * with the same page size every time. The header page is page 0 of the table,
+ * and its page counts and free page numbers are in pages of this size. The
+ * pool's information about tables is allocated as they are opened, in chunks
+ * of BUF_TABLE_CHUNK_SIZE tables.
+ * 
+ * If the log is open (see wal_open()), the table's updates logged
+ * since the last checkpoint are redone into the buffer pool first, so the
+ * table is returned as it was at the last durable update before a crash.
+ * The table is opened for async I/O and warm restarts only once the redo
+ * succeeded. If it fails, the pages redone so far are written, since they
+ * match a prefix of the log, and evicted.
+ * 
+ * With one of the BUF_TABLE_MMAP modes, the file is mapped read-only (see
+ * mapped_open_table()). A miss then points the buffer at the page in the
+ * mapping instead of copying it into the buffer's frame, so the page is in
+ * memory once, in the OS page cache, and the buffer's unused frame is given
+ * back to the OS meanwhile. Such a table cannot be latched
+ * exclusively or get new pages, and it is neither redone nor logged, which
+ * suits read-only replicas of tables written elsewhere. Pages appended to
+ * the file after it was mapped are read into frames as usual.
+ */
+int64_t buffer_open_table(const char *pathname, uint32_t page_size, buf_table_mode_t mode) {
+    buf_log_info("Entering buffer_open_table with pathname: " << pathname);
+    int size_class = find_size_class(page_size);
+    if (size_class < 0) {
+        buf_log_error("Error: no size class of " << page_size << " bytes for " << pathname);
+        return -1;
+    }
+    int64_t table_id;
+    {
+        std::lock_guard<std::mutex> guard(buffer_pool.table_latch);
+        table_id = file_open_table_file(pathname);
+        if (table_id >= MAX_BUF_TABLES) {
+            buf_log_error("Error: table id " << table_id << " is too large for the buffer pool");
+            return -1;
+        }
+        if (table_id >= 0)
+            init_table_chunk(table_id);
+    }
+    // page를 읽기 전에 정해야 하므로 redo보다 먼저 기록
+    if (table_id >= 0)
+        get_table_info(table_id)->size_class = size_class;
+    // mmap하지 못하면 아래의 준비를 하기 전에 실패
+    if (table_id >= 0 && mode != BUF_TABLE_READ_WRITE) {
+        int advice = mode == BUF_TABLE_MMAP_SEQUENTIAL ? MADV_SEQUENTIAL :
+                     mode == BUF_TABLE_MMAP_RANDOM ? MADV_RANDOM : MADV_NORMAL;
+        if (mapped_open_table(table_id, pathname, page_size, advice) != 0)
+            return -1;
+    }
+    if (table_id >= 0 && mode == BUF_TABLE_READ_WRITE && wal_is_open()) {
+        // 이미 redo한 page는 log의 앞부분과 같으므로 써서 내보냄
+        if (wal_redo(pathname, redo_buffer_update, &table_id) != 0) {
+            evict_table_buffers(table_id);
+            return -1;
+        }
+        wal_log_table(table_id, pathname);
+    }
+    // async I/O용 descriptor를 열지 못해도 동기 경로로 동작함
+    if (table_id >= 0) {
+        aio_open_table(table_id, pathname, page_size);
+        warm_register_table(table_id, pathname);
+    }
+    buf_log_info("Exiting buffer_open_table with " << (mode != BUF_TABLE_READ_WRITE ? "read-only " : "")
+                 << "table_id: " << table_id);
+    return table_id;
+}
+
+// buffer_open_table()에서 정한 table의 page 크기
+uint32_t get_table_page_size(int64_t table_id) {
+    return buffer_pool.size_classes[get_table_info(table_id)->size_class].page_size;
+}
+
+/**
+ * @brief Set how many buffers of its size class a table may use.
+ * 
+ * @param soft_quota The table's pages are replaced by other tables' pages
+ * only while it uses more buffers than this, or if no other victim is found.
+ * 0 for none
+ * @param hard_quota The table replaces only its own pages once it uses this
+ * many buffers. 0 for none
+ * @retval 0: successful
+ * @retval others: the table id or quotas are invalid
+ * 
+ * @details Meant to keep a large scan of one table from pushing the hot pages
+ * of others out of the shared pool, e.g. a small soft quota for a table of
+ * index pages and a hard quota for a table that is scanned. The quotas are
+ * checked when a victim is chosen, so a table above a new hard quota shrinks
+ * only as it replaces its own pages.
+ */
+int set_table_quota(int64_t table_id, uint32_t soft_quota, uint32_t hard_quota) {
+    if (table_id < 0 || table_id >= MAX_BUF_TABLES ||
+        buffer_pool.table_chunks[table_id / BUF_TABLE_CHUNK_SIZE].load() == nullptr)
+        return 1;
+    if (hard_quota != 0 && soft_quota > hard_quota)
+        return 1;
+
+    std::lock_guard<std::mutex> guard(buffer_pool.quota_latch);
+    buf_table_info_t *table = get_table_info(table_id);
+    bool had_quota = table->soft_quota != 0 || table->hard_quota != 0;
+    bool has_quota = soft_quota != 0 || hard_quota != 0;
+    table->soft_quota = soft_quota;
+    table->hard_quota = hard_quota;
+    if (has_quota && !had_quota)
+        buffer_pool.num_quota_tables++;
+    else if (!has_quota && had_quota)
+        buffer_pool.num_quota_tables--;
+    return 0;
+}
+
+// descriptor 고유의 frame, mmap한 table의 page를 담는 동안에는 buf_page와 다름
+inline page_t *get_buffer_frame(const buf_descriptor_t *buf_desc) {
+    return buf_desc->frame;
 }
 
-int64_t buffer_open_table(const char *pathname) {
-    std::cout << "Entering buffer_open_table with pathname: " << pathname << std::endl;
-    std::cout << "Exiting buffer_open_table with table_id: " << file_open_table_file(pathname) << std::endl;
-    return file_open_table_file(pathname);
+/**
+ * @brief Log an update of a page and mark it dirty.
+ * 
+ * @param offset The first byte of the update in the page
+ * @param length The number of bytes updated
+ * @return The LSN to pass to wal_flush() to make the update durable, 0 if the
+ * log is not open.
+ * 
+ * @details Call after updating the page, while holding its exclusive latch
+ * (see mark_buffer_dirty()). The bytes are logged as they are now, and the
+ * page is not written to its file before the log is durable up to the
+ * returned LSN. Without an open log,
+ * this only marks the buffer dirty.
+ * 
+ * Redo restores only logged bytes, so every update of a table's pages should
+ * be logged for the table to be recovered exactly.
+ */
+lsn_t log_buffer_update(buf_descriptor_t *buf_desc, uint32_t offset, uint32_t length) {
+    if (buf_desc == nullptr || offset + length > buf_page_size(buf_desc)) {
+        buf_log_error("Error: invalid update in log_buffer_update.");
+        return 0;
+    }
+    // checkpoint가 redo 위치를 정하기 전에 dirty로 보여야 하므로 log보다 먼저 표시
+    mark_buffer_dirty(buf_desc);
+    if (!wal_is_open())
+        return 0;
+    buf_desc->page_lsn = wal_log_update(buf_desc->table_id, buf_desc->page_num, offset, length,
+                                        buf_desc->buf_page->data + offset);
+    if (buf_desc->rec_lsn == 0)
+        buf_desc->rec_lsn = buf_desc->page_lsn;
+    return buf_desc->page_lsn;
 }
 
 // MARK - dirty 상태를 표시하여, 나중에 flush할 수 있게 해준다. 
-void inline mark_buffer_dirty(buf_descriptor_t *buf_desc) {
-    std::cout << "Marking buffer as dirty: " << buf_desc << std::endl;
-//  TODO -----------------------------------------------------------------------
-    // flush_buffer(buf_desc);
+// page의 exclusive latch를 잡은 thread만 호출할 수 있음 (buffer.h 참고).
+void mark_buffer_dirty(buf_descriptor_t *buf_desc) {
+    buf_log_debug("Marking buffer as dirty: " << buf_desc);
     if (buf_desc == nullptr) {
-        std::cerr << "Error: buf_desc is nullptr in mark_buffer_dirty." << std::endl;
+        buf_log_error("Error: buf_desc is nullptr in mark_buffer_dirty.");
         return;
     }
-    buf_desc->is_dirty = true;
-//  ----------------------------------------------------------------------------
+    // latch 없이 고친 page는 낙관적 읽기가 알아챌 수 없고, 여기서 latch를 잡으면
+    // shared latch를 쥔 호출자가 자신을 기다리게 되므로 어느 build에서든 바로 멈춤
+    if (buf_desc->exclusive_owner.load(std::memory_order_relaxed) != std::this_thread::get_id()) {
+        buf_log_error("Error: mark_buffer_dirty() without the exclusive latch of page "
+                      << buf_desc->page_num << " of table " << buf_desc->table_id);
+        std::abort();
+    }
+    set_buffer_dirty(buf_desc);
 }
 
-void inline pin_buffer(buf_descriptor_t *buf_desc) {
+void inline pin_buffer(buf_descriptor_t *buf_desc, buf_strategy_t *strategy = nullptr) {
 //  TODO -----------------------------------------------------------------------
-    std::cout << "Pinning buffer: " << buf_desc << std::endl;
+    buf_log_debug("Pinning buffer: " << buf_desc);
     if (buf_desc == nullptr) {
-        std::cerr << "Error: buf_desc is nullptr in pin_buffer." << std::endl;
+        buf_log_error("Error: buf_desc is nullptr in pin_buffer.");
         return;
     }
     if (buf_desc->usage_count < 0) {
-        std::cerr << "Error: Invalid usage_count value for buf_desc: " << buf_desc << std::endl;
+        buf_log_error("Error: Invalid usage_count value for buf_desc: " << buf_desc);
     }
     // 페이지가 참조 중임을 표시
-    buf_desc->reference_count = 1;
-    // 최댓값을 넘진 않는 선에서 사용 횟수 증가
-    buf_desc->usage_count = std::min(buf_desc->usage_count + 1, MAX_USAGE_COUNT);
+    if (buf_desc->reference_count.fetch_add(1) == 0)
+        metric_pinned(1);
+    // 교체 정책에 참조를 알림 (CLOCK은 usage_count 증가)
+    // strategy를 통한 접근은 공유 pool에서 승격시키지 않고, 교체 직전인 경우만 살려둠
+    if (strategy == nullptr) {
+        buffer_pool.policy->on_hit(buf_desc);
+    } else {
+        int usage_count = 0;
+        buf_desc->usage_count.compare_exchange_strong(usage_count, 1);
+    }
 //  ----------------------------------------------------------------------------
 }
 
-// MARK - freelist에 buf_descriptor 추가
-void add_to_freelist(buf_descriptor_t *buf_desc) {
-    if (buf_desc == nullptr) {
-        std::cerr << "Attempted to add a nullptr buf_desc to freelist." << std::endl;
+/**
+ * @brief Wait until the page of a pinned buffer has been read.
+ * 
+ * @details The thread loading a page holds the buffer's I/O latch until
+ * file_read_page() is done, so taking the I/O latch once is enough to wait.
+ * A prefetched page is read by an I/O thread after the I/O latch is released,
+ * so if the page is still not valid, wait for set_buffer_valid().
+ */
+void inline wait_buffer_valid(buf_descriptor_t *buf_desc) {
+    if (buf_desc->is_valid)
         return;
+    {
+        std::lock_guard<std::mutex> guard(buf_desc->io_latch);
+    }
+    if (!buf_desc->is_valid) {
+        std::unique_lock<std::mutex> lock(buffer_pool.io_wait_latch);
+        buffer_pool.io_wait_cond.wait(lock, [buf_desc] { return buf_desc->is_valid.load(); });
     }
-    free_list_node* new_node = new free_list_node{buf_desc, buffer_pool.free_list_head};
+}
+
+// I/O latch 없이 읽은 page(prefetch)를 유효로 표시하고 기다리는 thread들을 깨움
+void set_buffer_valid(buf_descriptor_t *buf_desc) {
+    {
+        std::lock_guard<std::mutex> guard(buffer_pool.io_wait_latch);
+        buf_desc->is_valid = true;
+    }
+    buffer_pool.io_wait_cond.notify_all();
+}
 
-    if (new_node == nullptr) { // 추가된 검사
-        std::cerr << "Error: Failed to allocate memory for new freelist node." << std::endl;
+// freelist head의 tag와 index를 하나의 64bit word로 묶고 푸는 macro
+#define free_list_pack(tag, index) ((((uint64_t)(tag)) << 32) | (uint32_t)(index))
+#define free_list_tag(head) ((uint32_t)((head) >> 32))
+#define free_list_index(head) ((uint32_t)(head))
+
+// MARK - freelist에 buf_descriptor 추가
+/**
+ * @brief Push an unmapped buffer onto the freelist.
+ * 
+ * @details The freelist is a lock-free stack linked through free_next of the
+ * descriptors, so no memory is allocated. Every push and pop increments the
+ * tag in the head word, so a CAS fails if the head was popped and pushed back
+ * in the meantime (ABA).
+ * 
+ * A buffer in the freelist keeps a reference count of 1 owned by the
+ * freelist, so the clock sweep never takes it. The caller must hand over that
+ * pin, i.e. the buffer must be unmapped and pinned only by the caller.
+ * 
+ * Each size class has its own freelist.
+ */
+void add_to_freelist(buf_descriptor_t *buf_desc) {
+    if (buf_desc == nullptr) {
+        buf_log_error("Attempted to add a nullptr buf_desc to freelist.");
         return;
     }
-    buffer_pool.free_list_head = new_node;
+    buf_size_class_t *size_class = &buffer_pool.size_classes[buf_desc->size_class];
+    uint32_t index = buf_desc - buffer_pool.buf_descriptors;
+    uint64_t head = size_class->free_list_head.load();
+    do {
+        buf_desc->free_next = free_list_index(head);
+    } while (!size_class->free_list_head.compare_exchange_weak(
+                 head, free_list_pack(free_list_tag(head) + 1, index)));
+    size_class->num_free++;
 }
 
 // MARK - freelist 초기화 
 void init_freelist() {
-    std::cout << "Initializing freelist" << std::endl;
-    buffer_pool.free_list_head = nullptr;
+    buf_log_info("Initializing freelist");
     int count = 0;
-    for (uint32_t i = 0; i<buffer_pool.num_buf; i++) {
-        add_to_freelist(&buffer_pool.buf_descriptors[i]);
-        count++;
+    for (uint32_t c = 0; c < buffer_pool.num_size_classes; c++) {
+        buf_size_class_t *size_class = &buffer_pool.size_classes[c];
+        size_class->free_list_head = free_list_pack(0, FREE_LIST_END);
+        size_class->num_free = 0;
+        // 배열 앞쪽 descriptor부터 나가도록 역순으로 추가
+        for (uint32_t i = size_class->first_buf + size_class->num_buf; i-- > size_class->first_buf;) {
+            // freelist가 소유하는 pin
+            buffer_pool.buf_descriptors[i].reference_count = 1;
+            add_to_freelist(&buffer_pool.buf_descriptors[i]);
+            count++;
+        }
     }
-    std::cout << "freelist에 " << count << "개 buf_descriptor 추가" << std::endl;
+    buf_log_info("freelist에 " << count << "개 buf_descriptor 추가");
 }
 
 // MARK - freelist에서 buf_descriptor 반환
-buf_descriptor_t* get_from_freelist() {
-    std::cout << "Getting from freelist" << std::endl;
-    // freelist가 비어 있으면 nullptr 반환
-    if (buffer_pool.free_list_head == nullptr) {
-        std::cerr << "Error: freelist is empty." << std::endl;
-        return nullptr;
-    }
-
-    free_list_node* free_node = buffer_pool.free_list_head;
-    buffer_pool.free_list_head = free_node->next;
-
-    buf_descriptor_t* buf_desc = free_node->buf_desc;
-    std::cout << "Returning from freelist: " << buf_desc << std::endl;
-    delete free_node;
-
+/**
+ * @brief Pop an unmapped buffer from the freelist of a size class.
+ * 
+ * @return The buffer, already pinned for the caller, or nullptr if the
+ * freelist is empty.
+ */
+buf_descriptor_t* get_from_freelist(uint32_t size_class) {
+    buf_size_class_t *buf_class = &buffer_pool.size_classes[size_class];
+    uint64_t head = buf_class->free_list_head.load();
+    buf_descriptor_t* buf_desc;
+    do {
+        // freelist가 비어 있으면 nullptr 반환
+        if (free_list_index(head) == FREE_LIST_END)
+            return nullptr;
+        buf_desc = &buffer_pool.buf_descriptors[free_list_index(head)];
+        // 그 사이 다른 thread가 pop했다면 free_next가 달라졌어도 tag 때문에 CAS가 실패함
+    } while (!buf_class->free_list_head.compare_exchange_weak(
+                 head, free_list_pack(free_list_tag(head) + 1, buf_desc->free_next.load())));
+    buf_class->num_free--;
+
+    buf_log_debug("Returning from freelist: " << buf_desc);
     return buf_desc;
 }
 
 
-void inline unpin_buffer(buf_descriptor_t *buf_desc) {
+void unpin_buffer(buf_descriptor_t *buf_desc) {
 //  TODO -----------------------------------------------------------------------
-    std::cout << "Unpinning buffer: " << buf_desc << std::endl;
+    buf_log_debug("Unpinning buffer: " << buf_desc);
     if (buf_desc == nullptr) {
-        std::cerr << "Error: buf_desc is nullptr in unpin_buffer." << std::endl;
+        buf_log_error("Error: buf_desc is nullptr in unpin_buffer.");
         return;
     }
     // 페이지 참조를 해제
-    buf_desc->reference_count = 0;
+    int reference_count = buf_desc->reference_count.fetch_sub(1);
+    if (reference_count <= 0) {
+        // pin하지 않은 버퍼를 unpin하면 다른 사용자의 pin을 빼앗게 되므로 되돌림
+        buf_log_error("Error: unpin_buffer called on unpinned buf_desc: " << buf_desc);
+        buf_desc->reference_count.fetch_add(1);
+        return;
+    }
+    if (reference_count == 1)
+        metric_pinned(-1);
+//  ----------------------------------------------------------------------------
+}
+
+/**
+ * @brief Acquire the content latch of a pinned buffer.
+ * 
+ * @details Shared latches let index scans read hot pages such as the root
+ * together, while a split or an update takes the exclusive latch. The latch
+ * is not recursive, so a thread must not latch the same page twice in
+ * exclusive mode.
+ */
+void latch_buffer(buf_descriptor_t *buf_desc, buf_latch_mode_t mode) {
+    if (mode == BUF_LATCH_SHARED) {
+        buf_desc->content_latch.lock_shared();
+    } else if (mode == BUF_LATCH_EXCLUSIVE) {
+        buf_desc->content_latch.lock();
+        buf_desc->exclusive_owner.store(std::this_thread::get_id(), std::memory_order_relaxed);
+        // 홀수가 되어 낙관적 읽기가 수정 중임을 알 수 있음
+        buf_desc->version++;
+    }
+}
 
-    // 해제된 페이지를 freelist에 추가
-    add_to_freelist(buf_desc);
+void unlatch_buffer(buf_descriptor_t *buf_desc, buf_latch_mode_t mode) {
+    if (mode == BUF_LATCH_SHARED) {
+        buf_desc->content_latch.unlock_shared();
+    } else if (mode == BUF_LATCH_EXCLUSIVE) {
+        buf_desc->version++;
+        buf_desc->exclusive_owner.store(std::thread::id(), std::memory_order_relaxed);
+        buf_desc->content_latch.unlock();
+    }
+}
 
-    // free(buf_desc->buf_page);
-    // free(buf_desc);
-//  ----------------------------------------------------------------------------
+/**
+ * @brief Release a buffer returned by get_buffer() with the given mode.
+ * 
+ * @details Release the content latch and then the pin.
+ */
+void release_buffer(buf_descriptor_t *buf_desc, buf_latch_mode_t mode) {
+    if (buf_desc == nullptr) {
+        buf_log_error("Error: buf_desc is nullptr in release_buffer.");
+        return;
+    }
+    unlatch_buffer(buf_desc, mode);
+    unpin_buffer(buf_desc);
+}
+
+// partition 하나에 num_slots개의 빈 slot을 가진 배열을 할당, 실패하면 nullptr
+ht_slots_t *alloc_ht_slots(uint32_t num_slots) {
+    // slot 4개가 cache line 하나에 맞도록 정렬, 배열은 header 바로 뒤에 둠
+    void *block = std::aligned_alloc(64, sizeof(ht_slots_t) + sizeof(ht_entry_t) * (size_t)num_slots);
+    if (block == nullptr)
+        return nullptr;
+    ht_slots_t *slots = new (block) ht_slots_t;
+    slots->num_slots = num_slots;
+    slots->next_retired = nullptr;
+    slots->entries = (ht_entry_t *)((char *)block + sizeof(ht_slots_t));
+    for (uint32_t i = 0; i < num_slots; i++) {
+        ht_entry_t *ht_entry = new (&slots->entries[i]) ht_entry_t;
+        ht_entry->key = 0;
+        ht_entry->buf_index = 0;
+        ht_entry->probe_len = 0;
+    }
+    return slots;
+}
+
+// 각 partition이 num_ht_entries를 고르게 나눠 가질 때의 slot 수 (2의 거듭제곱, 8 이상)
+uint32_t get_ht_partition_slots(uint64_t num_ht_entries) {
+    uint64_t num_slots = 8;
+    while (num_slots * buffer_pool.hashtable.num_partitions < num_ht_entries)
+        num_slots *= 2;
+    return num_slots;
 }
 
 /**
  * @brief Initialize the hashtable of the buffer pool.
  * 
  * @param num_ht_entries The number of hashtable entries
+ * @param num_buf The number of buffers to be mapped by the hashtable
+ * 
+ * @details Initialize the hashtable using num_ht_entries. The hashtable uses
+ * open addressing, so it has at least twice as many slots as buffers (load
+ * factor <= 50%), rounded up to a power of two per partition. Each partition
+ * has its own slot array, allocated here once. Only resize_hashtable() and
+ * resize_buffer_pool() replace it, one partition at a time.
  * 
- * @details Initialize the hashtable using num_ht_entries. 
+ * A single partition (BUF_HT_SINGLE_LATCH) holds exactly the mapped buffers,
+ * so there num_ht_entries may go down to num_buf, up to a load factor of
+ * 100%. Several partitions keep the 2 * num_buf floor, since a partition
+ * holding more than its share must still have room.
+ * 
+ * The number of partitions is chosen so that a partition holds at least
+ * MIN_BUF_PER_HT_PARTITION buffers on average, which makes it practically
+ * impossible for a partition to fill up while others have room. It does not
+ * change when the pool is resized. With BUF_HT_SINGLE_LATCH (see
+ * set_ht_latch_mode()) there is one partition.
  */
-void init_hashtable(uint32_t num_ht_entries) {
-    std::cout << "Initializing hashtable with num_ht_entries: " << num_ht_entries << std::endl;
-    buffer_pool.hashtable.num_ht_entries = num_ht_entries;
+int init_hashtable(uint32_t num_ht_entries, uint32_t num_buf) {
+    buf_log_info("Initializing hashtable with num_ht_entries: " << num_ht_entries);
 //  TODO -----------------------------------------------------------------------
-    buffer_pool.hashtable.ht_entries = new ht_entry_t[num_ht_entries];
+    uint32_t max_partitions =
+        buffer_pool.hashtable.latch_mode == BUF_HT_SINGLE_LATCH ? 1 : NUM_HT_PARTITIONS;
+    uint32_t num_partitions = 1;
+    while (num_partitions * 2 <= max_partitions &&
+           num_partitions * 2 * MIN_BUF_PER_HT_PARTITION <= num_buf)
+        num_partitions *= 2;
+    buffer_pool.hashtable.num_partitions = num_partitions;
+
+    uint64_t min_entries = num_partitions == 1 ? num_buf : (uint64_t)num_buf * 2;
+    uint32_t num_slots = get_ht_partition_slots(std::max<uint64_t>(num_ht_entries, min_entries));
+    buffer_pool.hashtable.num_ht_entries = (uint64_t)num_slots * num_partitions;
+    buffer_pool.hashtable.retired_slots = nullptr;
+
+    buffer_pool.hashtable.partitions = new ht_partition_t[num_partitions];
+    for (uint32_t i = 0; i < num_partitions; i++) {
+        ht_partition_t *partition = &buffer_pool.hashtable.partitions[i];
+        partition->num_used = 0;
+        partition->version = 0;
+        partition->slots = alloc_ht_slots(num_slots);
+        if (partition->slots == nullptr) {
+            buf_log_error("Error: Failed to allocate memory for hashtable entries.");
+            return 1;
+        }
+    }
+//  ----------------------------------------------------------------------------
+    return 0;
+}
 
-    if (buffer_pool.hashtable.ht_entries == nullptr) {
-        std::cerr << "Error: Failed to allocate memory for hashtable entries." << std::endl;
-        return;
+/**
+ * @brief Construct the descriptors [first, last) of a size class and touch
+ * their pages.
+ * 
+ * @param arena The frame arena that holds the frames of the descriptors
+ * @param arena_first The descriptor (within the class) of the arena's first
+ * frame
+ * 
+ * @details The first write to a page of the arenas allocates it on the NUMA
+ * node of the writing thread, unless arena_place() fixed its node already.
+ */
+void init_buf_descriptors(uint32_t size_class, uint32_t first, uint32_t last,
+                          const arena_t *arena, uint32_t arena_first) {
+    buf_size_class_t *buf_class = &buffer_pool.size_classes[size_class];
+    uint32_t num_file_pages = buf_class->page_size / PAGE_SIZE;
+    for (uint32_t i = first; i < last; i++) {
+        buf_descriptor_t *buf_desc =
+            new (&buffer_pool.buf_descriptors[buf_class->first_buf + i]) buf_descriptor_t;
+        page_t *frame = (page_t *)arena->addr + (size_t)(i - arena_first) * num_file_pages;
+        buf_desc->table_id = -1;        // 비유효 값
+        buf_desc->page_num = -1;        // 비유효 값
+        buf_desc->frame = frame;
+        buf_desc->buf_page = frame;     // 페이지 메모리 연결
+        buf_desc->size_class = size_class;
+        buf_desc->reference_count = 0;  // 참조되지 않음
+        buf_desc->usage_count = 0;      // 사용되지 않음
+        buf_desc->is_dirty = false;     // 수정되지 않음
+        buf_desc->is_valid = false;     // 읽은 페이지 없음
+        buf_desc->is_prefetched = false;
+        buf_desc->is_kept = false;
+        buf_desc->page_lsn = 0;
+        buf_desc->rec_lsn = 0;
+        buf_desc->version = 0;
+        buf_desc->exclusive_owner = std::thread::id();
+        buf_desc->swip = nullptr;
+        // mmap한 page는 0으로 채워져 있으므로 한 번 써서 할당만 받음
+        for (uint32_t j = 0; j < num_file_pages; j++)
+            frame[j].data[0] = 0;
+    }
+}
+
+/**
+ * @brief Allocate and initialize the descriptor array and the frame arrays
+ * of the size classes.
+ * 
+ * @retval 0: successful
+ * @retval others: failed
+ * 
+ * @details All arrays are mmap'ed, with huge pages if possible (see
+ * arena_alloc()), and placed on the NUMA nodes by numa_mode. With
+ * BUF_NUMA_PARTITION, each array is split over the nodes, so with a single
+ * size class the descriptors of a node's pages are on the same node.
+ * 
+ * The descriptor array is reserved for max_num_buf descriptors, so that
+ * resize_buffer_pool() can grow a class in place. Only the initial
+ * descriptors are placed and touched, the rest take no memory until used.
+ * 
+ * The arrays are initialized by several threads, one per node when
+ * partitioned, so that a pool of many GB starts quickly and its memory is
+ * first touched where it is placed.
+ */
+int init_buf_arrays(buf_numa_mode_t numa_mode) {
+    uint32_t num_buf = buffer_pool.num_buf;
+    uint32_t num_classes = buffer_pool.num_size_classes;
+    if (num_classes == 0)
+        return 1;
+    if (arena_reserve(&buffer_pool.desc_arena,
+                      sizeof(buf_descriptor_t) * (size_t)buffer_pool.max_num_buf))
+        return 1;
+    buffer_pool.buf_descriptors = (buf_descriptor_t *)buffer_pool.desc_arena.addr;
+    for (uint32_t c = 0; c < num_classes; c++) {
+        buf_size_class_t *size_class = &buffer_pool.size_classes[c];
+        arena_t page_arena = {};
+        if (arena_alloc(&page_arena, (size_t)size_class->page_size * size_class->num_buf)) {
+            while (c-- > 0)
+                arena_free(&buffer_pool.size_classes[c].page_arenas[0]);
+            arena_free(&buffer_pool.desc_arena);
+            return 1;
+        }
+        size_class->page_arenas.assign(1, page_arena);
+    }
+
+    // 처음 쓰는 descriptor까지만 배치, class 사이의 예비 구간은 늘릴 때 처음 씀
+    uint32_t last = buffer_pool.size_classes[num_classes - 1].first_buf +
+                    buffer_pool.size_classes[num_classes - 1].num_buf;
+    bool is_placed = arena_place(&buffer_pool.desc_arena, sizeof(buf_descriptor_t), last,
+                                 numa_mode) == 0;
+    for (uint32_t c = 0; c < num_classes && is_placed; c++) {
+        buf_size_class_t *size_class = &buffer_pool.size_classes[c];
+        is_placed = arena_place(&size_class->page_arenas[0], size_class->page_size,
+                                size_class->num_buf, numa_mode) == 0;
     }
-    
-    for (uint32_t i = 0; i < num_ht_entries; i++) {
-        buffer_pool.hashtable.ht_entries[i].buf_desc = nullptr;
-        buffer_pool.hashtable.ht_entries[i].next = nullptr;
+    if (!is_placed) {
+        buf_log_info("NUMA is not available, using the default memory placement.");
+        numa_mode = BUF_NUMA_NONE;
     }
-//  ----------------------------------------------------------------------------
-    
+    buffer_pool.numa_mode = numa_mode;
+
+    uint32_t num_threads;
+    if (numa_mode == BUF_NUMA_PARTITION) {
+        num_threads = arena_num_nodes();
+    } else {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+        num_threads = std::max(1u, std::min(num_threads, num_buf / MIN_BUF_PER_INIT_THREAD));
+    }
+
+    if (num_threads == 1) {
+        for (uint32_t c = 0; c < num_classes; c++)
+            init_buf_descriptors(c, 0, buffer_pool.size_classes[c].num_buf,
+                                 &buffer_pool.size_classes[c].page_arenas[0], 0);
+    } else {
+        std::vector<std::thread> threads;
+        for (uint32_t i = 0; i < num_threads; i++) {
+            threads.emplace_back([i, num_threads, num_classes, numa_mode] {
+                if (numa_mode == BUF_NUMA_PARTITION)
+                    arena_bind_thread(i);
+                // class마다 node의 몫을 맡아, frame이 배치된 node에서 처음 씀
+                for (uint32_t c = 0; c < num_classes; c++) {
+                    uint64_t first, last;
+                    arena_node_range(buffer_pool.size_classes[c].num_buf, i, num_threads,
+                                     &first, &last);
+                    init_buf_descriptors(c, first, last,
+                                         &buffer_pool.size_classes[c].page_arenas[0], 0);
+                }
+            });
+        }
+        for (std::thread &thread : threads)
+            thread.join();
+    }
+
+    for (uint32_t c = 0; c < num_classes; c++) {
+        buf_size_class_t *size_class = &buffer_pool.size_classes[c];
+        buf_log_info("Buffer pages: " << size_class->num_buf << " frames of "
+                     << (size_class->page_size >> 10) << "KB in "
+                     << (size_class->page_arenas[0].size >> 20) << "MB with "
+                     << (size_class->page_arenas[0].page_size >> 10) << "KB pages, up to "
+                     << size_class->max_num_buf << " frames");
+    }
+    buf_log_info("Buffer pool initialized by " << num_threads << " threads");
+    return 0;
+}
+
+/**
+ * @brief Choose the latch layout of the hashtable of the next
+ * init_buffer_pool().
+ * 
+ * @details BUF_HT_PARTITIONED is the default. BUF_HT_SINGLE_LATCH puts every
+ * page behind one partition latch, which is how a pool without partitions
+ * scales, and is meant for comparing the two.
+ */
+void set_ht_latch_mode(buf_ht_latch_mode_t mode) {
+    buffer_pool.hashtable.latch_mode = mode;
 }
 
 /**
@@ -152,49 +811,140 @@ void init_hashtable(uint32_t num_ht_entries) {
  * 
  * @param num_ht_entries The number of hashtable entries
  * @param num_buf The number of buffer (descriptor and page)
+ * @param policy The buffer replacement policy
+ * @param numa_mode The placement of the buffers on NUMA nodes
  * @retval 0: successful
  * @retval others: failed
  * 
  * @details The num_buf must be greater or equal than 4 
  * (The splitting, deleting operation pins 3 page at once) + (header page)
+ * 
+ * All buffers hold PAGE_SIZE pages.
+ */
+int init_buffer_pool(uint32_t num_ht_entries, uint32_t num_buf,
+                     buf_policy_kind_t policy, buf_numa_mode_t numa_mode) {
+    buf_size_class_config_t size_class = {PAGE_SIZE, num_buf, 0};
+    return init_buffer_pool(num_ht_entries, &size_class, 1, policy, numa_mode);
+}
+
+/**
+ * @brief Initialize the buffer pool with several page size classes.
+ * 
+ * @param num_ht_entries The number of hashtable entries
+ * @param size_classes The page size and the number of buffers of each class
+ * @param num_size_classes The number of classes, at most MAX_SIZE_CLASSES
+ * @param policy The buffer replacement policy
+ * @param numa_mode The placement of the buffers on NUMA nodes
+ * @retval 0: successful
+ * @retval others: failed
+ * 
+ * @details Each class has its own frame array, freelist and replacement
+ * state, so small index pages and large overflow pages do not compete for
+ * the same frames, and no frame is larger than the pages it holds. One
+ * hashtable maps the pages of all classes. A table's pages go to the class of
+ * the page size given to buffer_open_table().
+ * 
+ * Page sizes must be distinct multiples of PAGE_SIZE up to MAX_BUF_PAGE_SIZE,
+ * and each class needs at least 4 buffers, like a single-class pool.
  */
-int init_buffer_pool(uint32_t num_ht_entries, uint32_t num_buf) {
+int init_buffer_pool(uint32_t num_ht_entries, const buf_size_class_config_t *size_classes,
+                     uint32_t num_size_classes, buf_policy_kind_t policy,
+                     buf_numa_mode_t numa_mode) {
     // buf_descriptor_t *buf;
-    std::cout << "Initializing buffer pool with num_ht_entries: " << num_ht_entries << ", num_buf: " << num_buf << std::endl;
+    if (num_size_classes == 0 || num_size_classes > MAX_SIZE_CLASSES)
+        return 1;
 
-    if (num_buf < 4)
+    std::vector<buf_size_class_config_t> configs(size_classes, size_classes + num_size_classes);
+    std::sort(configs.begin(), configs.end(),
+              [](const buf_size_class_config_t &a, const buf_size_class_config_t &b) {
+                  return a.page_size < b.page_size;
+              });
+    uint64_t num_buf = 0;
+    uint64_t max_num_buf = 0;
+    for (uint32_t c = 0; c < num_size_classes; c++) {
+        if (configs[c].num_buf < 4 || configs[c].page_size % PAGE_SIZE != 0 ||
+            configs[c].page_size == 0 || configs[c].page_size > MAX_BUF_PAGE_SIZE ||
+            (c > 0 && configs[c].page_size == configs[c - 1].page_size))
+            return 1;
+        if (configs[c].max_num_buf == 0)
+            configs[c].max_num_buf = std::min<uint64_t>(
+                (uint64_t)configs[c].num_buf * BUF_DEFAULT_GROWTH, FREE_LIST_END - 1);
+        if (configs[c].max_num_buf < configs[c].num_buf)
+            return 1;
+        num_buf += configs[c].num_buf;
+        max_num_buf += configs[c].max_num_buf;
+    }
+    if (num_buf >= FREE_LIST_END)
+        return 1;
+    // 정하지 않은 상한은 descriptor index가 FREE_LIST_END에 닿지 않게 줄임
+    for (uint32_t c = 0; c < num_size_classes && max_num_buf >= FREE_LIST_END; c++) {
+        uint64_t excess = std::min<uint64_t>(max_num_buf - (FREE_LIST_END - 1),
+                                             configs[c].max_num_buf - configs[c].num_buf);
+        configs[c].max_num_buf -= excess;
+        max_num_buf -= excess;
+    }
+    buf_log_info("Initializing buffer pool with num_ht_entries: " << num_ht_entries << ", num_buf: "
+                 << num_buf << " in " << num_size_classes << " size classes");
+
+    buffer_pool.policy = get_buf_policy(policy);
+    if (buffer_pool.policy == nullptr)
         return 1;
 
     if (init_tables())
         return 1;
 
-    init_hashtable(num_ht_entries);
+    if (aio_init())
+        return 1;
+
+    if (init_hashtable(num_ht_entries, num_buf))
+        return 1;
 
 //  TODO -----------------------------------------------------------------------
     buffer_pool.num_buf = num_buf;
-    buffer_pool.buf_descriptors = new buf_descriptor_t[num_buf];
-    buffer_pool.buf_pages = new page_t[num_buf];
-
-    buffer_pool.clock_hand = 0;
-    if (buffer_pool.buf_descriptors == nullptr || buffer_pool.buf_pages == nullptr) {
-        std::cerr << "Error: Failed to allocate memory for buffer pool." << std::endl;
+    buffer_pool.max_num_buf = max_num_buf;
+    buffer_pool.num_size_classes = num_size_classes;
+    buffer_pool.max_page_size = configs.back().page_size;
+    uint32_t first_buf = 0;
+    for (uint32_t c = 0; c < num_size_classes; c++) {
+        buf_size_class_t *size_class = &buffer_pool.size_classes[c];
+        size_class->page_size = configs[c].page_size;
+        size_class->first_buf = first_buf;
+        size_class->num_buf = configs[c].num_buf;
+        size_class->max_num_buf = configs[c].max_num_buf;
+        size_class->num_init_buf = configs[c].num_buf;
+        size_class->clock_hand = 0;
+        size_class->num_prefetching = 0;
+        size_class->num_kept = 0;
+        first_buf += configs[c].max_num_buf;
+    }
+    // table 정보는 table을 열 때 할당
+    for (std::atomic<buf_table_info_t *> &chunk : buffer_pool.table_chunks)
+        chunk = nullptr;
+    buffer_pool.num_quota_tables = 0;
+    if (init_buf_arrays(numa_mode)) {
+        buf_log_error("Error: Failed to allocate memory for buffer pool.");
         return 1;
     }
 
-    // freelist 초기화 및 각 buf_descriptor의 buf_page 메모리 할당
-    for (uint32_t i = 0; i < num_buf; i++) {
-        buffer_pool.buf_descriptors[i].table_id = -1;        // 비유효 값
-        buffer_pool.buf_descriptors[i].page_num = -1;        // 비유효 값
-        buffer_pool.buf_descriptors[i].buf_page = &buffer_pool.buf_pages[i]; // 페이지 메모리 연결
-        buffer_pool.buf_descriptors[i].reference_count = 0;  // 참조되지 않음
-        buffer_pool.buf_descriptors[i].usage_count = 0;      // 사용되지 않음
-        buffer_pool.buf_descriptors[i].is_dirty = false;     // 수정되지 않음
-    }
+    // summary word 하나가 dirty_bitmap의 64 word (4096 buffer)를 나타냄
+    // 늘어난 buffer도 담도록 descriptor 배열 전체에 대해 만듦
+    uint32_t num_dirty_words = (max_num_buf + 63) / 64;
+    buffer_pool.dirty_bitmap = new std::atomic<uint64_t>[num_dirty_words]();
+    buffer_pool.dirty_summary = new std::atomic<uint64_t>[(num_dirty_words + 63) / 64]();
+
+    set_readahead_window(READAHEAD_WINDOW);
+    for (uint32_t i = 0; i < NUM_READAHEAD_SLOTS; i++)
+        buffer_pool.readahead[i].table_id = -1;
 
     init_freelist();
+
+    // 늘어날 buffer의 index까지 담도록 descriptor 배열 전체로 초기화
+    if (buffer_pool.policy->init(max_num_buf))
+        return 1;
+    buf_log_info("Using " << buffer_pool.policy->name << " replacement policy");
 //  ----------------------------------------------------------------------------
     init_buffer_stat();
-    std::cout << "Buffer pool initialized successfully" << std::endl;
+    buf_log_info("Buffer pool initialized successfully");
 
     return 0;
 }
@@ -208,10 +958,44 @@ int init_buffer_pool(uint32_t num_ht_entries, uint32_t num_buf) {
  * of your own.
  */
 
-#define hash(table_id, page_num) \
-    ((((uint64_t)table_id) * 100000 + page_num)%(buffer_pool.hashtable.num_ht_entries))
-#define get_ht_entry(table_id, page_num) \
-    (&(buffer_pool.hashtable.ht_entries[hash(table_id, page_num)]))
+// 연속된 page_num도 고르게 퍼지도록 key의 모든 bit를 섞음 (MurmurHash3 finalizer)
+inline uint64_t hash(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return key;
+}
+
+// 상위 32bit로 partition을, 하위 bit로 partition 안의 home slot을 정함
+#define ht_partition_of(hash_value) \
+    ((uint32_t)((hash_value) >> 32) & (buffer_pool.hashtable.num_partitions - 1))
+#define get_ht_partition(table_id, page_num) \
+    ht_partition_of(hash(ht_key(table_id, page_num)))
+#define get_ht_slots(partition) \
+    (buffer_pool.hashtable.partitions[partition].slots.load(std::memory_order_acquire))
+
+/**
+ * @brief Lock the hashtable partitions of two pages in partition order.
+ * 
+ * @details Locking in a fixed order keeps two threads that replace buffers of
+ * each other's partitions from deadlocking. A partition is locked only once
+ * when both pages fall into it.
+ */
+void lock_ht_partitions(uint32_t first, uint32_t second) {
+    if (first > second)
+        std::swap(first, second);
+    buffer_pool.hashtable.partitions[first].latch.lock();
+    if (first != second)
+        buffer_pool.hashtable.partitions[second].latch.lock();
+}
+
+void unlock_ht_partitions(uint32_t first, uint32_t second) {
+    buffer_pool.hashtable.partitions[first].latch.unlock();
+    if (first != second)
+        buffer_pool.hashtable.partitions[second].latch.unlock();
+}
 
 //  ----------------------------------------------------------------------------
 
@@ -219,179 +1003,602 @@ int init_buffer_pool(uint32_t num_ht_entries, uint32_t num_buf) {
  * @brief Look up the buffer(page) in hashtable.
  * 
  * @return The memory address of the found buffer descriptor.
+ * 
+ * @details The caller must hold the latch of the page's partition.
+ * 
+ * Probing stops at an empty slot, or at a slot whose entry is closer to its
+ * home slot than the probe is, since Robin Hood insertion would have placed
+ * the key there otherwise.
  */
 inline buf_descriptor_t *hashtable_lookup(int64_t table_id, pagenum_t page_num) {
-    // hashtable로 부터 일치하는 buf_descriptor를 불러옴
-    ht_entry_t *ht_entry = get_ht_entry(table_id, page_num);
-    if (ht_entry == nullptr) { // 추가된 검사
-        std::cerr << "Error: hashtable entry is nullptr in hashtable_lookup." << std::endl;
-        return nullptr;
-    }
-
-    // buf_descriptor_t *buf_desc;
-    std::cout << "Looking up hashtable entry for table_id: " << table_id << ", page_num: " << page_num << ", hash entry: " << ht_entry << std::endl;
+    uint64_t key = ht_key(table_id, page_num);
+    uint64_t hash_value = hash(key);
+    ht_slots_t *ht_slots = get_ht_slots(ht_partition_of(hash_value));
+    uint32_t mask = ht_slots->num_slots - 1;
+    ht_entry_t *slots = ht_slots->entries;
+    uint32_t pos = hash_value & mask;
 
 //  TODO -----------------------------------------------------------------------
-    // 해당 entry의 체인을 따라가며 t_id, p_id 일치 시 해당 buf_descriptor return
-    while (ht_entry) {
-      if (ht_entry->buf_desc && 
-          ht_entry->buf_desc->table_id == table_id &&
-          ht_entry->buf_desc->page_num == page_num) {
-        std::cout << "Found hashtable entry: " << ht_entry->buf_desc << std::endl;
-        return ht_entry->buf_desc;
-      }
-      ht_entry = ht_entry->next; // 체이닝된 다음 노드로 이동
+    // home slot부터 차례로 비교하며 key 일치 시 해당 buf_descriptor return
+    for (uint32_t probe_len = 1; probe_len <= mask + 1; probe_len++) {
+        ht_entry_t *ht_entry = &slots[pos];
+        if (ht_entry->probe_len < probe_len) // 빈 slot이거나 더 가까운 entry
+            break;
+        if (ht_entry->key == key) {
+            buf_log_debug("Found hashtable entry: " << ht_entry);
+            trace_event(TRACE_LOOKUP, table_id, page_num, ht_entry->buf_index);
+            return &buffer_pool.buf_descriptors[ht_entry->buf_index];
+        }
+        pos = (pos + 1) & mask;
     }
 //  ----------------------------------------------------------------------------
-    std::cerr << "Hashtable entry not found for table_id: " << table_id << ", page_num: " << page_num << std::endl;
+    buf_log_debug("Hashtable entry not found for table_id: " << table_id << ", page_num: " << page_num);
+    trace_event(TRACE_LOOKUP, table_id, page_num, TRACE_NO_BUF);
 
     return nullptr; // 일치하는 항목이 없으면 nullptr 반환
 }
 
+// Robin Hood 방식으로 slot 배열에 entry 하나를 넣음, 빈 slot이 있어야 함
+inline void ht_slots_insert(ht_slots_t *ht_slots, uint64_t key, uint64_t hash_value,
+                            uint32_t buf_index) {
+    uint32_t mask = ht_slots->num_slots - 1;
+    ht_entry_t *slots = ht_slots->entries;
+    uint32_t pos = hash_value & mask;
+
+    uint64_t entry_key = key;
+    uint32_t entry_index = buf_index;
+    uint32_t entry_probe_len = 1;
+    while (true) {
+        ht_entry_t *ht_entry = &slots[pos];
+        uint32_t probe_len = ht_entry->probe_len;
+        // 빈 slot을 찾으면 남은 entry를 넣고 끝
+        if (probe_len == 0) {
+            ht_entry->key = entry_key;
+            ht_entry->buf_index = entry_index;
+            ht_entry->probe_len = entry_probe_len;
+            break;
+        }
+        // home slot에 더 가까운 entry와 자리를 바꾸고, 밀려난 entry로 계속 탐색
+        if (probe_len < entry_probe_len) {
+            uint64_t displaced_key = ht_entry->key;
+            uint32_t displaced_index = ht_entry->buf_index;
+            ht_entry->key = entry_key;
+            ht_entry->buf_index = entry_index;
+            ht_entry->probe_len = entry_probe_len;
+            entry_key = displaced_key;
+            entry_index = displaced_index;
+            entry_probe_len = probe_len;
+        }
+        entry_probe_len++;
+        pos = (pos + 1) & mask;
+    }
+}
+
+/**
+ * @brief Move the entries of a hashtable partition to a new slot array of
+ * num_slots slots.
+ * 
+ * @retval true: successful
+ * @retval false: out of memory, or num_slots cannot hold the entries
+ * 
+ * @details The caller must hold the resize latch and the latch of the
+ * partition. Lookups of other partitions go on meanwhile. An optimistic
+ * lookup that read the old array fails its version check, and the old array
+ * is kept until close_buffer_pool() since such a lookup may still be reading
+ * it.
+ */
+bool rehash_ht_partition(uint32_t partition, uint32_t num_slots) {
+    ht_partition_t *ht_partition = &buffer_pool.hashtable.partitions[partition];
+    ht_slots_t *old_slots = ht_partition->slots;
+    if (num_slots == old_slots->num_slots)
+        return true;
+    if (num_slots <= ht_partition->num_used)
+        return false;
+    ht_slots_t *new_slots = alloc_ht_slots(num_slots);
+    if (new_slots == nullptr)
+        return false;
+    for (uint32_t i = 0; i < old_slots->num_slots; i++) {
+        ht_entry_t *ht_entry = &old_slots->entries[i];
+        if (ht_entry->probe_len != 0)
+            ht_slots_insert(new_slots, ht_entry->key, hash(ht_entry->key), ht_entry->buf_index);
+    }
+
+    ht_partition->version++;
+    ht_partition->slots.store(new_slots, std::memory_order_release);
+    ht_partition->version++;
+    buffer_pool.hashtable.num_ht_entries += (int64_t)num_slots - old_slots->num_slots;
+    old_slots->next_retired = buffer_pool.hashtable.retired_slots;
+    buffer_pool.hashtable.retired_slots = old_slots;
+    return true;
+}
+
 /**
  * @brief Insert a new buffer(page) into the hashtable.
  * 
- * @details Assume this page is not in the hashtable.
+ * @retval true: successful
+ * @retval false: the partition is full
+ * 
+ * @details Assume this page is not in the hashtable. The caller must hold the
+ * latch of the page's partition.
+ * 
+ * Robin Hood insertion: the new entry takes the slot of any entry that is
+ * closer to its home slot, and that entry continues probing instead. This
+ * keeps probe lengths short even at high load factors.
+ * 
+ * Nothing is allocated here. The slots are sized by init_buffer_pool() and
+ * change only through resize_hashtable() and resize_buffer_pool(), so a
+ * partition that fills up fails the insert, and get_buffer() fails for the
+ * page.
  */
-inline void hashtable_insert(buf_descriptor_t *buf_desc) {
+inline bool hashtable_insert(buf_descriptor_t *buf_desc) {
     if (buf_desc == nullptr) {
-        std::cerr << "Error: buf_desc is nullptr in hashtable_insert." << std::endl;
-        return;
+        buf_log_error("Error: buf_desc is nullptr in hashtable_insert.");
+        return false;
     }
 
-    // t_id, p_id에 해당하는 ht_entry를 계산
-    ht_entry_t *ht_entry = get_ht_entry(buf_desc->table_id, buf_desc->page_num);
+    uint64_t key = ht_key(buf_desc->table_id, buf_desc->page_num);
+    uint64_t hash_value = hash(key);
+    uint32_t partition = ht_partition_of(hash_value);
+    ht_partition_t *ht_partition = &buffer_pool.hashtable.partitions[partition];
 
-    // Null 체크 추가
-    if (ht_entry == nullptr) {
-        std::cerr << "Error: Calculated ht_entry is null. Hash function might be out of bounds." << std::endl;
-        return;
+    if (ht_partition->num_used >= get_ht_slots(partition)->num_slots) {
+        buf_log_error("Error: hashtable partition " << partition << " is full.");
+        return false;
     }
 
 //  TODO -----------------------------------------------------------------------
-    // ht_entry가 비어 있다면, 바로 할당하여 첫 번째 노드로 사용
-    if (ht_entry->buf_desc == nullptr) {
-        ht_entry->buf_desc = buf_desc;
-        std::cout << "Inserted buf_desc directly at ht_entry: " << ht_entry 
-                  << " for table_id: " << buf_desc->table_id 
-                  << ", page_num: " << buf_desc->page_num << std::endl;
-    } 
-    else {
-        // 해당 ht_entry에 새로운 buf_desc 노드를 생성 후 체인에 연결
-        ht_entry_t *new_entry = new ht_entry_t;
-        if (new_entry == nullptr) {
-            std::cerr << "Error: Failed to allocate memory for new hash table entry." << std::endl;
-            return;
-        }
-
-        new_entry->buf_desc = buf_desc;
-        new_entry->next = ht_entry->next;
-        ht_entry->next = new_entry;
-
-        std::cout << "Inserting new hash entry at " << ht_entry 
-                  << " for page_num: " << buf_desc->page_num << std::endl;
-        std::cout << "New hash entry buf_desc: " << new_entry->buf_desc 
-                  << ", table_id: " << new_entry->buf_desc->table_id 
-                  << ", page_num: " << new_entry->buf_desc->page_num << std::endl;
-    }
+    ht_partition->version++;
+    ht_slots_insert(get_ht_slots(partition), key, hash_value,
+                    buf_desc - buffer_pool.buf_descriptors);
+    ht_partition->num_used++;
+    ht_partition->version++;
 //  ----------------------------------------------------------------------------
+    buf_log_debug("Inserted hashtable entry for table_id: " << buf_desc->table_id
+                  << ", page_num: " << buf_desc->page_num);
+    return true;
 }
 
 /**
  * @brief Delete the buffer(page) from the hashtable.
  * 
- * @details Assume this page is in the hashtable.
+ * @details Assume this page is in the hashtable. The caller must hold the
+ * latch of the page's partition.
+ * 
+ * Instead of leaving a tombstone, the following entries of the probe run are
+ * shifted back by one slot (backward shift deletion).
  */
 inline void hashtable_delete(buf_descriptor_t *buf_desc) {
-    ht_entry_t *ht_entry = get_ht_entry(buf_desc->table_id, buf_desc->page_num);
-    ht_entry_t *prev_entry = nullptr; // 이전 노드를 추적하기 위한 포인터
+    uint64_t key = ht_key(buf_desc->table_id, buf_desc->page_num);
+    uint64_t hash_value = hash(key);
+    uint32_t partition = ht_partition_of(hash_value);
+    ht_slots_t *ht_slots = get_ht_slots(partition);
+    uint32_t mask = ht_slots->num_slots - 1;
+    ht_entry_t *slots = ht_slots->entries;
+    uint32_t pos = hash_value & mask;
 
 //  TODO -----------------------------------------------------------------------
-    // 해당 entry의 체인을 따라가며 삭제할 항목 탐색
-    while (ht_entry) {
-        if (ht_entry->buf_desc == buf_desc) { // 삭제할 항목 찾을 시
-            if (prev_entry) { // 중간 또는 끝 노드인 경우
-                prev_entry->next = ht_entry->next;
-            } else { // 시작 노드인 경우
-                ht_entry->buf_desc = nullptr;
+    // 삭제할 항목 탐색
+    for (uint32_t probe_len = 1; probe_len <= mask + 1; probe_len++) {
+        if (slots[pos].probe_len < probe_len)
+            break;
+        if (slots[pos].key == key) {
+            buffer_pool.hashtable.partitions[partition].version++;
+            // 뒤따르는 entry들을 한 칸씩 당겨 빈 자리를 메움
+            uint32_t next = (pos + 1) & mask;
+            while (slots[next].probe_len > 1) {
+                slots[pos].key = slots[next].key.load();
+                slots[pos].buf_index = slots[next].buf_index.load();
+                slots[pos].probe_len = slots[next].probe_len - 1;
+                pos = next;
+                next = (next + 1) & mask;
             }
-            delete ht_entry;
-            std::cout << "Deleted hashtable entry for page_num: " << buf_desc->page_num << std::endl;
+            slots[pos].probe_len = 0;
+            buffer_pool.hashtable.partitions[partition].num_used--;
+            buffer_pool.hashtable.partitions[partition].version++;
+            buf_log_debug("Deleted hashtable entry for page_num: " << buf_desc->page_num);
             return;
         }
-        // 노드를 한칸씩 이동
-        prev_entry = ht_entry;
-        ht_entry = ht_entry->next;
+        pos = (pos + 1) & mask;
     }
 //  ----------------------------------------------------------------------------
-std::cerr << "Error: Entry not found in hashtable_delete for page_num: " << buf_desc->page_num << std::endl;
+buf_log_error("Error: Entry not found in hashtable_delete for page_num: " << buf_desc->page_num);
 }
 
 /**
- * @brief Get the victim buffer of eviction.
- * 
- * @return The memory address of the victim buffer.
+ * @brief Create a buffer access strategy for a bulk operation.
+ * 
+ * @details Pages read through the strategy recycle a small private ring of
+ * buffers instead of going through the replacement policy, so a large scan or
+ * bulk load does not evict the hot pages of the shared pool. The ring is
+ * capped at 1/MAX_RING_FRACTION of the pool.
+ */
+buf_strategy_t *get_buffer_strategy(buf_strategy_kind_t kind) {
+    uint32_t ring_size;
+    switch (kind) {
+    case BUF_STRATEGY_BULK_READ:
+        ring_size = BULK_READ_RING_SIZE;
+        break;
+    case BUF_STRATEGY_BULK_WRITE:
+        ring_size = BULK_WRITE_RING_SIZE;
+        break;
+    case BUF_STRATEGY_VACUUM:
+        ring_size = VACUUM_RING_SIZE;
+        break;
+    default:
+        return nullptr;
+    }
+    ring_size = std::max<uint32_t>(1, std::min(ring_size, buffer_pool.num_buf / MAX_RING_FRACTION));
+
+    buf_strategy_t *strategy = new buf_strategy_t;
+    strategy->kind = kind;
+    strategy->ring_size = ring_size;
+    strategy->current = ring_size - 1;
+    strategy->ring = new buf_descriptor_t*[ring_size]();
+    return strategy;
+}
+
+void free_buffer_strategy(buf_strategy_t *strategy) {
+    if (strategy == nullptr)
+        return;
+    delete[] strategy->ring;
+    delete strategy;
+}
+
+/**
+ * @brief Take the next buffer of the strategy's ring as a victim.
+ * 
+ * @param incoming_key The ht_key() of the page that will use the buffer
+ * @return The buffer pinned for the caller, or nullptr if the ring slot is
+ * empty or its buffer cannot be reused.
+ * 
+ * @details The buffer in the slot is reused only if it is of the size class
+ * the page needs, no one has pinned or kept it, it has not been used by
+ * others since (usage_count <= 1) and the table quotas allow it. A bulk read
+ * does not reuse a dirty buffer either, since someone else has written it.
+ */
+buf_descriptor_t *get_buffer_from_ring(buf_strategy_t *strategy, uint32_t size_class,
+                                       uint64_t incoming_key) {
+    strategy->current = (strategy->current + 1) % strategy->ring_size;
+    buf_descriptor_t *buf_desc = strategy->ring[strategy->current];
+    if (buf_desc == nullptr || buf_desc->size_class != size_class)
+        return nullptr;
+
+    if (buf_desc->usage_count > 1 || buf_desc->is_kept)
+        return nullptr;
+    if (strategy->kind == BUF_STRATEGY_BULK_READ && buf_desc->is_dirty)
+        return nullptr;
+
+    int expected = 0;
+    if (!buf_desc->reference_count.compare_exchange_strong(expected, 1))
+        return nullptr;
+    // 그 사이 다른 table의 page가 들어왔을 수 있으므로 pin한 뒤 quota를 확인
+    if (!buf_victim_allowed(buf_desc, incoming_key, true)) {
+        buf_desc->reference_count.fetch_sub(1);
+        return nullptr;
+    }
+    metric_pinned(1);
+    return buf_desc;
+}
+
+/**
+ * @brief Claim an unpinned page of a table at its hard quota.
+ * 
+ * @details The list policies look at no more than LIST_CLAIM_MAX_STEPS buffers
+ * from their LRU end, and those may all hold other tables' pages that the
+ * quota forbids the table to replace. This sweeps the size class from where
+ * the table's last sweep stopped and claims the first page of the table that
+ * is neither pinned nor kept, so the table replaces its own pages under every
+ * policy. A full sweep that finds none means all of its pages are in use.
+ */
+buf_descriptor_t *get_own_victim(uint32_t size_class, uint64_t incoming_key) {
+    int64_t table_id = incoming_key >> 48;
+    buf_table_info_t *table = get_table_info(table_id);
+    buf_size_class_t *buf_class = &buffer_pool.size_classes[size_class];
+    uint32_t num_buf = buf_class->num_buf.load();
+    for (uint32_t i = 0; i < num_buf; i++) {
+        uint32_t hand = table->victim_hand.fetch_add(1) % num_buf;
+        buf_descriptor_t *candidate = &buffer_pool.buf_descriptors[buf_class->first_buf + hand];
+        if (candidate->table_id != table_id || candidate->reference_count > 0 || candidate->is_kept)
+            continue;
+        int expected = 0;
+        if (!candidate->reference_count.compare_exchange_strong(expected, 1))
+            continue;
+        // pin하기 전에 다른 table의 page로 바뀌었다면 놓아 줌
+        if (candidate->table_id != table_id || candidate->is_kept) {
+            candidate->reference_count.fetch_sub(1);
+            continue;
+        }
+        metric_pinned(1);
+        return candidate;
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Get the victim buffer of eviction.
+ * 
+ * @param incoming_key The ht_key() of the page that will use the victim
+ * @param strategy The buffer access strategy of the caller, or nullptr
+ * @return The memory address of the victim buffer.
  * 
  * @details
  * This function selects a victim buffer for eviction, following the buffer
- * replacement policy. (clock sweep algorithm in this code)
+ * replacement policy chosen at init_buffer_pool(). (clock sweep by default)
+ * 
+ * The victim is a buffer of the size class of the incoming page's table. This
+ * first checks if there is an unused buffer in the class's freelist and
+ * returns it if there is. Otherwise, selects and returns an appropriate
+ * victim buffer of the class according to the replacement policy.
  * 
- * This first checks if there is an unused buffer in the buffer pool's freelist
- * and returns it if there is. Otherwise, selects and returns an appropriate
- * victim buffer according to the replacement policy.
+ * With a strategy, the buffer of the next ring slot is reused if possible,
+ * and otherwise the victim chosen as above is put into that ring slot.
  * 
- * Return NULL if all buffers in the buffer pool are pinned.
+ * With table quotas (see set_table_quota()), a table at its hard quota takes
+ * no buffer from the freelist and replaces only its own pages, and pages of
+ * tables within their soft quota are replaced only if no other victim is
+ * found. If the policy finds none of the table's own pages, they are looked
+ * for with get_own_victim(). Kept pages are never replaced.
+ * 
+ * Return NULL if all buffers of the size class are pinned.
+ * 
+ * The returned buffer is already pinned by the caller (reference count 1), so
+ * no other thread can take it as a victim at the same time.
  */
-buf_descriptor_t *get_victim_buffer() {
+buf_descriptor_t *get_victim_buffer(uint64_t incoming_key, buf_strategy_t *strategy) {
+    buf_descriptor_t *buf_desc;
+    // victim은 들어올 page의 table과 같은 size class에서 고름
+    uint32_t size_class = get_table_info(incoming_key >> 48)->size_class;
+    if (strategy) {
+        buf_desc = get_buffer_from_ring(strategy, size_class, incoming_key);
+        if (buf_desc) {
+            buf_log_debug("Reusing ring buffer: " << buf_desc);
+            return buf_desc;
+        }
+    }
+
     // freelist에서 우선적으로 사용 가능한 버퍼가 있는지 확인
-    buf_descriptor_t *buf_desc = get_from_freelist();
+    // freelist의 버퍼는 이미 pin된 상태로 나오므로 그대로 넘겨줌
+    // hard quota만큼 쓰고 있는 table은 더 늘지 않도록 자기 page만 교체
+    buf_desc = buf_table_at_hard_quota(incoming_key >> 48) ? nullptr : get_from_freelist(size_class);
     if (buf_desc) {
-        std::cout << "Found free buffer in freelist: " << buf_desc << std::endl;
+        buf_log_debug("Found free buffer in freelist: " << buf_desc);
+        // freelist가 가지고 있던 pin을 넘겨받음
+        metric_pinned(1);
+        if (strategy)
+            strategy->ring[strategy->current] = buf_desc;
         return buf_desc;
     }
 
-    std::cerr << "No free buffer in freelist, using clock sweep for eviction." << std::endl;
+    buf_log_debug("No free buffer in freelist, using " << buffer_pool.policy->name << " for eviction.");
 
 //  TODO -----------------------------------------------------------------------
-    int pinned_count = 0; // 순회 시작 시 pinned_count 초기화 (모든 버퍼가 참조 중인지를 확인)
+    buf_desc = buffer_pool.policy->pick_victim(size_class, incoming_key, true);
+    bool is_at_hard_quota = false;
+    if (buf_desc == nullptr && buffer_pool.num_quota_tables > 0) {
+        // hard quota만큼 쓰는 table에게 soft quota를 양보해도 고를 수 있는 page는 같으므로
+        // 정책이 보지 못한 자기 page를 직접 찾음
+        is_at_hard_quota = buf_table_at_hard_quota(incoming_key >> 48);
+        if (is_at_hard_quota)
+            buf_desc = get_own_victim(size_class, incoming_key);
+        // soft quota 안의 page밖에 남지 않았다면 soft quota는 양보
+        else
+            buf_desc = buffer_pool.policy->pick_victim(size_class, incoming_key, false);
+    }
+    if (buf_desc == nullptr) {
+        if (is_at_hard_quota)
+            buf_log_error("Error: Table " << (incoming_key >> 48)
+                          << " is at its hard quota and all of its buffers are pinned.");
+        else
+            buf_log_error("Error: All buffers are pinned, no victim buffer available.");
+        return nullptr;
+    }
+    metric_add(METRIC_VICTIM);
+    if (strategy)
+        strategy->ring[strategy->current] = buf_desc;
+    return buf_desc;
+//  ----------------------------------------------------------------------------
+}
 
-    for (int i = 0; i < buffer_pool.num_buf; i++) {
-    // while(true) {
-        std::cout << "Clock hand: " << buffer_pool.clock_hand << ", Num buffers: " << buffer_pool.num_buf << std::endl;
-        buf_descriptor_t* candidate = &buffer_pool.buf_descriptors[buffer_pool.clock_hand];
+/**
+ * @brief Give back a victim that get_buffer() did not use.
+ * 
+ * @details An unmapped victim came from the freelist and goes back there,
+ * otherwise only the pin taken by get_victim_buffer() is dropped.
+ */
+inline void release_victim(buf_descriptor_t *victim) {
+    if (victim->table_id == -1) {
+        add_to_freelist(victim);
+        metric_pinned(-1);
+    } else if (victim->reference_count.fetch_sub(1) == 1) {
+        metric_pinned(-1);
+    }
+}
 
-        if (candidate == nullptr) {
-            std::cerr << "Error: candidate buffer descriptor is nullptr." << std::endl;
-            continue;
+// victim의 I/O latch를 잡고 호출, victim을 가리키던 swip이 다시 hashtable을 거치게 함
+inline void unswizzle_buffer(buf_descriptor_t *victim) {
+    if (victim->swip == nullptr)
+        return;
+    victim->swip->buf_desc = nullptr;
+    victim->swip = nullptr;
+    metric_add(METRIC_UNSWIZZLE);
+}
+
+/**
+ * @brief Take the page of a victim out of the buffer pool.
+ * 
+ * @param image The compressed page for the compressed cache, or nullptr
+ * 
+ * @details The caller holds the victim's I/O latch and the latch of its
+ * hashtable partition, and has checked that the victim is clean and pinned
+ * only by the caller. The tag of the victim is left for the caller to change.
+ */
+inline void evict_buffer(buf_descriptor_t *victim, bool was_dirty, const zcache_image_t *image) {
+    trace_event(TRACE_EVICT, victim->table_id, victim->page_num,
+                victim - buffer_pool.buf_descriptors);
+    buffer_pool.policy->on_evict(victim);
+    hashtable_delete(victim);
+    // 압축할 가치가 없는 page면 예전 image만 지움
+    zcache_insert(ht_key(victim->table_id, victim->page_num), image);
+    metric_add(was_dirty ? METRIC_EVICT_DIRTY : METRIC_EVICT_CLEAN);
+    // 미리 읽었지만 한 번도 쓰이지 않은 page
+    if (victim->is_prefetched.exchange(false))
+        metric_add(METRIC_PREFETCH_UNUSED);
+    get_table_info(victim->table_id)->num_buf--;
+    if (victim->is_kept.exchange(false))
+        buffer_pool.size_classes[victim->size_class].num_kept--;
+}
+
+/**
+ * @brief Map a victim buffer to a page that is not in the buffer pool.
+ * 
+ * @param found Set to the page's buffer, pinned, if another thread loaded the
+ * page in the meantime, and to nullptr otherwise
+ * @param for_prefetch Whether the page is read ahead. A dirty victim is then
+ * given up instead of written, since a speculative read must not wait for a
+ * write.
+ * @return The victim, pinned and mapped to the page with its I/O latch held,
+ * or nullptr if the page was found or no victim is available. is_valid is
+ * false unless the victim points at the page in a mapped table.
+ * 
+ * @details Steps 1 to 3 and 5 of get_buffer(). The caller reads the page if
+ * it is not valid and releases the I/O latch.
+ * 
+ * With the compressed cache open (see zcache_open()), the clean page of the
+ * victim is compressed before the hashtable partitions are locked and cached
+ * while they are, so the cache receives a page's images in eviction order.
+ */
+buf_descriptor_t *map_buffer(int64_t table_id, pagenum_t page_num, buf_strategy_t *strategy,
+                             bool for_prefetch, buf_descriptor_t **found) {
+    // 압축은 partition latch 밖에서 하므로 thread마다 image를 하나씩 둠
+    static thread_local zcache_image_t image;
+    uint32_t partition = get_ht_partition(table_id, page_num);
+    *found = nullptr;
+
+    while (true) {
+        // page가 buffer에 존재하지 않는 경우 교체 대상 페이지 확보
+        buf_descriptor_t *victim = get_victim_buffer(ht_key(table_id, page_num), strategy);
+        if (victim == nullptr) { // 교체할 페이지 X(모든 버퍼가 참조 중)
+            buf_log_error("get_victim_buffer returned nullptr, unable to proceed.");
+            return nullptr;
         }
 
-        // 참조 중인 페이지는 pinned_count만 증가시키고 넘어감
-        if (candidate->reference_count > 0) {
-            pinned_count++;
-        } else {
-            // 참조 중이지 않은 경우 교체 대상 고려
-            if (candidate->usage_count == 0) {
-                buffer_pool.clock_hand = (buffer_pool.clock_hand + 1) % buffer_pool.num_buf;
-                std::cout << "Evicting Candidate: " << candidate << std::endl;
-                return candidate;  // 교체 대상 반환
-            } else {
-                // 사용 횟수를 줄여 다음 순회에서 교체될 가능성 증가
-                candidate->usage_count--;
+        victim->io_latch.lock();
+
+        bool was_dirty = false;
+        // 페이지가 dirty 상태인 경우 flush
+        // 그 사이 pin한 writer가 있을 수 있으므로 shared latch를 잡고 씀
+        if (victim->is_dirty) {
+            if (for_prefetch) {
+                victim->io_latch.unlock();
+                release_victim(victim);
+                return nullptr;
             }
+            buf_log_debug("페이지가 dirty한가?");
+            std::shared_lock<std::shared_mutex> guard(victim->content_latch);
+            flush_buffer(victim);
+            metric_add(METRIC_FG_WRITE);
+            was_dirty = true;
         }
 
-        // 다음 버퍼로 이동
-        buffer_pool.clock_hand = (buffer_pool.clock_hand + 1) % buffer_pool.num_buf;
-    }
+        // 아래에서 pin을 확인하기 전에 되돌려야 swip으로 pin하는 thread를 놓치지 않음
+        unswizzle_buffer(victim);
+
+        bool is_mapped = victim->table_id != -1;
+        bool is_compressed = false;
+        // latch를 잡은 writer가 있으면 이 victim은 아래에서 버려지므로 기다리지 않음
+        // mmap한 page는 page cache에 남아 있으므로 담지 않음
+        if (is_mapped && zcache_is_open() && victim->buf_page == get_buffer_frame(victim) &&
+            victim->content_latch.try_lock_shared()) {
+            is_compressed = zcache_compress(victim->buf_page, buf_page_size(victim), &image);
+            victim->content_latch.unlock_shared();
+        }
+        uint32_t old_partition = is_mapped ?
+            get_ht_partition(victim->table_id, victim->page_num) : partition;
+        lock_ht_partitions(old_partition, partition);
+
+        // flush하는 사이 다른 thread가 pin 했거나 다시 dirty로 만들었다면 다른 victim을 찾음
+        if (victim->reference_count != 1 || victim->is_dirty) {
+            unlock_ht_partitions(old_partition, partition);
+            victim->io_latch.unlock();
+            release_victim(victim);
+            continue;
+        }
 
-    assert(false);
+        // 그 사이 다른 thread가 같은 page를 먼저 올렸다면 그 버퍼를 사용
+        buf_descriptor_t *buf_desc = hashtable_lookup(table_id, page_num);
+        if (buf_desc != nullptr) {
+            pin_buffer(buf_desc, strategy);
+            unlock_ht_partitions(old_partition, partition);
+            victim->io_latch.unlock();
+            release_victim(victim);
+            *found = buf_desc;
+            return nullptr;
+        }
 
-    // 한 바퀴 순회 후 모든 버퍼가 참조 중이라면, nullptr 반환
-    if (pinned_count == buffer_pool.num_buf) {
-        std::cerr << "Error: All buffers are pinned, no victim buffer available." << std::endl;
-        return nullptr; 
+        // 이전 page를 읽던 낙관적 읽기는 실패하도록 version을 바꿈
+        victim->version += 2;
+
+        // 기존 page가 해시 테이블에 존재하면 삭제
+        if (is_mapped)
+            evict_buffer(victim, was_dirty, is_compressed ? &image : nullptr);
+
+        // descriptor를 새로운 page로 초기화, mmap한 page는 읽을 필요 없이 바로 유효함
+        // 낙관적 읽기가 예전 buf_page를 읽더라도 frame과 mapping은 pool을 닫을 때까지
+        // 유효하며, 위에서 바꾼 version으로 실패함
+        page_t *mapped_page = mapped_get_page(table_id, page_num);
+        page_t *page = mapped_page ? mapped_page : get_buffer_frame(victim);
+        victim->table_id = table_id;
+        victim->page_num = page_num;
+        // mapping을 가리키는 동안 쓰지 않는 frame의 메모리는 OS에 돌려줌
+        if (mapped_page != nullptr && victim->buf_page == get_buffer_frame(victim))
+            madvise(get_buffer_frame(victim), buf_page_size(victim), MADV_DONTNEED);
+        if (victim->buf_page != page)
+            victim->buf_page = page;
+        victim->is_dirty = false;
+        victim->is_valid = mapped_page != nullptr;
+        victim->is_prefetched = for_prefetch;
+        victim->page_lsn = 0;
+
+        // victim은 이미 pin된 상태이므로 hash table에만 추가
+        if (!hashtable_insert(victim)) {
+            // partition이 가득 찬 경우, victim을 unmapped 상태로 돌려놓고 실패 처리
+            victim->table_id = -1;
+            victim->page_num = -1;
+            if (mapped_page != nullptr)
+                victim->buf_page = get_buffer_frame(victim);
+            victim->is_valid = false;
+            victim->is_prefetched = false;
+            unlock_ht_partitions(old_partition, partition);
+            victim->io_latch.unlock();
+            release_victim(victim);
+            return nullptr;
+        }
+        get_table_info(table_id)->num_buf++;
+        unlock_ht_partitions(old_partition, partition);
+        buffer_pool.policy->on_miss(victim);
+        return victim;
     }
-//  ----------------------------------------------------------------------------
+}
+
+/**
+ * @brief Take the pinned buffer out of replacement for BUF_PRIORITY_KEEP.
+ * 
+ * @details At most 1/BUF_MAX_KEEP_FRACTION of a size class is kept, so the
+ * hint cannot starve the class of victims. Beyond that the page is replaced
+ * as usual. The page stays kept until free_page() or a resize evicts it.
+ */
+inline void keep_buffer(buf_descriptor_t *buf_desc) {
+    if (buf_desc->is_kept)
+        return;
+    buf_size_class_t *buf_class = &buffer_pool.size_classes[buf_desc->size_class];
+    uint32_t num_kept = buf_class->num_kept;
+    do {
+        if (num_kept >= buf_class->num_buf / BUF_MAX_KEEP_FRACTION)
+            return;
+    } while (!buf_class->num_kept.compare_exchange_weak(num_kept, num_kept + 1));
+    // 다른 thread가 먼저 남겨 두었다면 잡은 자리를 돌려줌
+    if (buf_desc->is_kept.exchange(true))
+        buf_class->num_kept--;
 }
 
 /**
@@ -420,148 +1627,1268 @@ buf_descriptor_t *get_victim_buffer() {
  * During this process, the usage count must not exceed MAX_USAGE_COUNT, and
  * buf_desc must increment the reference count by calling pin_buffer() before
  * being returned.
+ * 
+ * This function is safe to call from multiple threads. Steps 3 and 5 are done
+ * while holding the latches of the old and new hashtable partitions, and the
+ * victim's I/O latch is held from step 2 until the page is read, so a thread that
+ * finds the page in the hashtable in the meantime waits for the read.
+ * 
+ * With mode BUF_LATCH_SHARED or BUF_LATCH_EXCLUSIVE, the content latch of the
+ * buffer is also acquired before returning, and the caller releases both with
+ * release_buffer(). Pins are counted, so the same page may be pinned several
+ * times, and each get_buffer() must be matched by one unpin.
+ * 
+ * With a buffer access strategy (see get_buffer_strategy()), a hit does not
+ * promote the page in the replacement policy, and a miss recycles the
+ * strategy's ring of buffers.
+ * 
+ * A miss, or the first use of a prefetched page, feeds the table's access
+ * pattern to readahead_buffer(), which reads the following pages ahead of a
+ * sequential or strided scan.
+ * 
+ * With the compressed cache open (see zcache_open()), a miss decompresses
+ * the page from there instead of reading the file if it was evicted lately.
+ * 
+ * With priority BUF_PRIORITY_KEEP, the page is not replaced afterwards, which
+ * suits a header page or the root and upper levels of an index that every
+ * access goes through (see keep_buffer()).
  */
-buf_descriptor_t *get_buffer(int64_t table_id, pagenum_t page_num) {
-    buf_descriptor_t *buf_desc = hashtable_lookup(table_id, page_num);
+buf_descriptor_t *get_buffer(int64_t table_id, pagenum_t page_num,
+                             buf_latch_mode_t mode, buf_strategy_t *strategy,
+                             buf_priority_t priority) {
+    buf_descriptor_t *buf_desc;
+    uint32_t partition = get_ht_partition(table_id, page_num);
+    uint64_t start_ns = metrics_now_ns();
+
+    metric_add(METRIC_GET_BUFFER);
 
-    stat_get_buffer++;
+    // mmap한 page는 쓸 수 없으므로 수정하려는 접근은 거부
+    if (mode == BUF_LATCH_EXCLUSIVE && mapped_is_table(table_id)) {
+        buf_log_error("Error: cannot latch page " << page_num << " of read-only table " << table_id
+                      << " exclusively");
+        return nullptr;
+    }
 
 //  TODO -----------------------------------------------------------------------
     // page가 이미 buffer에 존재하는 경우
-    if (buf_desc != nullptr) {
-        std::cout << "buffer에 페이지가 이미 존재" << std::endl;
-        if (buf_desc->reference_count == 0) {
-            pin_buffer(buf_desc); // 필요할 때만 pin
+    buffer_pool.hashtable.partitions[partition].latch.lock();
+    buf_desc = hashtable_lookup(table_id, page_num);
+    if (buf_desc != nullptr)
+        pin_buffer(buf_desc, strategy); // partition latch를 잡은 채로 pin해야 교체되지 않음
+    buffer_pool.hashtable.partitions[partition].latch.unlock();
+
+    if (buf_desc == nullptr) {
+        buf_log_debug("buffer에 존재 하지 않는 경우 교체 대상 페이지 확보");
+        buf_descriptor_t *victim = map_buffer(table_id, page_num, strategy, false, &buf_desc);
+        if (victim != nullptr) {
+            // 새 page를 읽고 나서야 latch를 풀어 기다리던 thread들이 사용할 수 있게 함
+            bool is_unpacked = false;
+            if (!victim->is_valid) {
+                is_unpacked = zcache_take(ht_key(table_id, page_num), victim->buf_page,
+                                          buf_page_size(victim));
+                if (!is_unpacked)
+                    read_table_page(table_id, page_num, victim->buf_page);
+            }
+            victim->is_valid = true;
+            victim->io_latch.unlock();
+            trace_event(TRACE_MISS, table_id, page_num, victim - buffer_pool.buf_descriptors);
+
+            readahead_buffer(table_id, page_num, strategy);
+            if (priority == BUF_PRIORITY_KEEP)
+                keep_buffer(victim);
+            latch_buffer(victim, mode);
+            metric_add(METRIC_MISS);
+            metric_table_access(table_id, victim->size_class, false);
+            metric_latency(is_unpacked ? LATENCY_ZCACHE_MISS : LATENCY_MISS, start_ns);
+            return victim;
         }
-        std::cout << "buf_desc의 ref_count" << buf_desc->reference_count << "buf_desc의 usage_count" << buf_desc->usage_count << std::endl;
-        return buf_desc;
+        // 그 사이 다른 thread가 올린 page가 없다면 교체할 buffer가 없는 것
+        if (buf_desc == nullptr)
+            return nullptr;
+    }
+
+    buf_log_debug("buffer에 페이지가 이미 존재");
+    trace_event(TRACE_HIT, table_id, page_num, buf_desc - buffer_pool.buf_descriptors);
+    // 미리 읽은 page를 처음 사용하면 scan이 이어지는 것이므로 다음 page들을 읽어 둠
+    if (buf_desc->is_prefetched && buf_desc->is_prefetched.exchange(false)) {
+        metric_add(METRIC_PREFETCH_HIT);
+        readahead_buffer(table_id, page_num, strategy);
     }
-    std::cout << "buffer에 존재 하지 않는 경우 교체 대상 페이지 확보" << std::endl;
-    // page가 buffer에 존재하지 않는 경우 교체 대상 페이지 확보
-    buf_desc = get_victim_buffer();
-    if (buf_desc == nullptr) { // 교체할 페이지 X(모든 버퍼가 참조 중)
-        std::cerr << "get_victim_buffer returned nullptr, unable to proceed." << std::endl;
+    wait_buffer_valid(buf_desc);
+    buf_log_debug("buf_desc의 ref_count" << buf_desc->reference_count << "buf_desc의 usage_count" << buf_desc->usage_count);
+    if (priority == BUF_PRIORITY_KEEP)
+        keep_buffer(buf_desc);
+    latch_buffer(buf_desc, mode);
+    metric_add(METRIC_HIT);
+    metric_table_access(table_id, buf_desc->size_class, true);
+    metric_latency(LATENCY_HIT, start_ns);
+    return buf_desc;
+//  ----------------------------------------------------------------------------
+}
+
+// 낙관적 읽기의 참조를 pin한 hit처럼 교체 정책에 알림
+void touch_buffer(int64_t table_id, pagenum_t page_num) {
+    uint32_t partition = get_ht_partition(table_id, page_num);
+    buffer_pool.hashtable.partitions[partition].latch.lock();
+    buf_descriptor_t *buf_desc = hashtable_lookup(table_id, page_num);
+    if (buf_desc != nullptr)
+        pin_buffer(buf_desc);
+    buffer_pool.hashtable.partitions[partition].latch.unlock();
+    if (buf_desc != nullptr)
+        unpin_buffer(buf_desc);
+}
+
+/**
+ * @brief Check whether a page is in the pool.
+ * 
+ * @details Only looks the page up under its partition latch. It does not pin
+ * the buffer or tell the replacement policy, so the answer may be stale by
+ * the time it is used.
+ */
+bool is_buffer_resident(int64_t table_id, pagenum_t page_num) {
+    uint32_t partition = get_ht_partition(table_id, page_num);
+    std::lock_guard<std::mutex> guard(buffer_pool.hashtable.partitions[partition].latch);
+    return hashtable_lookup(table_id, page_num) != nullptr;
+}
+
+/**
+ * @brief Start reading a page without a pin or a latch.
+ * 
+ * @return The buffer of the page, or nullptr if the page is not in the pool,
+ * is being read or modified, or its hashtable partition is changing. Then
+ * read it with get_buffer() instead.
+ * 
+ * @details Neither the hashtable nor the buffer is written, so readers of a
+ * hot page do not bounce its cache lines between cores. The partition's
+ * version confirms that the hashtable lookup saw a stable partition, and
+ * that the buffer still held the page when its version was read.
+ * 
+ * The page may change or be replaced while it is read, so the caller must
+ * treat everything read as unverified, e.g. not follow offsets read from it
+ * out of the page, until optimistic_read_validate() succeeds.
+ */
+buf_descriptor_t *optimistic_read_begin(int64_t table_id, pagenum_t page_num,
+                                        buf_optimistic_read_t *read) {
+    ht_partition_t *partition =
+        &buffer_pool.hashtable.partitions[get_ht_partition(table_id, page_num)];
+    uint64_t ht_version = partition->version;
+    if (ht_version & 1)
+        return nullptr;
+    buf_descriptor_t *buf_desc = hashtable_lookup(table_id, page_num);
+    if (buf_desc == nullptr)
+        return nullptr;
+    uint64_t version = buf_desc->version;
+    if ((version & 1) || !buf_desc->is_valid || partition->version != ht_version)
         return nullptr;
+
+    read->table_id = table_id;
+    read->page_num = page_num;
+    read->buf_desc = buf_desc;
+    read->version = version;
+    return buf_desc;
+}
+
+/**
+ * @brief Check that nothing changed the page since optimistic_read_begin().
+ * 
+ * @retval true: what was read is a consistent image of the page
+ * @retval false: read again, or fall back to get_buffer()
+ * 
+ * @details An exclusive latch or a replacement of the page changes the
+ * buffer's version. Only every OPTIMISTIC_USAGE_SAMPLE-th validated read of a
+ * thread is reported to the replacement policy, which keeps hot pages
+ * resident without writing to them on every read.
+ */
+bool optimistic_read_validate(const buf_optimistic_read_t *read) {
+    static thread_local uint32_t num_reads = 0;
+
+    // 앞선 page 읽기가 version 확인보다 나중에 일어나지 않도록 함
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (read->buf_desc->version.load(std::memory_order_relaxed) != read->version) {
+        metric_add(METRIC_OPTIMISTIC_CONFLICT);
+        return false;
     }
+    metric_add(METRIC_OPTIMISTIC_READ);
+    metric_table_access(read->table_id, read->buf_desc->size_class, true);
+    if (++num_reads % OPTIMISTIC_USAGE_SAMPLE == 0)
+        touch_buffer(read->table_id, read->page_num);
+    return true;
+}
 
-    // 페이지가 dirty 상태인 경우 flush
-    if (buf_desc->is_dirty) {
-        std::cout << "페이지가 dirty한가?" << std::endl;
-        flush_buffer(buf_desc);
+/**
+ * @brief Copy part of a page, optimistically if possible.
+ * 
+ * @retval 0: successful
+ * @retval others: the page cannot be read
+ * 
+ * @details Tries an optimistic read up to OPTIMISTIC_READ_RETRIES times, and
+ * then reads the page under a pin and a shared latch.
+ */
+int read_buffer(int64_t table_id, pagenum_t page_num, uint32_t offset, uint32_t length,
+                void *dest) {
+    if (offset + length > get_table_page_size(table_id)) {
+        buf_log_error("Error: invalid range in read_buffer.");
+        return 1;
+    }
+    buf_optimistic_read_t read;
+    for (int i = 0; i < OPTIMISTIC_READ_RETRIES; i++) {
+        buf_descriptor_t *buf_desc = optimistic_read_begin(table_id, page_num, &read);
+        if (buf_desc == nullptr)
+            break;
+        memcpy(dest, buf_desc->buf_page->data + offset, length);
+        if (optimistic_read_validate(&read))
+            return 0;
     }
 
-    // 기존 page가 해시 테이블에 존재하면 삭제
-    hashtable_delete(buf_desc);
+    buf_descriptor_t *buf_desc = get_buffer(table_id, page_num, BUF_LATCH_SHARED);
+    if (buf_desc == nullptr)
+        return 1;
+    memcpy(dest, buf_desc->buf_page->data + offset, length);
+    release_buffer(buf_desc, BUF_LATCH_SHARED);
+    return 0;
+}
 
-    // descriptor를 새로운 page로 초기화 
-    buf_desc->table_id = table_id;
-    buf_desc->page_num = page_num;
-    buf_desc->is_dirty = false;
-    
-    // descriptor를 pin하고 hash table에 추가
-    pin_buffer(buf_desc);
-    hashtable_insert(buf_desc);
-//  ----------------------------------------------------------------------------
+// swip이 page를 가리키도록 초기화, 처음에는 swizzle되지 않은 상태
+void init_swip(buf_swip_t *swip, int64_t table_id, pagenum_t page_num) {
+    swip->table_id = table_id;
+    swip->page_num = page_num;
+    swip->buf_desc = nullptr;
+}
+
+/**
+ * @brief Get the buffer of the page a swip refers to.
+ * 
+ * @return The buffer, pinned and latched as get_buffer() returns it, or
+ * nullptr if the page cannot be loaded. Release it with release_buffer().
+ * 
+ * @details A swizzled swip leads to the buffer without probing the hashtable
+ * or taking a partition latch. Otherwise the page is looked up or loaded with
+ * get_buffer(), and the swip is swizzled to its buffer unless the buffer is
+ * already swizzled to another swip.
+ * 
+ * Eviction unswizzles the swip in map_buffer() before it checks that the
+ * victim is not pinned. So after pinning the buffer, the swip still pointing
+ * to it means that eviction will see the pin and give up.
+ */
+buf_descriptor_t *get_buffer_swip(buf_swip_t *swip, buf_latch_mode_t mode) {
+    buf_descriptor_t *buf_desc = swip->buf_desc;
+    if (buf_desc != nullptr) {
+        if (buf_desc->reference_count.fetch_add(1) == 0)
+            metric_pinned(1);
+        if (swip->buf_desc == buf_desc) {
+            buffer_pool.policy->on_hit(buf_desc);
+            trace_event(TRACE_HIT, swip->table_id, swip->page_num,
+                        buf_desc - buffer_pool.buf_descriptors);
+            latch_buffer(buf_desc, mode);
+            metric_add(METRIC_SWIP_HIT);
+            metric_table_access(swip->table_id, buf_desc->size_class, true);
+            return buf_desc;
+        }
+        // 그 사이 교체되는 중이므로 hashtable을 거침
+        unpin_buffer(buf_desc);
+    }
 
+    buf_desc = get_buffer(swip->table_id, swip->page_num);
+    if (buf_desc == nullptr)
+        return nullptr;
+    // pin한 buffer는 교체되지 않으므로 I/O latch만 잡고 swizzle
+    // victim을 flush하는 thread는 I/O latch를 잡고 content latch를 기다리므로 latch는 그 뒤에 잡음
+    buf_desc->io_latch.lock();
+    if (buf_desc->swip == nullptr && swip->buf_desc == nullptr) {
+        buf_desc->swip = swip;
+        swip->buf_desc = buf_desc;
+    }
+    buf_desc->io_latch.unlock();
+    latch_buffer(buf_desc, mode);
     return buf_desc;
 }
 
-buf_descriptor_t *get_buffer_of_new_page(int64_t table_id) {
-    buf_descriptor_t *header_buf = get_buffer(table_id, 0);
-    page_t *header_page = header_buf->buf_page;
-    pagenum_t new_page_num = header_page->free_page_num;
+/**
+ * @brief Unswizzle a swip before the caller frees or changes it.
+ * 
+ * @details Taking the buffer's I/O latch waits for an eviction that is
+ * unswizzling the swip at the same time, so the pool does not touch the swip
+ * after this returns. The swip must not be used by other threads meanwhile.
+ */
+void unswizzle_swip(buf_swip_t *swip) {
     buf_descriptor_t *buf_desc;
+    while ((buf_desc = swip->buf_desc) != nullptr) {
+        std::lock_guard<std::mutex> guard(buf_desc->io_latch);
+        if (swip->buf_desc == buf_desc) {
+            swip->buf_desc = nullptr;
+            buf_desc->swip = nullptr;
+        }
+    }
+}
+
+/**
+ * @brief Completion callback of prefetch_buffer().
+ * 
+ * @details A failed read is done again synchronously, so the page always
+ * becomes valid. The callback of the last request frees the prefetch.
+ */
+void prefetch_done(aio_request_t *request, int result) {
+    prefetch_t *prefetch = (prefetch_t *)request->arg;
+    buf_descriptor_t *buf_desc = prefetch->buf_descs[request - prefetch->requests.data()];
+
+    if (result < 0)
+        read_table_page(buf_desc->table_id, buf_desc->page_num, buf_desc->buf_page);
+    set_buffer_valid(buf_desc);
+    unpin_buffer(buf_desc);
+    buffer_pool.size_classes[buf_desc->size_class].num_prefetching--;
+
+    if (prefetch->num_pending.fetch_sub(1) == 1)
+        delete prefetch;
+}
+
+/**
+ * @brief Start reading pages into the buffer pool without waiting for them.
+ * 
+ * @param page_nums The pages to read, e.g. the siblings a B+tree scan visits
+ * next
+ * @param strategy The buffer access strategy of the caller, or nullptr
+ * @return The number of pages whose read was started, or that were taken
+ * from the compressed cache.
+ * 
+ * @details Pages already in the buffer pool and pages beyond the end of the
+ * file are skipped. Prefetching stops at the first victim that is dirty, when
+ * all buffers are pinned, or when 1/MAX_PREFETCH_FRACTION of the table's
+ * size class is pinned by reads in flight, since a speculative read must not write pages or
+ * take the buffers that get_buffer() needs.
+ * 
+ * The pages are mapped and read in one coalesced async batch. Each buffer
+ * stays pinned until its read is done, and get_buffer() on such a page waits
+ * for the read. Pages in the compressed cache are decompressed right away
+ * instead.
+ * 
+ * For a mapped table, the kernel is asked to read the pages into the page
+ * cache (see mapped_will_need()), and no buffer is taken.
+ */
+uint32_t prefetch_buffer(int64_t table_id, const pagenum_t *page_nums, uint32_t num_pages,
+                         buf_strategy_t *strategy) {
+    // mmap한 table은 buffer를 잡지 않고 kernel이 page cache로 미리 읽게 함
+    if (mapped_is_table(table_id))
+        return mapped_will_need(table_id, page_nums, num_pages);
+    // async I/O로 열지 않은 table은 미리 읽지 않음
+    int64_t num_file_pages = aio_get_num_pages(table_id);
+    if (num_file_pages < 0 || num_pages == 0)
+        return 0;
+
+    buf_size_class_t *size_class = &buffer_pool.size_classes[get_table_info(table_id)->size_class];
+    prefetch_t *prefetch = new prefetch_t;
+    prefetch->requests.reserve(num_pages);
+    prefetch->buf_descs.reserve(num_pages);
+    uint32_t num_unpacked = 0;
+
+    for (uint32_t i = 0; i < num_pages; i++) {
+        pagenum_t page_num = page_nums[i];
+        // file 끝 너머의 page는 아직 할당되지 않았으므로 읽지 않음
+        if (page_num < 0 || page_num >= num_file_pages)
+            continue;
+
+        uint32_t partition = get_ht_partition(table_id, page_num);
+        buffer_pool.hashtable.partitions[partition].latch.lock();
+        bool is_cached = hashtable_lookup(table_id, page_num) != nullptr;
+        buffer_pool.hashtable.partitions[partition].latch.unlock();
+        if (is_cached)
+            continue;
+
+        // 읽는 중인 prefetch가 너무 많은 buffer를 잡지 않도록 먼저 자리를 예약
+        if (size_class->num_prefetching.fetch_add(1) >= size_class->num_buf / MAX_PREFETCH_FRACTION) {
+            size_class->num_prefetching--;
+            break;
+        }
+
+        buf_descriptor_t *found;
+        buf_descriptor_t *victim = map_buffer(table_id, page_num, strategy, true, &found);
+        if (victim == nullptr) {
+            size_class->num_prefetching--;
+            if (found == nullptr)
+                break;
+            unpin_buffer(found);
+            continue;
+        }
+        trace_event(TRACE_PREFETCH, table_id, page_num, victim - buffer_pool.buf_descriptors);
+        // compressed cache에 있던 page는 바로 풀어 넣고 읽지 않음
+        if (zcache_take(ht_key(table_id, page_num), victim->buf_page, size_class->page_size)) {
+            victim->is_valid = true;
+            victim->io_latch.unlock();
+            unpin_buffer(victim);
+            size_class->num_prefetching--;
+            num_unpacked++;
+            continue;
+        }
+        // 읽기는 I/O thread가 하므로 I/O latch는 바로 풀고, pin으로 교체를 막음
+        victim->io_latch.unlock();
+
+        prefetch->requests.push_back({table_id, page_num, victim->buf_page, false,
+                                      prefetch_done, prefetch, nullptr});
+        prefetch->buf_descs.push_back(victim);
+    }
+
+    uint32_t num_issued = prefetch->requests.size();
+    metric_add(METRIC_PREFETCH_PAGE, num_issued + num_unpacked);
+    if (num_issued == 0) {
+        delete prefetch;
+        return num_unpacked;
+    }
+    prefetch->num_pending = num_issued;
 
-    // Ger header page and free page number from it.
+    if (aio_submit(prefetch->requests.data(), num_issued, nullptr) != 0) {
+        // 마지막 호출에서 prefetch가 해제되므로 requests를 먼저 꺼내 둠
+        aio_request_t *requests = prefetch->requests.data();
+        for (uint32_t i = 0; i < num_issued; i++)
+            prefetch_done(&requests[i], -EIO);
+    }
+    return num_issued + num_unpacked;
+}
 
-    // If there is any free page, get the page.
-    if (new_page_num != -1) {
-        buf_desc = get_buffer(table_id, new_page_num);
-        header_page->free_page_num = buf_desc->buf_page->next_free_page_num;
+/**
+ * @brief Read ahead of a sequential or strided scan.
+ * 
+ * @details Called by get_buffer() on a miss and on the first use of a
+ * prefetched page. Accesses to a table whose page numbers keep the same
+ * stride (at most READAHEAD_MAX_STRIDE, ascending or descending) form a run.
+ * Once the run has READAHEAD_MIN_RUN accesses, the next window of pages along
+ * the stride is prefetched, and the window is topped up whenever less than
+ * half of it is left ahead of the scan. A jump forward by a multiple of the
+ * stride within the window, e.g. over pages that were already cached, keeps
+ * the run.
+ * 
+ * With a strategy, the window is capped at half the ring, so the ring does not
+ * recycle prefetched pages before the scan reaches them.
+ *
+ * A miss that neither continues a run nor could start one, as with random
+ * accesses, only records its page without taking the slot's latch.
+ */
+void readahead_buffer(int64_t table_id, pagenum_t page_num, buf_strategy_t *strategy) {
+    // 작은 size class를 prefetch가 다 차지하지 않도록 class 크기의 1/4까지
+    uint32_t class_num_buf = buffer_pool.size_classes[get_table_info(table_id)->size_class].num_buf;
+    int64_t window = std::min<uint32_t>(buffer_pool.readahead_window, class_num_buf / 4);
+    if (strategy)
+        window = std::min<int64_t>(window, strategy->ring_size / 2);
+    if (window == 0)
+        return;
+
+    readahead_t *readahead = &buffer_pool.readahead[(uint64_t)table_id % NUM_READAHEAD_SLOTS];
+    // run이 없고 이번 접근도 가까운 page가 아니면 latch 없이 기록만
+    int64_t delta = page_num - readahead->last_page.load(std::memory_order_relaxed);
+    if (readahead->table_id.load(std::memory_order_relaxed) == table_id &&
+        readahead->stride.load(std::memory_order_relaxed) == 0 &&
+        (delta == 0 || std::abs(delta) > READAHEAD_MAX_STRIDE)) {
+        readahead->last_page.store(page_num, std::memory_order_relaxed);
+        return;
     }
-    // Or not, double the database.
-    else {
-        // Double the database.
-        uint64_t num_of_pages = 2 * header_page->num_of_pages;
-        page_t *tmp_page = (page_t*)malloc(PAGE_SIZE);
 
-        // Write new free page number.
-        tmp_page->next_free_page_num = -1;
-        file_write_page(table_id, header_page->num_of_pages, tmp_page);
+    pagenum_t page_nums[MAX_READAHEAD_WINDOW];
+    uint32_t num_pages = 0;
+    {
+        std::lock_guard<std::mutex> guard(readahead->latch);
+        // slot을 다른 table이 쓰고 있었다면 새로 시작
+        if (readahead->table_id != table_id) {
+            readahead->table_id = table_id;
+            readahead->stride = 0;
+            readahead->run_len = 1;
+            readahead->last_page = page_num;
+            return;
+        }
 
-        // Write free pages.
-        for (pagenum_t i = header_page->num_of_pages; i < num_of_pages - 2;) {
-            tmp_page->next_free_page_num = i++;
-            file_write_page(table_id, i, tmp_page);
+        delta = page_num - readahead->last_page;
+        int64_t stride = readahead->stride;
+        if (stride != 0 && delta % stride == 0 && delta / stride > 0 && delta / stride <= window) {
+            readahead->run_len++;
+        } else if (delta != 0 && std::abs(delta) <= READAHEAD_MAX_STRIDE) {
+            // 새로운 간격으로 run을 다시 시작
+            readahead->stride = stride = delta;
+            readahead->run_len = 2;
+            readahead->next_page = page_num + stride;
+        } else {
+            readahead->stride = 0;
+            readahead->run_len = 1;
         }
+        readahead->last_page = page_num;
 
-        // Set header page.
-        header_page->free_page_num = num_of_pages - 2;
-        header_page->num_of_pages = num_of_pages;
+        if (readahead->stride == 0 || readahead->run_len < READAHEAD_MIN_RUN)
+            return;
+
+        // scan이 앞서 나갔다면 현재 page 다음부터 읽음
+        if ((readahead->next_page - page_num) / stride <= 0)
+            readahead->next_page = page_num + stride;
+        // window의 절반 이상이 남아 있으면 아직 읽지 않음
+        if ((readahead->next_page - page_num) / stride <= window / 2) {
+            while ((readahead->next_page - page_num) / stride <= window) {
+                page_nums[num_pages++] = readahead->next_page;
+                readahead->next_page += stride;
+            }
+        }
+    }
+
+    if (num_pages > 0)
+        prefetch_buffer(table_id, page_nums, num_pages, strategy);
+}
 
-        free(tmp_page);
+/**
+ * @brief Set the number of pages read ahead of a scan.
+ * 
+ * @details 0 turns read-ahead off. The window is capped at
+ * MAX_READAHEAD_WINDOW and at a quarter of the pool.
+ */
+void set_readahead_window(uint32_t num_pages) {
+    num_pages = std::min<uint32_t>(num_pages, MAX_READAHEAD_WINDOW);
+    buffer_pool.readahead_window = std::min<uint32_t>(num_pages, buffer_pool.num_buf / 4);
+}
 
-        // Get new buffer.
-        new_page_num = num_of_pages - 1;
-        buf_desc = get_buffer(table_id, new_page_num);
+/**
+ * @brief Allocate a page of a table and get its buffer.
+ * 
+ * @return The unlatched, pinned buffer, or nullptr if the file cannot grow
+ * or no buffer is available.
+ * 
+ * @details The page comes from the extent allocator (alloc.h), so concurrent
+ * callers do not serialize on the header page.
+ * 
+ * The buffer is filled with zeros instead of reading the page, whose content
+ * on disk is either a hole of a new extent or a freed page. The buffer is
+ * clean, so the caller initializes the page and marks it dirty. The zeros
+ * are not logged, so a caller that relies on them after a crash logs the
+ * whole page, like the space map pages do.
+ */
+buf_descriptor_t *get_buffer_of_new_page(int64_t table_id, buf_strategy_t *strategy) {
+    if (mapped_is_table(table_id)) {
+        buf_log_error("Error: cannot allocate a page of read-only table " << table_id);
+        return nullptr;
+    }
+    pagenum_t new_page_num = alloc_page(table_id);
+    if (new_page_num == -1)
+        return nullptr;
+
+    uint64_t start_ns = metrics_now_ns();
+    metric_add(METRIC_GET_BUFFER);
+    buf_descriptor_t *found;
+    buf_descriptor_t *victim = map_buffer(table_id, new_page_num, strategy, false, &found);
+    if (victim == nullptr) {
+        if (found == nullptr) {
+            alloc_free_page(table_id, new_page_num);
+            return nullptr;
+        }
+        // 해제된 뒤 아직 buffer에 남아 있던 page, 쓰던 thread는 없으므로 그대로 0으로 채움
+        wait_buffer_valid(found);
+        latch_buffer(found, BUF_LATCH_EXCLUSIVE);
+        memset(found->buf_page, 0, buf_page_size(found));
+        unlatch_buffer(found, BUF_LATCH_EXCLUSIVE);
+        trace_event(TRACE_HIT, table_id, new_page_num, found - buffer_pool.buf_descriptors);
+        metric_add(METRIC_HIT);
+        metric_table_access(table_id, found->size_class, true);
+        metric_latency(LATENCY_HIT, start_ns);
+        return found;
     }
 
-    mark_buffer_dirty(header_buf);
-    unpin_buffer(header_buf);
-    
-    return buf_desc;
+    // 디스크의 내용이나 압축 cache에 남은 해제 전의 image는 쓰지 않음
+    zcache_invalidate(ht_key(table_id, new_page_num));
+    memset(victim->buf_page, 0, buf_page_size(victim));
+    victim->is_valid = true;
+    victim->io_latch.unlock();
+    trace_event(TRACE_MISS, table_id, new_page_num, victim - buffer_pool.buf_descriptors);
+    metric_add(METRIC_MISS);
+    metric_table_access(table_id, victim->size_class, false);
+    metric_latency(LATENCY_MISS, start_ns);
+    return victim;
 }
 
+// page를 space map에 돌려줌, buffer의 내용은 건드리지 않음
+// 남겨 두던 page였다면 다시 교체될 수 있게 함
 void free_page(int64_t table_id, buf_descriptor_t *buf) {
-    buf_descriptor_t *header_buf = get_buffer(table_id, 0);
-    page_t *header_page = header_buf->buf_page;
-    page_t *buf_page = buf->buf_page;
+    if (mapped_is_table(table_id)) {
+        buf_log_error("Error: cannot free a page of read-only table " << table_id);
+        return;
+    }
+    if (buf->is_kept.exchange(false))
+        buffer_pool.size_classes[buf->size_class].num_kept--;
+    alloc_free_page(table_id, buf->page_num);
+}
 
-    // Add this page to the free page list.
-    buf_page->next_free_page_num = header_page->free_page_num;
-    header_page->free_page_num = buf->page_num;
+/**
+ * @brief Write out one round of dirty buffers ahead of the clock hand of a
+ * size class.
+ * 
+ * @return The number of pages written.
+ * 
+ * @details Looks at the next max_pages * BG_WRITER_SCAN_FACTOR buffers from
+ * the clock hand and writes those that are dirty, unpinned and have a usage
+ * count of 0, i.e. those the clock sweep would take as victims next. Each
+ * buffer is pinned while written so it cannot be evicted or retagged, and its
+ * shared content latch keeps writers out during the write.
+ * 
+ * Policies other than CLOCK do not maintain usage_count, so with them this
+ * cleans every unpinned dirty buffer in the scanned range.
+ */
+uint32_t bg_writer_class_round(buf_size_class_t *size_class, uint32_t max_pages) {
+    uint32_t num_written = 0;
+    uint32_t num_buf = size_class->num_buf;
+    uint64_t num_scan = std::min<uint64_t>((uint64_t)max_pages * BG_WRITER_SCAN_FACTOR, num_buf);
+    uint32_t hand = size_class->clock_hand.load();
+
+    for (uint64_t i = 0; i < num_scan && num_written < max_pages; i++) {
+        buf_descriptor_t *buf_desc = &buffer_pool.buf_descriptors[
+            size_class->first_buf + (hand + i) % num_buf];
+        if (!buf_desc->is_dirty || buf_desc->usage_count > 0)
+            continue;
 
-    mark_buffer_dirty(header_buf);
-    mark_buffer_dirty(buf);
-    unpin_buffer(header_buf);
+        int expected = 0;
+        if (!buf_desc->reference_count.compare_exchange_strong(expected, 1))
+            continue;
+        metric_pinned(1);
+        {
+            std::shared_lock<std::shared_mutex> guard(buf_desc->content_latch);
+            if (buf_desc->is_dirty) {
+                flush_buffer(buf_desc);
+                metric_add(METRIC_BG_WRITE);
+                num_written++;
+            }
+        }
+        unpin_buffer(buf_desc);
+    }
+    return num_written;
 }
 
-int close_buffer_pool() {
-//  TODO -----------------------------------------------------------------------
-// dirty 상태의 buffer descriptor들을 flush 해주어야 함
-    for (uint32_t i=0; i < buffer_pool.num_buf; i++) {
-        buf_descriptor_t *buf_desc = &buffer_pool.buf_descriptors[i];
-        if (buf_desc->is_dirty) {
+// max_pages를 size class의 buffer 수에 비례해 나누어 class마다 한 round씩
+uint32_t bg_writer_round(uint32_t max_pages) {
+    uint32_t num_written = 0;
+    for (uint32_t c = 0; c < buffer_pool.num_size_classes; c++) {
+        buf_size_class_t *size_class = &buffer_pool.size_classes[c];
+        uint32_t class_max_pages = std::max<uint64_t>(
+            1, (uint64_t)max_pages * size_class->num_buf / buffer_pool.num_buf);
+        num_written += bg_writer_class_round(size_class, class_max_pages);
+    }
+    return num_written;
+}
+
+void bg_writer_main() {
+    std::unique_lock<std::mutex> lock(buffer_pool.bg_writer_latch);
+    while (buffer_pool.bg_writer_running) {
+        uint32_t max_pages = buffer_pool.bg_writer_max_pages;
+        lock.unlock();
+        bg_writer_round(max_pages);
+        lock.lock();
+        buffer_pool.bg_writer_cond.wait_for(lock,
+            std::chrono::milliseconds(buffer_pool.bg_writer_sleep_ms),
+            [] { return !buffer_pool.bg_writer_running; });
+    }
+}
+
+/**
+ * @brief Start the background writer.
+ * 
+ * @param max_pages_per_round The maximum number of pages written per round
+ * @param sleep_ms The time to sleep between rounds
+ * @retval 0: successful
+ * @retval others: failed
+ * 
+ * @details The background writer cleans dirty buffers before the clock sweep
+ * reaches them, so get_buffer() rarely has to write a victim itself. If it is
+ * already running, only its settings are changed.
+ */
+int start_bg_writer(uint32_t max_pages_per_round, uint32_t sleep_ms) {
+    if (max_pages_per_round == 0)
+        return 1;
+
+    std::lock_guard<std::mutex> guard(buffer_pool.bg_writer_latch);
+    buffer_pool.bg_writer_max_pages = max_pages_per_round;
+    buffer_pool.bg_writer_sleep_ms = sleep_ms;
+    if (!buffer_pool.bg_writer_running) {
+        buffer_pool.bg_writer_running = true;
+        buffer_pool.bg_writer = std::thread(bg_writer_main);
+    }
+    return 0;
+}
+
+void stop_bg_writer() {
+    {
+        std::lock_guard<std::mutex> guard(buffer_pool.bg_writer_latch);
+        if (!buffer_pool.bg_writer_running)
+            return;
+        buffer_pool.bg_writer_running = false;
+    }
+    buffer_pool.bg_writer_cond.notify_all();
+    buffer_pool.bg_writer.join();
+}
+
+// checkpoint 시작 시점에 dirty였던 page
+typedef struct checkpoint_page_t {
+    int64_t table_id;
+    pagenum_t page_num;
+} checkpoint_page_t;
+
+/**
+ * @brief Write a batch of checkpoint pages from copies of their contents.
+ * 
+ * @return The number of pages written.
+ * 
+ * @details Each page is pinned without counting as an access, so it cannot
+ * be evicted and read back before its write is done, and copied under its
+ * shared content latch. Only one page is latched at a time, so the checkpoint
+ * never holds a latch that a thread latching pages in index order waits for.
+ * Pages evicted since the snapshot were written by the evicting thread.
+ * 
+ * copies has room for num_pages pages of buffer_pool.max_page_size bytes.
+ */
+uint32_t checkpoint_batch(const checkpoint_page_t *pages, uint32_t num_pages, page_t *copies) {
+    uint32_t copy_stride = buffer_pool.max_page_size / PAGE_SIZE;
+    std::vector<buf_descriptor_t *> buf_descs;
+    std::vector<aio_request_t> requests;
+    buf_descs.reserve(num_pages);
+    requests.reserve(num_pages);
+    lsn_t max_lsn = 0;
+
+    for (uint32_t i = 0; i < num_pages; i++) {
+        uint32_t partition = get_ht_partition(pages[i].table_id, pages[i].page_num);
+        buffer_pool.hashtable.partitions[partition].latch.lock();
+        buf_descriptor_t *buf_desc = hashtable_lookup(pages[i].table_id, pages[i].page_num);
+        if (buf_desc != nullptr && buf_desc->reference_count.fetch_add(1) == 0)
+            metric_pinned(1);
+        buffer_pool.hashtable.partitions[partition].latch.unlock();
+        if (buf_desc == nullptr)
+            continue;
+
+        {
+            std::shared_lock<std::shared_mutex> guard(buf_desc->content_latch);
+            if (buf_desc->is_dirty) {
+                // 복사 이후의 수정은 다시 dirty로 표시되어 다음에 쓰임
+                begin_buffer_write(buf_desc);
+                page_t *copy = &copies[requests.size() * copy_stride];
+                memcpy(copy, buf_desc->buf_page, buf_page_size(buf_desc));
+                max_lsn = std::max(max_lsn, buf_desc->page_lsn);
+                trace_event(TRACE_FLUSH, pages[i].table_id, pages[i].page_num,
+                            buf_desc - buffer_pool.buf_descriptors);
+                requests.push_back({pages[i].table_id, pages[i].page_num, copy,
+                                    true, write_buffer_done, buf_desc, nullptr});
+            }
+        }
+        buf_descs.push_back(buf_desc);
+    }
+
+    aio_batch_t batch;
+    aio_init_batch(&batch);
+    bool ok = true;
+    // 복사한 내용의 update record들을 먼저 기록
+    if (wal_flush(max_lsn) != 0) {
+        for (aio_request_t &request : requests)
+            set_buffer_dirty((buf_descriptor_t *)request.arg);
+        requests.clear();
+    } else if (aio_submit(requests.data(), requests.size(), &batch) != 0) {
+        // 제출하지 못했으면 복사본을 동기로 씀
+        for (aio_request_t &request : requests)
+            write_table_page(request.table_id, request.page_num, request.page);
+    } else {
+        ok = aio_wait(&batch) == 0;
+    }
+    for (aio_request_t &request : requests) {
+        // 쓰기가 끝난 page만 rec_lsn을 지움, async 쓰기가 실패해 다시 dirty가 된 page는 동기로 씀
+        buf_descriptor_t *buf_desc = (buf_descriptor_t *)request.arg;
+        std::shared_lock<std::shared_mutex> guard(buf_desc->content_latch);
+        if (!ok && buf_desc->is_dirty)
             flush_buffer(buf_desc);
+        else
+            clear_buffer_dirty(buf_desc);
+    }
+    for (buf_descriptor_t *buf_desc : buf_descs)
+        unpin_buffer(buf_desc);
+    metric_add(METRIC_CHECKPOINT_WRITE, requests.size());
+    return requests.size();
+}
+
+/**
+ * @brief Collect the dirty pages of a table, or of all tables if table_id is
+ * -1, sorted by (table_id, page_num).
+ * 
+ * @details Reads the dirty-page index, so only dirty buffers are visited.
+ */
+void collect_dirty_pages(int64_t table_id, std::vector<checkpoint_page_t> *pages) {
+    // tag는 I/O latch를 잡아야 바뀌지 않으므로 latch를 잡고 읽음
+    for_each_dirty_buffer([table_id, pages](buf_descriptor_t *buf_desc) {
+        if (!buf_desc->is_dirty)
+            return;
+        std::lock_guard<std::mutex> io_guard(buf_desc->io_latch);
+        if (buf_desc->is_dirty && buf_desc->table_id != -1 &&
+            (table_id == -1 || buf_desc->table_id == table_id))
+            pages->push_back({buf_desc->table_id, buf_desc->page_num});
+    });
+    std::sort(pages->begin(), pages->end(),
+              [](const checkpoint_page_t &a, const checkpoint_page_t &b) {
+                  if (a.table_id != b.table_id)
+                      return a.table_id < b.table_id;
+                  return a.page_num < b.page_num;
+              });
+}
+
+/**
+ * @brief Write sorted pages in batches, spread over duration_ms.
+ * 
+ * @return The number of pages written.
+ */
+uint64_t write_dirty_pages(const std::vector<checkpoint_page_t> &pages, uint32_t duration_ms) {
+    page_t *copies = new page_t[CHECKPOINT_BATCH_PAGES * (buffer_pool.max_page_size / PAGE_SIZE)];
+    uint64_t start_ns = metrics_now_ns();
+    uint64_t num_written = 0;
+    for (size_t first = 0; first < pages.size(); first += CHECKPOINT_BATCH_PAGES) {
+        uint32_t num_pages = std::min<size_t>(CHECKPOINT_BATCH_PAGES, pages.size() - first);
+        num_written += checkpoint_batch(&pages[first], num_pages, copies);
+
+        if (duration_ms > 0) {
+            uint64_t target_ns = (uint64_t)duration_ms * 1000000 * (first + num_pages) / pages.size();
+            uint64_t elapsed_ns = metrics_now_ns() - start_ns;
+            if (elapsed_ns < target_ns)
+                std::this_thread::sleep_for(std::chrono::nanoseconds(target_ns - elapsed_ns));
         }
     }
+    delete[] copies;
+    return num_written;
+}
 
-    delete[] buffer_pool.hashtable.ht_entries;
-    delete[] buffer_pool.buf_descriptors;
-    delete[] buffer_pool.buf_pages;
+/**
+ * @brief Write every page that is dirty when the checkpoint starts.
+ * 
+ * @param duration_ms The time to spread the writes over, 0 to write at full
+ * speed
+ * @retval 0: successful
+ * @retval others: failed to sync the table files or to write the log
+ * 
+ * @details The dirty pages are collected from the dirty-page index first,
+ * sorted by (table_id, page_num), and written CHECKPOINT_BATCH_PAGES at a
+ * time, so each batch becomes a few large sequential writes after
+ * aio_submit() coalesces adjacent pages. After each batch, the checkpoint sleeps until the share of
+ * duration_ms for the pages written so far has passed, which caps its I/O
+ * rate at (number of dirty pages) / duration_ms.
+ * 
+ * get_buffer() and page modifications go on during the checkpoint. A page
+ * dirtied again after it was copied stays dirty, and a page dirtied after the
+ * snapshot is left to the next checkpoint. The table files are synced at the
+ * end, so every page dirty at the start is durable when this returns.
+ * Checkpoints do not run concurrently; a second caller waits for the first.
+ * 
+ * With the log open, the checkpoint then moves the log's redo position to
+ * its start, so recovery skips the updates written by it.
+ */
+int checkpoint_buffer_pool(uint32_t duration_ms) {
+    std::lock_guard<std::mutex> guard(buffer_pool.checkpoint_latch);
+    // 이 위치 앞의 update가 있는 page는 모두 아래에서 dirty로 보임
+    lsn_t redo_lsn = wal_begin_checkpoint();
+
+    std::vector<checkpoint_page_t> pages;
+    collect_dirty_pages(-1, &pages);
+    buf_log_info("Checkpoint: " << pages.size() << " dirty pages");
+
+    uint64_t start_ns = metrics_now_ns();
+    uint64_t num_written = write_dirty_pages(pages, duration_ms);
+
+    int ret = aio_sync();
+    // table file이 sync된 뒤에야 redo 위치를 옮길 수 있음
+    if (ret == 0)
+        ret = wal_end_checkpoint(redo_lsn);
+    buf_log_info("Checkpoint: wrote " << num_written << " pages in "
+                 << (metrics_now_ns() - start_ns) / 1000000 << "ms");
+    return ret;
+}
+
+/**
+ * @brief Write the dirty pages of one table and sync its file.
+ * 
+ * @retval 0: successful
+ * @retval others: failed to sync the table files
+ * 
+ * @details Like checkpoint_buffer_pool() at full speed, but only the table's
+ * pages are visited and written. The log's redo position does not move.
+ */
+int flush_table(int64_t table_id) {
+    std::lock_guard<std::mutex> guard(buffer_pool.checkpoint_latch);
+    std::vector<checkpoint_page_t> pages;
+    collect_dirty_pages(table_id, &pages);
+    write_dirty_pages(pages, 0);
+    return aio_sync();
+}
+
+/**
+ * @brief Get the LSN of the oldest update not yet written to a table file.
+ * 
+ * @return The smallest rec_lsn of the dirty buffers and the buffers being
+ * written, or 0 if none has a logged update.
+ * 
+ * @details The log before this position is needed only for pages that are
+ * already written. Pages dirtied without log_buffer_update() are not counted.
+ * A page keeps its rec_lsn until its write is done, so a write in flight
+ * still holds the position back.
+ */
+lsn_t get_oldest_dirty_lsn() {
+    lsn_t oldest = 0;
+    for_each_dirty_buffer([&oldest](buf_descriptor_t *buf_desc) {
+        lsn_t rec_lsn = buf_desc->rec_lsn;
+        if (rec_lsn != 0 && (oldest == 0 || rec_lsn < oldest))
+            oldest = rec_lsn;
+    });
+    return oldest;
+}
+
+/**
+ * @brief Evict the page of a buffer pinned only by the caller and leave the
+ * buffer unmapped.
+ * 
+ * @retval true: the buffer is unmapped, still pinned by the caller
+ * @retval false: someone else pinned or dirtied the buffer meanwhile
+ * 
+ * @details Like map_buffer() without a new page: a dirty page is written
+ * first, and a clean page is offered to the compressed cache.
+ */
+bool unmap_buffer(buf_descriptor_t *buf_desc) {
+    static thread_local zcache_image_t image;
+    std::lock_guard<std::mutex> io_guard(buf_desc->io_latch);
+
+    bool was_dirty = false;
+    if (buf_desc->is_dirty) {
+        std::shared_lock<std::shared_mutex> guard(buf_desc->content_latch);
+        flush_buffer(buf_desc);
+        was_dirty = true;
+    }
+    unswizzle_buffer(buf_desc);
+
+    bool is_compressed = false;
+    if (zcache_is_open() && buf_desc->buf_page == get_buffer_frame(buf_desc) &&
+        buf_desc->content_latch.try_lock_shared()) {
+        is_compressed = zcache_compress(buf_desc->buf_page, buf_page_size(buf_desc), &image);
+        buf_desc->content_latch.unlock_shared();
+    }
+    uint32_t partition = get_ht_partition(buf_desc->table_id, buf_desc->page_num);
+    std::lock_guard<std::mutex> guard(buffer_pool.hashtable.partitions[partition].latch);
+    if (buf_desc->reference_count != 1 || buf_desc->is_dirty)
+        return false;
+
+    buf_desc->version += 2;
+    evict_buffer(buf_desc, was_dirty, is_compressed ? &image : nullptr);
+    buf_desc->table_id = -1;
+    buf_desc->page_num = -1;
+    if (buf_desc->buf_page != get_buffer_frame(buf_desc))
+        buf_desc->buf_page = get_buffer_frame(buf_desc);
+    buf_desc->is_valid = false;
+    buf_desc->usage_count = 0;
+    return true;
+}
+
+/**
+ * @brief Write and evict every page of a table that no one else has pinned.
+ * 
+ * @details Used when buffer_open_table() fails after redoing some of the
+ * table's pages, so its id is never returned and the pages would otherwise
+ * wait for the replacement policy. Their compressed images are dropped too,
+ * since the file layer may give the id to another file later.
+ */
+void evict_table_buffers(int64_t table_id) {
+    std::lock_guard<std::mutex> guard(buffer_pool.resize_latch);
+    buf_size_class_t *size_class = &buffer_pool.size_classes[get_table_info(table_id)->size_class];
+    for (uint32_t i = 0; i < size_class->num_buf; i++) {
+        buf_descriptor_t *buf_desc = &buffer_pool.buf_descriptors[size_class->first_buf + i];
+        int expected = 0;
+        if (buf_desc->table_id != table_id ||
+            !buf_desc->reference_count.compare_exchange_strong(expected, 1))
+            continue;
+        metric_pinned(1);
+        // pin하기 전에 다른 page로 바뀌었다면 그대로 둠
+        uint64_t key = ht_key(table_id, buf_desc->page_num);
+        if (buf_desc->table_id != table_id || !unmap_buffer(buf_desc)) {
+            unpin_buffer(buf_desc);
+            continue;
+        }
+        zcache_insert(key, nullptr);
+        release_victim(buf_desc);
+    }
+}
+
+// resize_latch를 잡고 호출, 모든 partition을 num_ht_entries에 맞게 차례로 다시 만듦
+int rehash_hashtable(uint64_t num_ht_entries) {
+    uint32_t num_slots = get_ht_partition_slots(num_ht_entries);
+    int result = 0;
+    for (uint32_t p = 0; p < buffer_pool.hashtable.num_partitions; p++) {
+        ht_partition_t *ht_partition = &buffer_pool.hashtable.partitions[p];
+        std::lock_guard<std::mutex> guard(ht_partition->latch);
+        // 이미 담은 entry가 HT_MAX_LOAD_PERCENT를 넘지 않을 만큼은 남김
+        uint64_t partition_slots = num_slots;
+        while (partition_slots * HT_MAX_LOAD_PERCENT < (uint64_t)(ht_partition->num_used + 1) * 100)
+            partition_slots *= 2;
+        if (!rehash_ht_partition(p, partition_slots))
+            result = 1;
+    }
+    buf_log_info("Hashtable resized to " << buffer_pool.hashtable.num_ht_entries << " entries");
+    return result;
+}
+
+/**
+ * @brief Change the number of hashtable entries while the pool is in use.
+ * 
+ * @retval 0: successful
+ * @retval others: some partitions are out of memory and kept their size
+ * 
+ * @details The partitions are rebuilt one at a time, each under its own
+ * latch, so only the pages of the partition being rebuilt wait. A partition
+ * never gets fewer slots than it needs for the pages it holds. The number of
+ * partitions stays the same.
+ * 
+ * Inserts do not grow a partition, so a hashtable shrunk here must be
+ * resized again before its partitions fill up (see buffer.h).
+ */
+int resize_hashtable(uint32_t num_ht_entries) {
+    std::lock_guard<std::mutex> guard(buffer_pool.resize_latch);
+    return rehash_hashtable(num_ht_entries);
+}
+
+// 줄어드는 class에서 [first, last)의 descriptor를 모두 빼냄, 제한 시간 안에 못 빼면 되돌림
+int drain_buffers(buf_size_class_t *size_class, uint32_t first, uint32_t last) {
+    std::vector<bool> is_retired(last - first, false);
+    uint32_t num_retired = 0;
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::milliseconds(RESIZE_DRAIN_TIMEOUT_MS);
+
+    while (true) {
+        // freelist를 통째로 가져와 빠질 buffer는 빼고 나머지를 같은 순서로 되돌림
+        uint64_t head = size_class->free_list_head.load();
+        while (!size_class->free_list_head.compare_exchange_weak(
+                   head, free_list_pack(free_list_tag(head) + 1, FREE_LIST_END)))
+            ;
+        std::vector<buf_descriptor_t *> kept;
+        for (uint32_t index = free_list_index(head); index != FREE_LIST_END;) {
+            buf_descriptor_t *buf_desc = &buffer_pool.buf_descriptors[index];
+            index = buf_desc->free_next;
+            size_class->num_free--;
+            uint32_t i = buf_desc - buffer_pool.buf_descriptors - size_class->first_buf;
+            if (i >= first && i < last) {
+                // freelist가 소유하던 pin을 그대로 retired 표시로 바꿈
+                buf_desc->reference_count = BUF_RETIRED_PINS;
+                is_retired[i - first] = true;
+                num_retired++;
+            } else {
+                kept.push_back(buf_desc);
+            }
+        }
+        for (auto it = kept.rbegin(); it != kept.rend(); ++it)
+            add_to_freelist(*it);
+
+        for (uint32_t i = first; i < last; i++) {
+            buf_descriptor_t *buf_desc = &buffer_pool.buf_descriptors[size_class->first_buf + i];
+            int expected = 0;
+            if (is_retired[i - first] ||
+                !buf_desc->reference_count.compare_exchange_strong(expected, 1))
+                continue;
+            metric_pinned(1);
+            if (buf_desc->table_id != -1 && !unmap_buffer(buf_desc)) {
+                unpin_buffer(buf_desc);
+                continue;
+            }
+            buf_desc->reference_count = BUF_RETIRED_PINS;
+            metric_pinned(-1);
+            is_retired[i - first] = true;
+            num_retired++;
+        }
+
+        if (num_retired == last - first)
+            return 0;
+        if (std::chrono::steady_clock::now() >= deadline)
+            break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // 빼낸 buffer를 다시 freelist로 돌려놓음
+    buf_log_error("Error: buffers are still pinned after " << RESIZE_DRAIN_TIMEOUT_MS << "ms");
+    for (uint32_t i = first; i < last; i++) {
+        if (!is_retired[i - first])
+            continue;
+        buf_descriptor_t *buf_desc = &buffer_pool.buf_descriptors[size_class->first_buf + i];
+        buf_desc->reference_count = 1;
+        add_to_freelist(buf_desc);
+    }
+    return 1;
+}
+
+/**
+ * @brief Change the number of buffers of a size class while the pool is in
+ * use.
+ * 
+ * @param num_buf The new number of buffers of the class, from 4 to the
+ * class's max_num_buf
+ * @param page_size The page size of the class
+ * @retval 0: successful
+ * @retval others: failed, and the class keeps its size
+ * 
+ * @details Growing allocates frames for descriptors that never had one and
+ * puts the new buffers on the freelist, so they are taken before anything is
+ * evicted. The hashtable grows along so that its load factor stays at most
+ * 50%.
+ * 
+ * Shrinking removes the buffers at the end of the class. The class stops
+ * sweeping over them at once, and each is then evicted as soon as it is
+ * unpinned: dirty pages are written, clean pages go to the compressed cache
+ * if it is open. Other threads keep using the pool meanwhile, only the pages
+ * being evicted wait. If some buffer stays pinned for RESIZE_DRAIN_TIMEOUT_MS,
+ * the class keeps its size and 1 is returned. The memory of the removed
+ * frames is given back to the OS, and their descriptors are reused by a
+ * later grow.
+ */
+int resize_buffer_pool(uint32_t num_buf, uint32_t page_size) {
+    std::lock_guard<std::mutex> guard(buffer_pool.resize_latch);
+    int c = find_size_class(page_size);
+    if (c < 0)
+        return 1;
+    buf_size_class_t *size_class = &buffer_pool.size_classes[c];
+    uint32_t old_num_buf = size_class->num_buf;
+    if (num_buf < 4 || num_buf > size_class->max_num_buf)
+        return 1;
+    buf_log_info("Resizing size class " << c << " from " << old_num_buf << " to " << num_buf
+                 << " buffers");
+
+    if (num_buf > old_num_buf) {
+        // 한 번도 쓰지 않은 descriptor에는 frame을 새로 할당
+        if (num_buf > size_class->num_init_buf) {
+            uint32_t arena_first = size_class->num_init_buf;
+            arena_t page_arena = {};
+            if (arena_alloc(&page_arena, (size_t)size_class->page_size * (num_buf - arena_first)))
+                return 1;
+            if (buffer_pool.numa_mode != BUF_NUMA_NONE)
+                arena_place(&page_arena, size_class->page_size, num_buf - arena_first,
+                            buffer_pool.numa_mode);
+            size_class->page_arenas.push_back(page_arena);
+            init_buf_descriptors(c, arena_first, num_buf, &size_class->page_arenas.back(),
+                                 arena_first);
+            size_class->num_init_buf = num_buf;
+        }
+        // clock이 freelist에 넣기 전의 buffer를 가져가지 않도록 먼저 freelist의 pin을 둠
+        for (uint32_t i = old_num_buf; i < num_buf; i++) {
+            buf_descriptor_t *buf_desc = &buffer_pool.buf_descriptors[size_class->first_buf + i];
+            buf_desc->usage_count = 0;
+            buf_desc->reference_count = 1;
+        }
+        size_class->num_buf = num_buf;
+        buffer_pool.num_buf += num_buf - old_num_buf;
+        // 배열 앞쪽 descriptor부터 나가도록 역순으로 추가
+        for (uint32_t i = num_buf; i-- > old_num_buf;)
+            add_to_freelist(&buffer_pool.buf_descriptors[size_class->first_buf + i]);
+        buffer_pool.policy->on_resize(c);
+        if (buffer_pool.hashtable.num_ht_entries < 2 * (uint64_t)buffer_pool.num_buf)
+            rehash_hashtable(2 * (uint64_t)buffer_pool.num_buf);
+    } else if (num_buf < old_num_buf) {
+        size_class->num_buf = num_buf;
+        if (drain_buffers(size_class, num_buf, old_num_buf)) {
+            size_class->num_buf = old_num_buf;
+            return 1;
+        }
+        buffer_pool.num_buf -= old_num_buf - num_buf;
+        buffer_pool.policy->on_resize(c);
+        set_readahead_window(buffer_pool.readahead_window);
+
+        // 빠진 frame의 메모리를 OS에 돌려줌, 이어진 frame은 한 번에
+        size_t frame_size = size_class->page_size;
+        for (uint32_t i = num_buf; i < old_num_buf;) {
+            char *start = (char *)buffer_pool.buf_descriptors[size_class->first_buf + i].frame;
+            char *end = start + frame_size;
+            for (i++; i < old_num_buf &&
+                      (char *)buffer_pool.buf_descriptors[size_class->first_buf + i].frame == end; i++)
+                end += frame_size;
+            madvise(start, end - start, MADV_DONTNEED);
+        }
+    }
+    buf_log_info("Size class " << c << " has " << size_class->num_buf << " buffers");
+    return 0;
+}
+
+int close_buffer_pool() {
+    stop_bg_writer();
+    // buffer를 내보내기 전에 마지막 dump를 씀
+    warm_close();
+    // thread들이 들고 있는 빈 page를 space map에 돌려놓은 뒤 checkpoint
+    alloc_close();
+
+//  TODO -----------------------------------------------------------------------
+// dirty 상태의 buffer descriptor들을 flush 해주어야 함
+    // 모든 update가 table file에 기록되었다면 log를 비움
+    wal_close(checkpoint_buffer_pool(0) == 0);
+    aio_shutdown();
+    zcache_close();
+
+    buffer_pool.policy->destroy();
+    for (uint32_t p = 0; p < buffer_pool.hashtable.num_partitions; p++)
+        std::free(buffer_pool.hashtable.partitions[p].slots.load());
+    while (ht_slots_t *slots = buffer_pool.hashtable.retired_slots) {
+        buffer_pool.hashtable.retired_slots = slots->next_retired;
+        std::free(slots);
+    }
+    delete[] buffer_pool.hashtable.partitions;
+    delete[] buffer_pool.dirty_bitmap;
+    delete[] buffer_pool.dirty_summary;
+    // 줄어든 class의 빠진 descriptor도 한 번 초기화했으므로 함께 정리
+    for (uint32_t c = 0; c < buffer_pool.num_size_classes; c++) {
+        buf_size_class_t *size_class = &buffer_pool.size_classes[c];
+        for (uint32_t i = 0; i < size_class->num_init_buf; i++)
+            buffer_pool.buf_descriptors[size_class->first_buf + i].~buf_descriptor_t();
+        for (arena_t &page_arena : size_class->page_arenas)
+            arena_free(&page_arena);
+        size_class->page_arenas.clear();
+    }
+    arena_free(&buffer_pool.desc_arena);
+    mapped_close();
 //  ----------------------------------------------------------------------------
 
     file_close_table_files();
+    for (std::atomic<buf_table_info_t *> &chunk : buffer_pool.table_chunks)
+        delete[] chunk.exchange(nullptr);
 
     return 0;
 }
 
 void init_buffer_stat() {
-    stat_get_buffer = 0;
+    metrics_reset();
+    stat_aio_read_page = 0;
+    stat_aio_write_page = 0;
     stat_read_page = 0;
     stat_write_page = 0;
 }
 
+/**
+ * @brief Get the percentage of get_buffer() calls that found the page.
+ * 
+ * @details 0 if get_buffer() has not been called since init_buffer_stat().
+ */
 int64_t get_buffer_hit_ratio() {
-    return (stat_get_buffer - stat_read_page) * 100 /
-           (stat_get_buffer);
+    buf_stat_snapshot_t snapshot;
+    get_buffer_stat_snapshot(&snapshot);
+    return snapshot.hit_ratio;
 }
 
 std::string get_buffer_stat() {
-    int64_t hit_ratio = get_buffer_hit_ratio();
-
-    return string_format("get_buffer() count: %ld, file_read_page() count: %ld, file_write_page() count: %ld, buffer hit ratio: %ld%%",
-                          stat_get_buffer, stat_read_page, stat_write_page, hit_ratio);
+    buf_stat_snapshot_t snapshot;
+    get_buffer_stat_snapshot(&snapshot);
+    const buf_stat_snapshot_t *s = &snapshot;
+
+    std::string stat = string_format("get_buffer() count: %lu, file_read_page() count: %ld, file_write_page() count: %ld, async read count: %ld, async write count: %ld, foreground write count: %lu, background write count: %lu, checkpoint write count: %lu, clean eviction count: %lu, dirty eviction count: %lu, clock sweep steps per victim: %.2f, pinned high water: %ld, prefetch count: %lu, prefetch hit count: %lu, prefetch unused count: %lu, hit latency p50/p99: %lu/%luns, miss latency p50/p99: %lu/%luns, buffer hit ratio: %ld%%",
+                          s->counters[METRIC_GET_BUFFER], (long)s->read_pages, (long)s->write_pages,
+                          (long)s->aio_read_pages, (long)s->aio_write_pages,
+                          s->counters[METRIC_FG_WRITE], s->counters[METRIC_BG_WRITE],
+                          s->counters[METRIC_CHECKPOINT_WRITE], s->counters[METRIC_EVICT_CLEAN], s->counters[METRIC_EVICT_DIRTY],
+                          s->sweep_steps_per_victim, (long)s->pinned_high_water,
+                          s->counters[METRIC_PREFETCH_PAGE], s->counters[METRIC_PREFETCH_HIT],
+                          s->counters[METRIC_PREFETCH_UNUSED],
+                          s->latencies[LATENCY_HIT].p50_ns, s->latencies[LATENCY_HIT].p99_ns,
+                          s->latencies[LATENCY_MISS].p50_ns, s->latencies[LATENCY_MISS].p99_ns,
+                          (long)s->hit_ratio);
+    if (s->zcache.budget_bytes > 0) {
+        stat += string_format(", compressed cache hit ratio: %.2f%%, compression ratio: %.2f, compressed cache pages: %lu (%lu/%lu bytes)",
+                              s->zcache_hit_ratio, s->compression_ratio, s->zcache.num_pages,
+                              s->zcache.used_bytes, s->zcache.budget_bytes);
+    }
+    if (s->num_size_classes > 1) {
+        stat += string_format(", memory efficiency: %.2f%%", s->memory_efficiency);
+        for (uint32_t i = 0; i < s->num_size_classes; i++) {
+            const buf_class_stat_t *size_class = &s->size_classes[i];
+            stat += string_format(", %uKB pages: %u/%u buffers used, hit ratio %.2f%%",
+                                  size_class->page_size >> 10, size_class->num_used,
+                                  size_class->num_buf, size_class->hit_ratio);
+        }
+    }
+    return stat;
 }
 
 void print_buffer_stat() {
@@ -1,12 +1,23 @@
 #ifndef DB_BUFFER_H_
 #define DB_BUFFER_H_
 
+#include "arena.h"
+#include "metrics.h"
 #include "page.h"
+#include "replacement.h"
+#include "wal.h"
+#include "zcache.h"
 
+#include <atomic>
+#include <condition_variable>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <string>
 #include <stdexcept>
+#include <thread>
+#include <vector>
 
 template<typename ... Args>
 std::string string_format( const std::string& format, Args ... args )
@@ -25,67 +36,468 @@ std::string string_format( const std::string& format, Args ... args )
 
 #define MAX_USAGE_COUNT (5)
 
-// For stat
-extern int64_t stat_get_buffer;
+// hashtable을 나누는 partition 개수의 상한, partition마다 latch를 따로 둔다
+#define NUM_HT_PARTITIONS (128)
+// partition 하나에 평균적으로 들어갈 최소 buffer 수
+// (이보다 적으면 partition 간 쏠림으로 한 partition이 가득 찰 수 있음)
+#define MIN_BUF_PER_HT_PARTITION (256)
+
+// buffer access strategy의 ring 크기 (page 수)
+#define BULK_READ_RING_SIZE (64)      // 256KB, sequential scan
+#define BULK_WRITE_RING_SIZE (4096)   // 16MB, bulk insert/load
+#define VACUUM_RING_SIZE (64)         // 256KB, vacuum 같은 전체 정리 작업
+// ring은 pool의 1/8을 넘지 않음
+#define MAX_RING_FRACTION (8)
+
+// size class의 page 크기 상한 (64KB), WAL record의 offset이 16bit이므로 더 키울 수 없음
+#define MAX_BUF_PAGE_SIZE (64 * 1024)
+// buffer pool이 받는 table 수 (ht_key()의 table_id는 16bit)
+#define MAX_BUF_TABLES (1 << 16)
+// table 정보를 한 번에 할당하는 table 수
+#define BUF_TABLE_CHUNK_SIZE (256)
+
+// freelist의 끝(또는 빈 freelist)을 나타내는 descriptor index
+#define FREE_LIST_END (UINT32_MAX)
+
+// page를 식별하는 key: table_id는 상위 16bit, page_num은 하위 48bit에 담음
+#define ht_key(table_id, page_num) \
+    ((((uint64_t)(table_id)) << 48) | (((uint64_t)(page_num)) & ((1ULL << 48) - 1)))
+
+// background writer가 한 round에 검사하는 descriptor 수 (max_pages_per_round의 배수)
+#define BG_WRITER_SCAN_FACTOR (4)
+
+// checkpoint가 한 번에 복사해 쓰는 page 수 (PAGE_SIZE page면 512KB)
+#define CHECKPOINT_BATCH_PAGES (128)
+
+// read-ahead로 미리 읽는 page 수의 기본값과 상한
+#define READAHEAD_WINDOW (32)
+#define MAX_READAHEAD_WINDOW (256)
+// 같은 간격으로 이만큼 연속 접근하면 read-ahead 시작
+#define READAHEAD_MIN_RUN (3)
+// read-ahead가 따라가는 page 간격(stride)의 상한
+#define READAHEAD_MAX_STRIDE (8)
+// 접근 pattern을 추적하는 slot 수, table_id로 나누어 씀
+#define NUM_READAHEAD_SLOTS (64)
+// 읽는 중인 prefetch가 pin할 수 있는 buffer는 pool의 1/4까지
+#define MAX_PREFETCH_FRACTION (4)
+
+// 낙관적 읽기가 충돌로 다시 시도하는 횟수, 넘으면 pin하고 읽음
+#define OPTIMISTIC_READ_RETRIES (4)
+// 낙관적 읽기 중 이만큼에 한 번만 교체 정책에 참조를 알림
+#define OPTIMISTIC_USAGE_SAMPLE (16)
+
+// 초기화를 나누어 맡는 thread 하나가 최소한 맡는 buffer 수 (64MB)
+#define MIN_BUF_PER_INIT_THREAD (16384)
+
+// size class의 buffer 수를 정하지 않았을 때 resize_buffer_pool()로 늘릴 수 있는 배수
+#define BUF_DEFAULT_GROWTH (4)
+// 크기가 줄어 빠진 descriptor의 reference_count, 0이 되지 않으므로 교체 대상이 되지 않음
+#define BUF_RETIRED_PINS (1 << 30)
+// resize_buffer_pool()이 빠질 buffer의 pin이 풀리기를 기다리는 시간
+#define RESIZE_DRAIN_TIMEOUT_MS (10000)
+// resize_hashtable()이 partition의 slot을 줄일 때 남기는 최대 load factor (%)
+#define HT_MAX_LOAD_PERCENT (90)
+
+// BUF_PRIORITY_KEEP으로 남겨 둘 수 있는 buffer는 size class의 1/n까지
+#define BUF_MAX_KEEP_FRACTION (4)
+
+// get_buffer()에 주는 page의 우선순위 힌트
+typedef enum buf_priority_t {
+    BUF_PRIORITY_NORMAL,    // 교체 정책을 따름
+    BUF_PRIORITY_KEEP       // header page, root 같은 page를 교체하지 않고 남겨 둠
+} buf_priority_t;
+
+// get_buffer()가 pin과 함께 잡아 주는 page latch의 종류
+typedef enum buf_latch_mode_t {
+    BUF_LATCH_NONE,         // pin만 하고 latch는 잡지 않음
+    BUF_LATCH_SHARED,       // 여러 reader가 함께 읽음
+    BUF_LATCH_EXCLUSIVE     // 하나의 writer만 수정
+} buf_latch_mode_t;
+
+// buffer_open_table()로 여는 table의 접근 방식
+typedef enum buf_table_mode_t {
+    BUF_TABLE_READ_WRITE,       // page를 frame에 복사해 읽고 씀
+    BUF_TABLE_MMAP,             // 읽기 전용, buffer가 mmap한 file의 page를 직접 가리킴
+    BUF_TABLE_MMAP_SEQUENTIAL,  // BUF_TABLE_MMAP, 주로 scan하는 table (MADV_SEQUENTIAL)
+    BUF_TABLE_MMAP_RANDOM       // BUF_TABLE_MMAP, 주로 point lookup하는 table (MADV_RANDOM)
+} buf_table_mode_t;
+
+// table_id별 정보, 처음 여는 table이 속한 chunk 단위로 할당
+typedef struct buf_table_info_t {
+    // buffer_open_table()에서 정한 size class
+    uint8_t size_class;
+    // buffer에 있는 page 수와 set_table_quota()로 정한 quota (0이면 없음)
+    std::atomic<uint32_t> num_buf;
+    std::atomic<uint32_t> soft_quota;
+    std::atomic<uint32_t> hard_quota;
+    // hard quota에 닿은 table이 교체할 자기 page를 찾을 때 이어서 볼 size class 안의 위치
+    std::atomic<uint32_t> victim_hand;
+} buf_table_info_t;
+
+// hashtable의 latch 구성, init_buffer_pool() 전에 set_ht_latch_mode()로 정함
+typedef enum buf_ht_latch_mode_t {
+    BUF_HT_PARTITIONED,     // partition마다 latch (기본값)
+    BUF_HT_SINGLE_LATCH     // partition 하나, 모든 lookup이 latch 하나를 공유 (비교용)
+} buf_ht_latch_mode_t;
+
+// 대량 접근을 위한 buffer access strategy의 종류
+typedef enum buf_strategy_kind_t {
+    BUF_STRATEGY_BULK_READ,
+    BUF_STRATEGY_BULK_WRITE,
+    BUF_STRATEGY_VACUUM
+} buf_strategy_kind_t;
+
+struct buf_swip_t;
 
 typedef struct buf_descriptor_t {
     int64_t table_id;
     pagenum_t page_num;
+    // 보통은 descriptor의 frame, mmap한 table의 page를 담으면 mapping 안의 page
     page_t *buf_page;
+    // descriptor 고유의 frame, 바뀌지 않음
+    page_t *frame;
+    // buf_page의 크기를 정하는 size class (buffer_pool.size_classes의 index), 바뀌지 않음
+    uint32_t size_class;
 //  TODO -----------------------------------------------------------------------
-    int reference_count;
-    int usage_count;
-    bool is_dirty;
+    // 여러 thread가 동시에 pin/unpin 하므로 atomic counter로 관리
+    std::atomic<int> reference_count;
+    std::atomic<int> usage_count;
+    std::atomic<bool> is_dirty;
+    // page 읽기가 끝나 buf_page의 내용이 유효한지
+    std::atomic<bool> is_valid;
+    // prefetch로 올라온 뒤 아직 get_buffer()로 사용되지 않았는지
+    std::atomic<bool> is_prefetched;
+    // BUF_PRIORITY_KEEP으로 읽어 교체 대상에서 빠진 page인지
+    std::atomic<bool> is_kept;
+    // 이 page의 마지막 update record가 끝나는 LSN, page를 쓰기 전에 log를 여기까지 씀
+    lsn_t page_lsn;
+    // clean이던 page를 처음 dirty로 만든 update의 LSN, clean이거나 log가 없으면 0
+    std::atomic<lsn_t> rec_lsn;
+    // exclusive latch를 잡고 있는 동안 홀수, page가 바뀌거나 다른 page로 교체될 때마다 증가
+    std::atomic<uint64_t> version;
+    // I/O latch: tag(table_id, page_num) 변경과 page 읽기/쓰기를 보호
+    std::mutex io_latch;
+    // content latch: buf_page 내용을 보호하는 reader/writer latch
+    std::shared_mutex content_latch;
+    // exclusive latch를 잡고 있는 thread, 없으면 std::thread::id()
+    std::atomic<std::thread::id> exclusive_owner;
+    // freelist에서 다음 descriptor의 index (buf_descriptors 배열에 내장된 연결)
+    std::atomic<uint32_t> free_next;
+    // 이 buffer를 직접 가리키도록 swizzle된 참조, 없으면 nullptr (io_latch로 보호)
+    buf_swip_t *swip;
 //  ----------------------------------------------------------------------------
 } buf_descriptor_t;
 
-typedef struct ht_entry_t {
+// optimistic_read_begin()으로 시작한 낙관적 읽기
+typedef struct buf_optimistic_read_t {
+    int64_t table_id;
+    pagenum_t page_num;
     buf_descriptor_t *buf_desc;
-    // 해시 충돌 해결을 위한 체이닝 포인터
-    ht_entry_t *next;
+    // 시작할 때 읽은 buf_desc->version
+    uint64_t version;
+} buf_optimistic_read_t;
+
+// 사용자가 들고 있는 page 참조 (swip), page가 pool에 있으면 buffer를 직접 가리킴
+// buffer 하나는 swip 하나에만 swizzle되며, page를 교체할 때 pool이 되돌림
+typedef struct buf_swip_t {
+    int64_t table_id;
+    pagenum_t page_num;
+    // swizzle된 buffer, 아니면 nullptr
+    std::atomic<buf_descriptor_t *> buf_desc;
+} buf_swip_t;
+
+// open addressing hashtable의 slot (16 bytes, cache line 하나에 4개)
+// descriptor를 따라가지 않고 slot 안의 key만 비교해 찾을 수 있음
+// latch 없이 읽는 낙관적 lookup이 있으므로 field마다 atomic
+typedef struct ht_entry_t {
+    // (table_id, page_num)을 묶은 key
+    std::atomic<uint64_t> key;
+    // buf_descriptors 배열에서의 index
+    std::atomic<uint32_t> buf_index;
+    // home slot으로부터의 거리 + 1, 0이면 빈 slot (Robin Hood hashing)
+    std::atomic<uint32_t> probe_len;
 } ht_entry_t;
 
+// partition 하나의 slot 배열, 크기를 바꿀 때는 새 배열을 만들어 통째로 바꿔 끼움
+typedef struct alignas(64) ht_slots_t {
+    // 2의 거듭제곱
+    uint32_t num_slots;
+    ht_entry_t *entries;
+    // 바꿔 끼운 뒤 retired_slots에 연결하는 다음 배열
+    ht_slots_t *next_retired;
+} ht_slots_t;
+
+// partition마다 독립된 open addressing table을 가지며, latch로 보호된다
+typedef struct alignas(64) ht_partition_t {
+    std::mutex latch;
+    uint32_t num_used;
+    // slot을 바꾸는 동안 홀수, 낙관적 lookup이 그 사이의 변경을 알아챔
+    std::atomic<uint64_t> version;
+    // 낙관적 lookup은 latch 없이 읽으므로 atomic, 바뀌어도 예전 배열은 retired_slots에 남김
+    std::atomic<ht_slots_t *> slots;
+} ht_partition_t;
+
 typedef struct hashtable_t {
-    uint32_t num_ht_entries;
-    ht_entry_t *ht_entries;
+    // 모든 partition의 slot 수
+    std::atomic<uint64_t> num_ht_entries;
+    buf_ht_latch_mode_t latch_mode;
+    uint32_t num_partitions;
+    ht_partition_t *partitions;
+    // resize_hashtable()이 바꿔 끼운 slot 배열의 list, resize_latch로 보호
+    // 낙관적 lookup이 아직 읽고 있을 수 있으므로 pool을 닫을 때 해제
+    ht_slots_t *retired_slots;
 } hashtable_t;
 
-// linked list형의 free_list 구현
-typedef struct free_list_node {
-    buf_descriptor_t* buf_desc;
-    free_list_node* next;
-} free_list_node;
+// table 하나의 순차/stride 접근을 추적하는 read-ahead 상태
+// table_id, last_page, stride는 run이 없는 miss가 latch 없이 읽고 쓸 수 있도록 atomic
+typedef struct alignas(64) readahead_t {
+    std::mutex latch;
+    std::atomic<int64_t> table_id;
+    std::atomic<pagenum_t> last_page;
+    // 최근 접근들의 page 간격, 0이면 pattern 없음
+    std::atomic<int64_t> stride;
+    // 같은 stride로 이어진 접근 수
+    uint32_t run_len;
+    // 아직 prefetch하지 않은 다음 page
+    pagenum_t next_page;
+} readahead_t;
 
-typedef struct buffer_pool_t {
+// init_buffer_pool()에 넘기는 size class 하나의 설정
+typedef struct buf_size_class_config_t {
+    // PAGE_SIZE의 배수, MAX_BUF_PAGE_SIZE 이하
+    uint32_t page_size;
     uint32_t num_buf;
+    // resize_buffer_pool()로 늘릴 수 있는 buffer 수의 상한, 0이면 num_buf * BUF_DEFAULT_GROWTH
+    uint32_t max_num_buf;
+} buf_size_class_config_t;
+
+// 같은 크기의 page를 담는 buffer들, frame 배열과 교체 대상, freelist를 따로 가짐
+typedef struct alignas(64) buf_size_class_t {
+    uint32_t page_size;
+    // buf_descriptors[first_buf, first_buf + num_buf)가 이 class의 buffer
+    uint32_t first_buf;
+    // resize_buffer_pool()이 바꾸며, 그 사이에도 읽을 수 있도록 atomic
+    std::atomic<uint32_t> num_buf;
+    // buf_descriptors[first_buf, first_buf + max_num_buf)를 이 class가 쓸 수 있음
+    uint32_t max_num_buf;
+    // 한 번이라도 초기화한 descriptor 수, 줄어든 뒤에도 남아 있음
+    uint32_t num_init_buf;
+    // page_size bytes씩의 frame 배열을 담은 mmap 영역들, 늘릴 때마다 하나씩 추가
+    std::vector<arena_t> page_arenas;
+
+    // clock 알고리즘의 marker, 여러 thread가 fetch_add로 함께 전진시킨다
+    std::atomic<uint32_t> clock_hand;
+
+    // freelist head: 상위 32bit는 ABA 방지용 tag, 하위 32bit는 descriptor index
+    std::atomic<uint64_t> free_list_head;
+    std::atomic<uint32_t> num_free;
+
+    // 읽기가 끝나지 않아 prefetch가 pin하고 있는 buffer 수
+    std::atomic<uint32_t> num_prefetching;
+    // is_kept인 buffer 수, num_buf / BUF_MAX_KEEP_FRACTION을 넘지 않음
+    std::atomic<uint32_t> num_kept;
+} buf_size_class_t;
+
+typedef struct buffer_pool_t {
+    std::atomic<uint32_t> num_buf;
+    // buf_descriptors 배열의 길이, 모든 class의 max_num_buf 합
+    uint32_t max_num_buf;
     hashtable_t hashtable;
 //  TODO -----------------------------------------------------------------------
-    // buf_descriptor와 buf_page들의 일대일 대응 배열
+    // 모든 size class의 buf_descriptor 배열, class 순서대로 이어져 있음
     buf_descriptor_t *buf_descriptors;
-    page_t *buf_pages;
+    // 배열을 담은 mmap 영역과 NUMA 배치 방식
+    arena_t desc_arena;
+    buf_numa_mode_t numa_mode;
+
+    // page 크기 순으로 정렬된 size class들, 모두 하나의 hashtable을 사용
+    buf_size_class_t size_classes[MAX_SIZE_CLASSES];
+    uint32_t num_size_classes;
+    uint32_t max_page_size;
+    // table_id / BUF_TABLE_CHUNK_SIZE번째 chunk, 연 table이 없으면 nullptr
+    std::atomic<buf_table_info_t *> table_chunks[MAX_BUF_TABLES / BUF_TABLE_CHUNK_SIZE];
+    // table id 확인, file 열기와 chunk 할당을 하나씩 실행
+    std::mutex table_latch;
+    // quota를 정한 table 수, 0이면 victim을 고를 때 quota를 보지 않음
+    std::atomic<uint32_t> num_quota_tables;
+    std::mutex quota_latch;
+
+    // init_buffer_pool()에서 선택한 교체 정책
+    const buf_policy_t *policy;
+
+    // clock hand 앞쪽의 dirty page를 미리 쓰는 background writer
+    std::thread bg_writer;
+    bool bg_writer_running;
+    uint32_t bg_writer_max_pages;
+    uint32_t bg_writer_sleep_ms;
+    std::mutex bg_writer_latch;
+    std::condition_variable bg_writer_cond;
 
-    // clock 알고리즘의 marker
-    int clock_hand;
+    // dirty buffer의 index에 해당하는 bit를 켠 bitmap
+    // summary의 bit 하나는 dirty_bitmap의 word 하나에 켜진 bit가 있음을 나타냄
+    std::atomic<uint64_t> *dirty_bitmap;
+    std::atomic<uint64_t> *dirty_summary;
 
-    // linked list의 head를 가리키는 포인터
-    free_list_node* free_list_head;
+    // checkpoint와 flush_table()을 하나씩 실행
+    std::mutex checkpoint_latch;
+    // resize_buffer_pool()과 resize_hashtable()을 하나씩 실행
+    std::mutex resize_latch;
+
+    // read-ahead window (page 수), 0이면 read-ahead 끔
+    std::atomic<uint32_t> readahead_window;
+    readahead_t readahead[NUM_READAHEAD_SLOTS];
+    // prefetch 읽기가 I/O thread에서 끝나기를 기다리는 thread들을 깨움
+    std::mutex io_wait_latch;
+    std::condition_variable io_wait_cond;
 //  ----------------------------------------------------------------------------
 } buffer_pool_t;
 
+extern buffer_pool_t buffer_pool;
+
+// buffer가 담는 page의 크기 (bytes)
+inline uint32_t buf_page_size(const buf_descriptor_t *buf_desc) {
+    return buffer_pool.size_classes[buf_desc->size_class].page_size;
+}
+
+// buffer_open_table()이 연 table의 정보
+inline buf_table_info_t *get_table_info(int64_t table_id) {
+    buf_table_info_t *chunk =
+        buffer_pool.table_chunks[table_id / BUF_TABLE_CHUNK_SIZE].load(std::memory_order_acquire);
+    return &chunk[table_id % BUF_TABLE_CHUNK_SIZE];
+}
+
+// table이 hard quota만큼 buffer를 쓰고 있어 자기 page만 교체할 수 있는지
+inline bool buf_table_at_hard_quota(int64_t table_id) {
+    buf_table_info_t *table = get_table_info(table_id);
+    uint32_t hard_quota = table->hard_quota.load(std::memory_order_relaxed);
+    return hard_quota != 0 && table->num_buf.load(std::memory_order_relaxed) >= hard_quota;
+}
+
+/**
+ * @brief Check the table quotas for a victim a replacement policy has just
+ * pinned.
+ * 
+ * @param incoming_key The ht_key() of the page that will use the victim
+ * @param is_strict Whether soft quotas are honored
+ * @return Whether the victim may be replaced by the incoming page.
+ * 
+ * @details A table at its hard quota may only replace its own pages. A
+ * table within its soft quota keeps its pages against other tables' misses
+ * unless is_strict is false, i.e. no other victim was found. The victim's
+ * tag is read only while it is pinned, since only a pin holder retags.
+ */
+inline bool buf_victim_allowed(const buf_descriptor_t *victim, uint64_t incoming_key,
+                               bool is_strict) {
+    if (buffer_pool.num_quota_tables.load(std::memory_order_relaxed) == 0)
+        return true;
+    int64_t table_id = victim->table_id;
+    int64_t incoming_table_id = incoming_key >> 48;
+    if (table_id < 0 || table_id == incoming_table_id)
+        return true;
+    if (buf_table_at_hard_quota(incoming_table_id))
+        return false;
+    buf_table_info_t *table = get_table_info(table_id);
+    uint32_t soft_quota = table->soft_quota.load(std::memory_order_relaxed);
+    return !is_strict || soft_quota == 0 ||
+           table->num_buf.load(std::memory_order_relaxed) > soft_quota;
+}
+
+// 대량 접근이 공유 pool 대신 재사용하는 작은 private ring
+// 한 thread(scan)만 사용하며, 여러 thread가 공유하지 않음
+typedef struct buf_strategy_t {
+    buf_strategy_kind_t kind;
+    uint32_t ring_size;
+    // 마지막으로 사용한 ring slot
+    uint32_t current;
+    // slot마다 이 strategy가 마지막으로 쓴 buffer, 없으면 nullptr
+    buf_descriptor_t **ring;
+} buf_strategy_t;
+
+/*
+ * A page must be modified while its exclusive content latch is held
+ * (get_buffer() with BUF_LATCH_EXCLUSIVE, or latch_buffer()). Taking the
+ * latch makes the buffer's version odd, which is how optimistic readers
+ * learn that the page is changing.
+ * 
+ * mark_buffer_dirty() and log_buffer_update() check that the calling thread
+ * holds that latch. If it does not, they log an error and abort in every
+ * build. A page got with get_buffer(table_id, page_num) and no latch, or
+ * with only the shared latch, is for reading. To write it, release the
+ * shared latch if held and take the exclusive one with latch_buffer().
+ */
 void mark_buffer_dirty(buf_descriptor_t *buf_desc);
+lsn_t log_buffer_update(buf_descriptor_t *buf_desc, uint32_t offset, uint32_t length);
 void unpin_buffer(buf_descriptor_t *buf_desc);
+void latch_buffer(buf_descriptor_t *buf_desc, buf_latch_mode_t mode);
+void unlatch_buffer(buf_descriptor_t *buf_desc, buf_latch_mode_t mode);
+void release_buffer(buf_descriptor_t *buf_desc, buf_latch_mode_t mode);
 
-int64_t buffer_open_table(const char *pathname);
-int init_buffer_pool(uint32_t num_ht_entries, uint32_t num_buf);
-buf_descriptor_t *get_buffer(int64_t table_id, pagenum_t page_num);
-buf_descriptor_t *get_buffer_of_new_page(int64_t table_id);
+int64_t buffer_open_table(const char *pathname, uint32_t page_size = PAGE_SIZE,
+                          buf_table_mode_t mode = BUF_TABLE_READ_WRITE);
+uint32_t get_table_page_size(int64_t table_id);
+int init_buffer_pool(uint32_t num_ht_entries, uint32_t num_buf,
+                     buf_policy_kind_t policy = BUF_POLICY_CLOCK,
+                     buf_numa_mode_t numa_mode = BUF_NUMA_NONE);
+int init_buffer_pool(uint32_t num_ht_entries, const buf_size_class_config_t *size_classes,
+                     uint32_t num_size_classes, buf_policy_kind_t policy = BUF_POLICY_CLOCK,
+                     buf_numa_mode_t numa_mode = BUF_NUMA_NONE);
+void set_ht_latch_mode(buf_ht_latch_mode_t mode);
+/*
+ * The hashtable never grows on its own. init_buffer_pool() sizes its
+ * partitions, resize_buffer_pool() grows them along with the pool, and
+ * resize_hashtable() sets their size explicitly. An insert into a full
+ * partition fails, and get_buffer() then fails for that page. A caller that
+ * shrinks the hashtable with resize_hashtable() must therefore call it again
+ * before the partitions fill up, i.e. before the pool maps more pages than
+ * a partition has slots for its share of them.
+ */
+int resize_buffer_pool(uint32_t num_buf, uint32_t page_size = PAGE_SIZE);
+int resize_hashtable(uint32_t num_ht_entries);
+buf_descriptor_t *get_buffer(int64_t table_id, pagenum_t page_num,
+                             buf_latch_mode_t mode = BUF_LATCH_NONE,
+                             buf_strategy_t *strategy = nullptr,
+                             buf_priority_t priority = BUF_PRIORITY_NORMAL);
+int set_table_quota(int64_t table_id, uint32_t soft_quota, uint32_t hard_quota);
+bool is_buffer_resident(int64_t table_id, pagenum_t page_num);
+buf_descriptor_t *get_buffer_of_new_page(int64_t table_id,
+                                         buf_strategy_t *strategy = nullptr);
 void free_page(int64_t table_id, buf_descriptor_t *free_buf);
 int close_buffer_pool();
 
+// buffer access strategy
+buf_strategy_t *get_buffer_strategy(buf_strategy_kind_t kind);
+void free_buffer_strategy(buf_strategy_t *strategy);
+
+// read-ahead
+uint32_t prefetch_buffer(int64_t table_id, const pagenum_t *page_nums, uint32_t num_pages,
+                         buf_strategy_t *strategy = nullptr);
+void set_readahead_window(uint32_t num_pages);
+
+// background writer
+int start_bg_writer(uint32_t max_pages_per_round, uint32_t sleep_ms);
+void stop_bg_writer();
+
+// latch와 pin 없이 읽는 낙관적 읽기
+buf_descriptor_t *optimistic_read_begin(int64_t table_id, pagenum_t page_num,
+                                        buf_optimistic_read_t *read);
+bool optimistic_read_validate(const buf_optimistic_read_t *read);
+int read_buffer(int64_t table_id, pagenum_t page_num, uint32_t offset, uint32_t length,
+                void *dest);
+
+// pointer swizzling
+void init_swip(buf_swip_t *swip, int64_t table_id, pagenum_t page_num);
+buf_descriptor_t *get_buffer_swip(buf_swip_t *swip, buf_latch_mode_t mode = BUF_LATCH_NONE);
+void unswizzle_swip(buf_swip_t *swip);
+
+// checkpoint
+int checkpoint_buffer_pool(uint32_t duration_ms = 0);
+int flush_table(int64_t table_id);
+lsn_t get_oldest_dirty_lsn();
+
 // freelist 초기화 함수 선언
 void init_freelist();
 void add_to_freelist(buf_descriptor_t *buf_desc);
-buf_descriptor_t *get_from_freelist();
+buf_descriptor_t *get_from_freelist(uint32_t size_class);
 
 // For stat
 void init_buffer_stat();
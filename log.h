@@ -0,0 +1,32 @@
+#ifndef DB_LOG_H_
+#define DB_LOG_H_
+
+#include <iostream>
+
+// 컴파일 시 고르는 log 수준, 그보다 자세한 log는 코드에서 완전히 사라진다
+#define BUF_LOG_LEVEL_NONE (0)
+#define BUF_LOG_LEVEL_ERROR (1)     // 실패와 잘못된 사용
+#define BUF_LOG_LEVEL_INFO (2)      // 초기화, table 열기 같은 드문 사건
+#define BUF_LOG_LEVEL_DEBUG (3)     // pin, lookup 같은 hot path의 모든 단계
+
+#ifndef BUF_LOG_LEVEL
+#define BUF_LOG_LEVEL BUF_LOG_LEVEL_ERROR
+#endif
+
+/*
+ * msg is a stream expression, e.g. buf_log_debug("pin " << buf_desc). The
+ * condition is a constant, so a disabled log statement is still type-checked
+ * but generates no code. Lines end with '\n' instead of std::endl, so
+ * std::cout is not flushed per line.
+ */
+#define buf_log(level, stream, msg) \
+    do { \
+        if (BUF_LOG_LEVEL >= (level)) \
+            stream << msg << '\n'; \
+    } while (0)
+
+#define buf_log_error(msg) buf_log(BUF_LOG_LEVEL_ERROR, std::cerr, msg)
+#define buf_log_info(msg) buf_log(BUF_LOG_LEVEL_INFO, std::cout, msg)
+#define buf_log_debug(msg) buf_log(BUF_LOG_LEVEL_DEBUG, std::cout, msg)
+
+#endif // DB_LOG_H_
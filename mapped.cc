@@ -0,0 +1,139 @@
+#include "mapped.h"
+#include "log.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// table_id를 index로 하는 mapping, mmap하지 않은 table은 nullptr
+// buffer pool의 miss마다 읽으므로 latch 없이 읽을 수 있는 고정 크기 배열에 둠
+static std::atomic<mapped_table_t *> mapped_tables[MAPPED_MAX_TABLES];
+
+/**
+ * @brief Map the file of a table read-only.
+ *
+ * @param advice The madvise() advice for the whole mapping, e.g.
+ * MADV_SEQUENTIAL for tables that are mostly scanned or MADV_RANDOM for
+ * tables that are mostly probed
+ * @retval 0: successful
+ * @retval others: failed
+ *
+ * @details The file is mapped as large as it is now. Pages appended to it
+ * later are not in the mapping, and mapped_get_page() returns nullptr for
+ * them. The file descriptor is closed right away, the mapping keeps the file
+ * open until mapped_close(). A table that is mapped already keeps its
+ * mapping.
+ */
+int mapped_open_table(int64_t table_id, const char *pathname, uint32_t page_size, int advice) {
+    if (table_id < 0 || table_id >= MAPPED_MAX_TABLES)
+        return 1;
+
+    int fd = open(pathname, O_RDONLY);
+    if (fd < 0) {
+        buf_log_error("Error: Failed to open " << pathname << " for mmap: " << strerror(errno));
+        return 1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)page_size) {
+        buf_log_error("Error: " << pathname << " is too small to mmap");
+        close(fd);
+        return 1;
+    }
+    size_t length = st.st_size - st.st_size % page_size;
+    void *addr = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        buf_log_error("Error: Failed to mmap " << pathname << ": " << strerror(errno));
+        return 1;
+    }
+    // 실패해도 kernel 기본 동작으로 읽으므로 무시
+    madvise(addr, length, advice);
+
+    mapped_table_t *table = new mapped_table_t;
+    table->addr = (char *)addr;
+    table->length = length;
+    table->page_size = page_size;
+    table->num_pages = length / page_size;
+    // 이미 mmap한 table이면 buffer들이 가리키고 있을 수 있으므로 예전 mapping을 유지
+    mapped_table_t *old_table = nullptr;
+    if (!mapped_tables[table_id].compare_exchange_strong(old_table, table)) {
+        munmap(table->addr, table->length);
+        delete table;
+    }
+    return 0;
+}
+
+bool mapped_is_table(int64_t table_id) {
+    return table_id >= 0 && table_id < MAPPED_MAX_TABLES &&
+           mapped_tables[table_id].load(std::memory_order_acquire) != nullptr;
+}
+
+/**
+ * @brief Get the address of a page in the mapping of a table.
+ *
+ * @return The read-only page, or nullptr if the table is not mapped or the
+ * page is beyond the mapping.
+ */
+page_t *mapped_get_page(int64_t table_id, pagenum_t page_num) {
+    if (table_id < 0 || table_id >= MAPPED_MAX_TABLES)
+        return nullptr;
+    mapped_table_t *table = mapped_tables[table_id].load(std::memory_order_acquire);
+    if (table == nullptr || page_num < 0 || (uint64_t)page_num >= table->num_pages)
+        return nullptr;
+    return (page_t *)(table->addr + (size_t)page_num * table->page_size);
+}
+
+/**
+ * @brief Ask the kernel to read pages of a mapped table ahead.
+ *
+ * @return The number of pages in the mapping that were asked for.
+ *
+ * @details Runs of adjacent pages are passed to one madvise(MADV_WILLNEED).
+ * The pages are read into the page cache asynchronously, and nothing in the
+ * buffer pool is taken for them.
+ */
+uint32_t mapped_will_need(int64_t table_id, const pagenum_t *page_nums, uint32_t num_pages) {
+    if (table_id < 0 || table_id >= MAPPED_MAX_TABLES)
+        return 0;
+    mapped_table_t *table = mapped_tables[table_id].load(std::memory_order_acquire);
+    if (table == nullptr)
+        return 0;
+
+    uint32_t num_advised = 0;
+    uint32_t i = 0;
+    while (i < num_pages) {
+        pagenum_t first = page_nums[i++];
+        if (first < 0 || (uint64_t)first >= table->num_pages)
+            continue;
+        pagenum_t last = first + 1;
+        while (i < num_pages && page_nums[i] == last && (uint64_t)last < table->num_pages) {
+            last++;
+            i++;
+        }
+        madvise(table->addr + (size_t)first * table->page_size,
+                (size_t)(last - first) * table->page_size, MADV_WILLNEED);
+        num_advised += last - first;
+    }
+    return num_advised;
+}
+
+/**
+ * @brief Unmap all mapped tables.
+ *
+ * @details Called by close_buffer_pool() once no buffer points into a
+ * mapping anymore.
+ */
+void mapped_close() {
+    for (int64_t table_id = 0; table_id < MAPPED_MAX_TABLES; table_id++) {
+        mapped_table_t *table = mapped_tables[table_id].exchange(nullptr);
+        if (table == nullptr)
+            continue;
+        munmap(table->addr, table->length);
+        delete table;
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef DB_MAPPED_H_
+#define DB_MAPPED_H_
+
+#include "page.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// mmap할 수 있는 table 수 (ht_key()의 table_id는 16bit)
+#define MAPPED_MAX_TABLES (1 << 16)
+
+// 읽기 전용으로 mmap한 table file 하나
+typedef struct mapped_table_t {
+    char *addr;
+    // mmap한 크기 (bytes), open할 때의 file 크기
+    size_t length;
+    uint32_t page_size;
+    // mapping이 담는 page 수, 이후의 page는 mapping에 없음
+    uint64_t num_pages;
+} mapped_table_t;
+
+int mapped_open_table(int64_t table_id, const char *pathname, uint32_t page_size, int advice);
+bool mapped_is_table(int64_t table_id);
+page_t *mapped_get_page(int64_t table_id, pagenum_t page_num);
+uint32_t mapped_will_need(int64_t table_id, const pagenum_t *page_nums, uint32_t num_pages);
+void mapped_close();
+
+#endif // DB_MAPPED_H_
@@ -0,0 +1,424 @@
+#include "metrics.h"
+#include "aio.h"
+#include "buffer.h"
+#include "file.h"
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+thread_local metrics_owner_t local_metrics;
+
+// 한 번 만든 block은 해제하지 않음
+static std::mutex block_list_latch;
+static std::vector<metrics_block_t *> blocks;
+
+static std::atomic<int64_t> num_pinned;
+static std::atomic<int64_t> pinned_high_water;
+
+// 모든 block의 합, init_buffer_stat() 시점의 값을 빼서 보고함
+typedef struct metrics_raw_t {
+    uint64_t counters[NUM_METRICS];
+    uint64_t table_hits[MAX_METRIC_TABLES + 1];
+    uint64_t table_misses[MAX_METRIC_TABLES + 1];
+    uint64_t class_hits[MAX_SIZE_CLASSES];
+    uint64_t class_misses[MAX_SIZE_CLASSES];
+    uint64_t buckets[NUM_LATENCIES][HIST_NUM_BUCKETS];
+    uint64_t latency_sum[NUM_LATENCIES];
+    uint64_t latency_max[NUM_LATENCIES];
+} metrics_raw_t;
+
+static std::mutex baseline_latch;
+static metrics_raw_t baseline;
+
+static const char *latency_names[NUM_LATENCIES] = {"hit", "miss", "zcache_miss", "flush", "grow"};
+
+metrics_owner_t::~metrics_owner_t() {
+    if (block)
+        block->in_use = false;
+}
+
+metrics_block_t *metrics_acquire_block() {
+    std::lock_guard<std::mutex> guard(block_list_latch);
+    for (metrics_block_t *block : blocks) {
+        if (!block->in_use) {
+            block->in_use = true;
+            return block;
+        }
+    }
+    // atomic 멤버는 value-initialize로 0이 됨
+    metrics_block_t *block = new metrics_block_t();
+    block->in_use = true;
+    blocks.push_back(block);
+    return block;
+}
+
+uint32_t hist_bucket_of(uint64_t value) {
+    if (value < HIST_LINEAR_BUCKETS)
+        return value;
+    uint32_t exponent = 63 - __builtin_clzll(value);
+    if (exponent >= HIST_MAX_EXPONENT)
+        return HIST_NUM_BUCKETS - 1;
+    uint32_t sub = (value >> (exponent - 3)) & (HIST_SUB_BUCKETS - 1);
+    return HIST_LINEAR_BUCKETS + (exponent - 4) * HIST_SUB_BUCKETS + sub;
+}
+
+// bucket에 들어가는 가장 큰 값
+uint64_t hist_bucket_upper(uint32_t bucket) {
+    if (bucket < HIST_LINEAR_BUCKETS)
+        return bucket;
+    uint32_t exponent = 4 + (bucket - HIST_LINEAR_BUCKETS) / HIST_SUB_BUCKETS;
+    uint32_t sub = (bucket - HIST_LINEAR_BUCKETS) % HIST_SUB_BUCKETS;
+    return ((uint64_t)(HIST_SUB_BUCKETS + sub + 1) << (exponent - 3)) - 1;
+}
+
+/**
+ * @brief Count a buffer getting its first pin (+1) or losing its last (-1).
+ *
+ * @details The only shared counter of the metrics, since a high-water mark
+ * cannot be derived from per-thread counts. It is touched only when a
+ * buffer's reference count moves between 0 and 1, or a buffer leaves or
+ * enters the freelist, whose buffers are not counted.
+ */
+void metric_pinned(int delta) {
+    int64_t pinned = num_pinned.fetch_add(delta) + delta;
+    int64_t high_water = pinned_high_water.load(std::memory_order_relaxed);
+    while (pinned > high_water &&
+           !pinned_high_water.compare_exchange_weak(high_water, pinned))
+        ;
+}
+
+static void collect_raw(metrics_raw_t *raw) {
+    *raw = metrics_raw_t();
+    std::lock_guard<std::mutex> guard(block_list_latch);
+    for (metrics_block_t *block : blocks) {
+        for (int i = 0; i < NUM_METRICS; i++)
+            raw->counters[i] += block->counters[i].load(std::memory_order_relaxed);
+        for (int i = 0; i <= MAX_METRIC_TABLES; i++) {
+            raw->table_hits[i] += block->table_hits[i].load(std::memory_order_relaxed);
+            raw->table_misses[i] += block->table_misses[i].load(std::memory_order_relaxed);
+        }
+        for (int i = 0; i < MAX_SIZE_CLASSES; i++) {
+            raw->class_hits[i] += block->class_hits[i].load(std::memory_order_relaxed);
+            raw->class_misses[i] += block->class_misses[i].load(std::memory_order_relaxed);
+        }
+        for (int l = 0; l < NUM_LATENCIES; l++) {
+            for (int i = 0; i < HIST_NUM_BUCKETS; i++)
+                raw->buckets[l][i] += block->buckets[l][i].load(std::memory_order_relaxed);
+            raw->latency_sum[l] += block->latency_sum[l].load(std::memory_order_relaxed);
+            raw->latency_max[l] = std::max(raw->latency_max[l],
+                                           block->latency_max[l].load(std::memory_order_relaxed));
+        }
+    }
+}
+
+/**
+ * @brief Start counting from zero.
+ *
+ * @details Per-thread counters are never written by other threads, so the
+ * current sums are kept as a baseline and subtracted when read. Only the
+ * maximum latencies are cleared in place, which may miss a maximum recorded
+ * at the same moment.
+ */
+void metrics_reset() {
+    std::lock_guard<std::mutex> guard(baseline_latch);
+    collect_raw(&baseline);
+    {
+        std::lock_guard<std::mutex> list_guard(block_list_latch);
+        for (metrics_block_t *block : blocks)
+            for (int l = 0; l < NUM_LATENCIES; l++)
+                block->latency_max[l].store(0, std::memory_order_relaxed);
+    }
+    pinned_high_water = num_pinned.load();
+}
+
+static void fill_histogram(buf_histogram_t *hist, const uint64_t *buckets, uint64_t sum, uint64_t max) {
+    hist->count = 0;
+    for (int i = 0; i < HIST_NUM_BUCKETS; i++) {
+        hist->buckets[i] = buckets[i];
+        hist->count += buckets[i];
+    }
+    hist->sum_ns = sum;
+    hist->max_ns = max;
+
+    uint64_t *quantiles[] = {&hist->p50_ns, &hist->p90_ns, &hist->p99_ns, &hist->p999_ns};
+    const double ranks[] = {0.5, 0.9, 0.99, 0.999};
+    for (int q = 0; q < 4; q++) {
+        *quantiles[q] = 0;
+        if (hist->count == 0)
+            continue;
+        uint64_t rank = (uint64_t)(ranks[q] * (hist->count - 1)) + 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < HIST_NUM_BUCKETS; i++) {
+            seen += buckets[i];
+            if (seen >= rank) {
+                *quantiles[q] = std::min(hist_bucket_upper(i), max);
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Get the statistics since init_buffer_stat().
+ *
+ * @details Sums the per-thread counters without latching the buffer pool, so
+ * the snapshot can be taken at any time. Counters that threads update while
+ * it is taken may be off by the updates in flight.
+ */
+void get_buffer_stat_snapshot(buf_stat_snapshot_t *snapshot) {
+    metrics_raw_t raw;
+    collect_raw(&raw);
+    std::lock_guard<std::mutex> guard(baseline_latch);
+
+    snapshot->num_buf = buffer_pool.num_buf;
+    for (int i = 0; i < NUM_METRICS; i++)
+        snapshot->counters[i] = raw.counters[i] - baseline.counters[i];
+    for (int i = 0; i <= MAX_METRIC_TABLES; i++) {
+        snapshot->tables[i].hits = raw.table_hits[i] - baseline.table_hits[i];
+        snapshot->tables[i].misses = raw.table_misses[i] - baseline.table_misses[i];
+    }
+    uint64_t frame_bytes = 0, used_bytes = 0;
+    snapshot->num_size_classes = buffer_pool.num_size_classes;
+    for (uint32_t i = 0; i < buffer_pool.num_size_classes; i++) {
+        const buf_size_class_t *size_class = &buffer_pool.size_classes[i];
+        buf_class_stat_t *stat = &snapshot->size_classes[i];
+        stat->page_size = size_class->page_size;
+        stat->num_buf = size_class->num_buf;
+        stat->num_used = size_class->num_buf - size_class->num_free;
+        stat->hits = raw.class_hits[i] - baseline.class_hits[i];
+        stat->misses = raw.class_misses[i] - baseline.class_misses[i];
+        stat->hit_ratio = stat->hits + stat->misses == 0 ? 0 :
+            100.0 * stat->hits / (stat->hits + stat->misses);
+        frame_bytes += (uint64_t)stat->num_buf * stat->page_size;
+        used_bytes += (uint64_t)stat->num_used * stat->page_size;
+    }
+    snapshot->memory_efficiency = frame_bytes == 0 ? 0 : 100.0 * used_bytes / frame_bytes;
+    for (int l = 0; l < NUM_LATENCIES; l++) {
+        uint64_t buckets[HIST_NUM_BUCKETS];
+        for (int i = 0; i < HIST_NUM_BUCKETS; i++)
+            buckets[i] = raw.buckets[l][i] - baseline.buckets[l][i];
+        fill_histogram(&snapshot->latencies[l], buckets,
+                       raw.latency_sum[l] - baseline.latency_sum[l], raw.latency_max[l]);
+    }
+
+    // 낙관적 읽기와 swizzle된 참조는 get_buffer()를 거치지 않는 hit
+    uint64_t num_fast_hits = snapshot->counters[METRIC_OPTIMISTIC_READ] + snapshot->counters[METRIC_SWIP_HIT];
+    snapshot->accesses = snapshot->counters[METRIC_GET_BUFFER] + num_fast_hits;
+    snapshot->hits = snapshot->counters[METRIC_HIT] + num_fast_hits;
+    snapshot->hit_ratio = snapshot->accesses == 0 ? 0 : 100.0 * snapshot->hits / snapshot->accesses;
+    snapshot->sweep_steps_per_victim = snapshot->counters[METRIC_VICTIM] == 0 ? 0 :
+        (double)snapshot->counters[METRIC_SWEEP_STEP] / snapshot->counters[METRIC_VICTIM];
+    uint64_t num_zcache_lookups = snapshot->counters[METRIC_ZCACHE_HIT] + snapshot->counters[METRIC_ZCACHE_MISS];
+    snapshot->zcache_hit_ratio = num_zcache_lookups == 0 ? 0 :
+        100.0 * snapshot->counters[METRIC_ZCACHE_HIT] / num_zcache_lookups;
+    zcache_get_stat(&snapshot->zcache);
+    snapshot->compression_ratio = snapshot->zcache.compressed_bytes == 0 ? 0 :
+        (double)snapshot->zcache.page_bytes / snapshot->zcache.compressed_bytes;
+
+    snapshot->read_pages = stat_read_page;
+    snapshot->write_pages = stat_write_page;
+    snapshot->aio_read_pages = stat_aio_read_page;
+    snapshot->aio_write_pages = stat_aio_write_page;
+    snapshot->pinned = num_pinned;
+    snapshot->pinned_high_water = pinned_high_water;
+}
+
+static std::string table_label(int index) {
+    return index == MAX_METRIC_TABLES ? "other" : std::to_string(index);
+}
+
+/**
+ * @brief Format the statistics in the Prometheus text exposition format.
+ *
+ * @details Latencies are exported as summaries with the 0.5, 0.9, 0.99 and
+ * 0.999 quantiles, in seconds.
+ */
+std::string get_buffer_stat_prometheus() {
+    buf_stat_snapshot_t snapshot;
+    get_buffer_stat_snapshot(&snapshot);
+    const buf_stat_snapshot_t *s = &snapshot;
+    std::string out;
+
+    auto metric = [&out](const char *name, const char *type, const char *help) {
+        out += string_format("# HELP bufpool_%s %s\n# TYPE bufpool_%s %s\n", name, help, name, type);
+    };
+    auto sample = [&out](const char *name, const std::string &labels, double value) {
+        out += string_format("bufpool_%s%s %.17g\n", name, labels.c_str(), value);
+    };
+
+    metric("buffers", "gauge", "Number of buffers in the pool.");
+    sample("buffers", "", s->num_buf);
+    metric("pinned_buffers", "gauge", "Buffers pinned now.");
+    sample("pinned_buffers", "", s->pinned);
+    metric("pinned_buffers_high_water", "gauge", "Most buffers pinned at once.");
+    sample("pinned_buffers_high_water", "", s->pinned_high_water);
+    metric("hit_ratio", "gauge", "Percentage of page accesses that found the page, including optimistic reads and swip hits.");
+    sample("hit_ratio", "", s->hit_ratio);
+
+    metric("get_buffer_total", "counter", "Calls of get_buffer().");
+    sample("get_buffer_total", "", s->counters[METRIC_GET_BUFFER]);
+    metric("hits_total", "counter", "Page accesses that found the page, by table.");
+    metric("misses_total", "counter", "get_buffer() calls that read the page, by table.");
+    for (int i = 0; i <= MAX_METRIC_TABLES; i++) {
+        if (s->tables[i].hits == 0 && s->tables[i].misses == 0)
+            continue;
+        std::string labels = "{table=\"" + table_label(i) + "\"}";
+        sample("hits_total", labels, s->tables[i].hits);
+        sample("misses_total", labels, s->tables[i].misses);
+    }
+    metric("size_class_buffers", "gauge", "Buffers of each page size class.");
+    metric("size_class_used_buffers", "gauge", "Buffers holding a page, by page size class.");
+    metric("size_class_hits_total", "counter", "Page access hits, by page size class.");
+    metric("size_class_misses_total", "counter", "get_buffer() misses, by page size class.");
+    for (uint32_t i = 0; i < s->num_size_classes; i++) {
+        const buf_class_stat_t *stat = &s->size_classes[i];
+        std::string labels = "{page_size=\"" + std::to_string(stat->page_size) + "\"}";
+        sample("size_class_buffers", labels, stat->num_buf);
+        sample("size_class_used_buffers", labels, stat->num_used);
+        sample("size_class_hits_total", labels, stat->hits);
+        sample("size_class_misses_total", labels, stat->misses);
+    }
+    metric("memory_efficiency", "gauge", "Percentage of frame memory holding pages.");
+    sample("memory_efficiency", "", s->memory_efficiency);
+    metric("evictions_total", "counter", "Pages evicted, by whether they had to be written.");
+    sample("evictions_total", "{kind=\"clean\"}", s->counters[METRIC_EVICT_CLEAN]);
+    sample("evictions_total", "{kind=\"dirty\"}", s->counters[METRIC_EVICT_DIRTY]);
+    metric("victims_total", "counter", "Victims chosen by the replacement policy.");
+    sample("victims_total", "", s->counters[METRIC_VICTIM]);
+    metric("clock_sweep_steps_total", "counter", "Buffers the clock hand passed to find victims.");
+    sample("clock_sweep_steps_total", "", s->counters[METRIC_SWEEP_STEP]);
+    metric("buffer_writes_total", "counter", "Dirty buffers written, by writer.");
+    sample("buffer_writes_total", "{writer=\"foreground\"}", s->counters[METRIC_FG_WRITE]);
+    sample("buffer_writes_total", "{writer=\"background\"}", s->counters[METRIC_BG_WRITE]);
+    sample("buffer_writes_total", "{writer=\"checkpoint\"}", s->counters[METRIC_CHECKPOINT_WRITE]);
+    metric("prefetch_pages_total", "counter", "Pages read ahead.");
+    sample("prefetch_pages_total", "", s->counters[METRIC_PREFETCH_PAGE]);
+    metric("prefetch_hits_total", "counter", "Prefetched pages used by get_buffer().");
+    sample("prefetch_hits_total", "", s->counters[METRIC_PREFETCH_HIT]);
+    metric("prefetch_unused_total", "counter", "Prefetched pages evicted before use.");
+    sample("prefetch_unused_total", "", s->counters[METRIC_PREFETCH_UNUSED]);
+    metric("optimistic_reads_total", "counter", "Optimistic reads, by whether they validated.");
+    sample("optimistic_reads_total", "{result=\"validated\"}", s->counters[METRIC_OPTIMISTIC_READ]);
+    sample("optimistic_reads_total", "{result=\"conflict\"}", s->counters[METRIC_OPTIMISTIC_CONFLICT]);
+    metric("swip_hits_total", "counter", "Pages reached through swizzled references.");
+    sample("swip_hits_total", "", s->counters[METRIC_SWIP_HIT]);
+    metric("unswizzles_total", "counter", "Swizzled references undone by evictions.");
+    sample("unswizzles_total", "", s->counters[METRIC_UNSWIZZLE]);
+    metric("zcache_lookups_total", "counter", "Misses that looked in the compressed cache, by result.");
+    sample("zcache_lookups_total", "{result=\"hit\"}", s->counters[METRIC_ZCACHE_HIT]);
+    sample("zcache_lookups_total", "{result=\"miss\"}", s->counters[METRIC_ZCACHE_MISS]);
+    metric("zcache_pages", "gauge", "Pages held by the compressed cache.");
+    sample("zcache_pages", "", s->zcache.num_pages);
+    metric("zcache_used_bytes", "gauge", "Bytes of the compressed cache's budget in use.");
+    sample("zcache_used_bytes", "", s->zcache.used_bytes);
+    metric("zcache_budget_bytes", "gauge", "Memory budget of the compressed cache.");
+    sample("zcache_budget_bytes", "", s->zcache.budget_bytes);
+    metric("zcache_compression_ratio", "gauge", "Original over compressed size of the cached pages.");
+    sample("zcache_compression_ratio", "", s->compression_ratio);
+    metric("wal_records_total", "counter", "Records appended to the write-ahead log.");
+    sample("wal_records_total", "", s->counters[METRIC_WAL_RECORD]);
+    metric("wal_syncs_total", "counter", "Writes and syncs of the write-ahead log.");
+    sample("wal_syncs_total", "", s->counters[METRIC_WAL_SYNC]);
+    metric("page_io_total", "counter", "Pages read and written, by I/O path.");
+    sample("page_io_total", "{op=\"read\",path=\"sync\"}", s->read_pages);
+    sample("page_io_total", "{op=\"write\",path=\"sync\"}", s->write_pages);
+    sample("page_io_total", "{op=\"read\",path=\"async\"}", s->aio_read_pages);
+    sample("page_io_total", "{op=\"write\",path=\"async\"}", s->aio_write_pages);
+
+    metric("latency_seconds", "summary", "Latency of get_buffer() hits, of misses read from the file or the compressed cache, of flushes and of file growth.");
+    for (int l = 0; l < NUM_LATENCIES; l++) {
+        const buf_histogram_t *hist = &s->latencies[l];
+        std::string path = std::string("path=\"") + latency_names[l] + "\"";
+        const char *quantiles[] = {"0.5", "0.9", "0.99", "0.999"};
+        const uint64_t values[] = {hist->p50_ns, hist->p90_ns, hist->p99_ns, hist->p999_ns};
+        for (int q = 0; q < 4; q++)
+            sample("latency_seconds", "{" + path + ",quantile=\"" + quantiles[q] + "\"}", values[q] / 1e9);
+        sample("latency_seconds_sum", "{" + path + "}", hist->sum_ns / 1e9);
+        sample("latency_seconds_count", "{" + path + "}", hist->count);
+    }
+    metric("latency_max_seconds", "gauge", "Largest latency since the statistics were reset.");
+    for (int l = 0; l < NUM_LATENCIES; l++)
+        sample("latency_max_seconds", std::string("{path=\"") + latency_names[l] + "\"}",
+               s->latencies[l].max_ns / 1e9);
+
+    return out;
+}
+
+/**
+ * @brief Format the statistics as a JSON object.
+ *
+ * @details Latency histograms list their non-empty buckets as
+ * [upper bound in ns, count] pairs.
+ */
+std::string get_buffer_stat_json() {
+    buf_stat_snapshot_t snapshot;
+    get_buffer_stat_snapshot(&snapshot);
+    const buf_stat_snapshot_t *s = &snapshot;
+
+    std::string out = string_format(
+        "{\"num_buf\":%u,\"pinned\":%ld,\"pinned_high_water\":%ld,\"hit_ratio\":%.2f,"
+        "\"get_buffer\":%lu,\"hits\":%lu,\"misses\":%lu,"
+        "\"evictions\":{\"clean\":%lu,\"dirty\":%lu},"
+        "\"victims\":%lu,\"clock_sweep_steps\":%lu,\"sweep_steps_per_victim\":%.2f,"
+        "\"writes\":{\"foreground\":%lu,\"background\":%lu,\"checkpoint\":%lu},"
+        "\"prefetch\":{\"pages\":%lu,\"hits\":%lu,\"unused\":%lu},"
+        "\"optimistic\":{\"reads\":%lu,\"conflicts\":%lu},"
+        "\"swip\":{\"hits\":%lu,\"unswizzles\":%lu},"
+        "\"zcache\":{\"hits\":%lu,\"misses\":%lu,\"hit_ratio\":%.2f,\"pages\":%lu,"
+        "\"used_bytes\":%lu,\"budget_bytes\":%lu,\"compression_ratio\":%.2f},"
+        "\"wal\":{\"records\":%lu,\"syncs\":%lu},"
+        "\"page_io\":{\"read\":%ld,\"write\":%ld,\"async_read\":%ld,\"async_write\":%ld},",
+        s->num_buf, (long)s->pinned, (long)s->pinned_high_water, s->hit_ratio,
+        s->counters[METRIC_GET_BUFFER], s->hits, s->counters[METRIC_MISS],
+        s->counters[METRIC_EVICT_CLEAN], s->counters[METRIC_EVICT_DIRTY],
+        s->counters[METRIC_VICTIM], s->counters[METRIC_SWEEP_STEP], s->sweep_steps_per_victim,
+        s->counters[METRIC_FG_WRITE], s->counters[METRIC_BG_WRITE],
+        s->counters[METRIC_CHECKPOINT_WRITE], s->counters[METRIC_PREFETCH_PAGE], s->counters[METRIC_PREFETCH_HIT],
+        s->counters[METRIC_PREFETCH_UNUSED],
+        s->counters[METRIC_OPTIMISTIC_READ], s->counters[METRIC_OPTIMISTIC_CONFLICT],
+        s->counters[METRIC_SWIP_HIT], s->counters[METRIC_UNSWIZZLE],
+        s->counters[METRIC_ZCACHE_HIT], s->counters[METRIC_ZCACHE_MISS], s->zcache_hit_ratio,
+        s->zcache.num_pages, s->zcache.used_bytes, s->zcache.budget_bytes, s->compression_ratio,
+        s->counters[METRIC_WAL_RECORD], s->counters[METRIC_WAL_SYNC],
+        (long)s->read_pages, (long)s->write_pages, (long)s->aio_read_pages, (long)s->aio_write_pages);
+
+    out += "\"tables\":{";
+    bool first = true;
+    for (int i = 0; i <= MAX_METRIC_TABLES; i++) {
+        if (s->tables[i].hits == 0 && s->tables[i].misses == 0)
+            continue;
+        out += string_format("%s\"%s\":{\"hits\":%lu,\"misses\":%lu}", first ? "" : ",",
+                             table_label(i).c_str(), s->tables[i].hits, s->tables[i].misses);
+        first = false;
+    }
+    out += string_format("},\"memory_efficiency\":%.2f,\"size_classes\":[", s->memory_efficiency);
+    for (uint32_t i = 0; i < s->num_size_classes; i++) {
+        const buf_class_stat_t *stat = &s->size_classes[i];
+        out += string_format("%s{\"page_size\":%u,\"num_buf\":%u,\"used\":%u,\"hits\":%lu,"
+                             "\"misses\":%lu,\"hit_ratio\":%.2f}", i == 0 ? "" : ",",
+                             stat->page_size, stat->num_buf, stat->num_used, stat->hits,
+                             stat->misses, stat->hit_ratio);
+    }
+    out += "],\"latency_ns\":{";
+
+    for (int l = 0; l < NUM_LATENCIES; l++) {
+        const buf_histogram_t *hist = &s->latencies[l];
+        out += string_format(
+            "%s\"%s\":{\"count\":%lu,\"sum\":%lu,\"max\":%lu,\"p50\":%lu,\"p90\":%lu,"
+            "\"p99\":%lu,\"p999\":%lu,\"buckets\":[",
+            l == 0 ? "" : ",", latency_names[l], hist->count, hist->sum_ns, hist->max_ns,
+            hist->p50_ns, hist->p90_ns, hist->p99_ns, hist->p999_ns);
+        first = true;
+        for (int i = 0; i < HIST_NUM_BUCKETS; i++) {
+            if (hist->buckets[i] == 0)
+                continue;
+            out += string_format("%s[%lu,%lu]", first ? "" : ",", hist_bucket_upper(i), hist->buckets[i]);
+            first = false;
+        }
+        out += "]}";
+    }
+    out += "}}";
+
+    return out;
+}
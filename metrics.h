@@ -0,0 +1,192 @@
+#ifndef DB_METRICS_H_
+#define DB_METRICS_H_
+
+#include "zcache.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// table별 hit/miss를 따로 세는 table_id 수, 그 이상은 하나로 묶어 셈
+#define MAX_METRIC_TABLES (64)
+// buffer pool의 page size class 수의 상한, class마다 hit/miss를 따로 셈
+#define MAX_SIZE_CLASSES (4)
+
+// latency histogram: 16ns 미만은 1ns 단위, 그 위는 2의 거듭제곱 구간마다 8칸 (오차 12.5% 이내)
+#define HIST_LINEAR_BUCKETS (16)
+#define HIST_SUB_BUCKETS (8)
+// 2^40ns(약 18분)까지 구분, 그 이상은 마지막 칸
+#define HIST_MAX_EXPONENT (40)
+#define HIST_NUM_BUCKETS (HIST_LINEAR_BUCKETS + (HIST_MAX_EXPONENT - 4) * HIST_SUB_BUCKETS)
+
+typedef enum buf_metric_t {
+    METRIC_GET_BUFFER,
+    METRIC_HIT,
+    METRIC_MISS,
+    METRIC_EVICT_CLEAN,     // 쓰지 않고 내보낸 victim
+    METRIC_EVICT_DIRTY,     // get_buffer()가 써야 했던 victim
+    METRIC_VICTIM,          // 교체 정책이 고른 victim 수
+    METRIC_SWEEP_STEP,      // 그 victim을 찾기까지 clock hand가 움직인 수
+    METRIC_FG_WRITE,
+    METRIC_BG_WRITE,
+    METRIC_CHECKPOINT_WRITE,
+    METRIC_PREFETCH_PAGE,
+    METRIC_PREFETCH_HIT,
+    METRIC_PREFETCH_UNUSED,
+    METRIC_OPTIMISTIC_READ,         // 검증에 성공한 낙관적 읽기
+    METRIC_OPTIMISTIC_CONFLICT,     // 그 사이 page가 바뀌어 실패한 낙관적 읽기
+    METRIC_SWIP_HIT,        // hashtable을 거치지 않고 swizzle된 참조로 찾은 page
+    METRIC_UNSWIZZLE,       // page를 교체하며 되돌린 swizzle된 참조
+    METRIC_ZCACHE_HIT,      // file 대신 compressed cache에서 풀어 온 miss
+    METRIC_ZCACHE_MISS,     // compressed cache에도 없어 file을 읽은 miss
+    METRIC_WAL_RECORD,
+    METRIC_WAL_SYNC,        // group commit 한 번마다 하나
+    NUM_METRICS
+} buf_metric_t;
+
+typedef enum buf_latency_t {
+    LATENCY_HIT,            // buffer에 있던 page를 반환한 get_buffer()
+    LATENCY_MISS,           // page를 읽어 온 get_buffer()
+    LATENCY_ZCACHE_MISS,    // 압축 cache에서 page를 풀어 온 get_buffer()
+    LATENCY_FLUSH,          // flush_buffer()의 동기 쓰기
+    LATENCY_GROW,           // page를 할당하며 table의 file을 한 extent 늘린 것
+    NUM_LATENCIES
+} buf_latency_t;
+
+/*
+ * Counters of one thread. Only the owning thread writes them, with a relaxed
+ * load and store instead of a read-modify-write, and readers sum all blocks,
+ * so counting never shares a cache line between threads.
+ */
+typedef struct alignas(64) metrics_block_t {
+    std::atomic<uint64_t> counters[NUM_METRICS];
+    // [MAX_METRIC_TABLES]는 나머지 table의 합
+    std::atomic<uint64_t> table_hits[MAX_METRIC_TABLES + 1];
+    std::atomic<uint64_t> table_misses[MAX_METRIC_TABLES + 1];
+    std::atomic<uint64_t> class_hits[MAX_SIZE_CLASSES];
+    std::atomic<uint64_t> class_misses[MAX_SIZE_CLASSES];
+    std::atomic<uint64_t> buckets[NUM_LATENCIES][HIST_NUM_BUCKETS];
+    std::atomic<uint64_t> latency_sum[NUM_LATENCIES];
+    std::atomic<uint64_t> latency_max[NUM_LATENCIES];
+    // block을 쓰는 thread가 살아 있는지
+    std::atomic<bool> in_use;
+} metrics_block_t;
+
+// thread가 끝나면 block을 돌려놓고, 다음 thread가 이어서 셈
+typedef struct metrics_owner_t {
+    metrics_block_t *block;
+    ~metrics_owner_t();
+} metrics_owner_t;
+
+extern thread_local metrics_owner_t local_metrics;
+metrics_block_t *metrics_acquire_block();
+
+inline metrics_block_t *get_metrics_block() {
+    if (local_metrics.block == nullptr)
+        local_metrics.block = metrics_acquire_block();
+    return local_metrics.block;
+}
+
+inline void metrics_bump(std::atomic<uint64_t> &counter, uint64_t n) {
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+inline void metric_add(buf_metric_t metric, uint64_t n = 1) {
+    metrics_bump(get_metrics_block()->counters[metric], n);
+}
+
+inline void metric_table_access(int64_t table_id, uint32_t size_class, bool is_hit) {
+    uint32_t index = table_id >= 0 && table_id < MAX_METRIC_TABLES ? table_id : MAX_METRIC_TABLES;
+    metrics_block_t *block = get_metrics_block();
+    metrics_bump(is_hit ? block->table_hits[index] : block->table_misses[index], 1);
+    metrics_bump(is_hit ? block->class_hits[size_class] : block->class_misses[size_class], 1);
+}
+
+uint32_t hist_bucket_of(uint64_t value);
+uint64_t hist_bucket_upper(uint32_t bucket);
+
+inline uint64_t metrics_now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// start_ns는 metrics_now_ns()로 잰 시작 시각
+inline void metric_latency(buf_latency_t latency, uint64_t start_ns) {
+    uint64_t elapsed = metrics_now_ns() - start_ns;
+    metrics_block_t *block = get_metrics_block();
+    metrics_bump(block->buckets[latency][hist_bucket_of(elapsed)], 1);
+    metrics_bump(block->latency_sum[latency], elapsed);
+    if (elapsed > block->latency_max[latency].load(std::memory_order_relaxed))
+        block->latency_max[latency].store(elapsed, std::memory_order_relaxed);
+}
+
+// buffer를 pin하고 있는 사용자가 생기거나(+1) 없어질 때(-1)
+void metric_pinned(int delta);
+
+typedef struct buf_histogram_t {
+    uint64_t count;
+    uint64_t sum_ns;
+    uint64_t max_ns;
+    // 분위수, 해당 bucket의 상한값
+    uint64_t p50_ns;
+    uint64_t p90_ns;
+    uint64_t p99_ns;
+    uint64_t p999_ns;
+    uint64_t buckets[HIST_NUM_BUCKETS];
+} buf_histogram_t;
+
+typedef struct buf_table_stat_t {
+    uint64_t hits;
+    uint64_t misses;
+} buf_table_stat_t;
+
+typedef struct buf_class_stat_t {
+    uint32_t page_size;
+    uint32_t num_buf;
+    // page를 담고 있는 (freelist에 없는) buffer 수
+    uint32_t num_used;
+    uint64_t hits;
+    uint64_t misses;
+    // 0 ~ 100
+    double hit_ratio;
+} buf_class_stat_t;
+
+// init_buffer_stat() 이후의 통계를 한 번에 모은 것
+typedef struct buf_stat_snapshot_t {
+    uint32_t num_buf;
+    uint64_t counters[NUM_METRICS];
+    // get_buffer() 호출과 검증된 낙관적 읽기, swizzle된 참조로 찾은 page를 모두 센 접근 수와 그중 hit
+    uint64_t accesses;
+    uint64_t hits;
+    // 0 ~ 100, page에 한 번도 접근하지 않았으면 0
+    double hit_ratio;
+    double sweep_steps_per_victim;
+    int64_t read_pages;
+    int64_t write_pages;
+    int64_t aio_read_pages;
+    int64_t aio_write_pages;
+    // 지금 pin된 buffer 수와 그 최댓값
+    int64_t pinned;
+    int64_t pinned_high_water;
+    // [MAX_METRIC_TABLES]는 그 이상의 table_id 전부
+    buf_table_stat_t tables[MAX_METRIC_TABLES + 1];
+    uint32_t num_size_classes;
+    buf_class_stat_t size_classes[MAX_SIZE_CLASSES];
+    // 전체 frame 메모리 중 page를 담고 있는 비율 (0 ~ 100)
+    double memory_efficiency;
+    // compressed cache, 열려 있지 않으면 모두 0
+    zcache_stat_t zcache;
+    // compressed cache를 찾아본 miss 중 찾은 비율 (0 ~ 100)
+    double zcache_hit_ratio;
+    // 담겨 있는 page들의 원래 크기 / 압축된 크기
+    double compression_ratio;
+    buf_histogram_t latencies[NUM_LATENCIES];
+} buf_stat_snapshot_t;
+
+void metrics_reset();
+void get_buffer_stat_snapshot(buf_stat_snapshot_t *snapshot);
+std::string get_buffer_stat_prometheus();
+std::string get_buffer_stat_json();
+
+#endif // DB_METRICS_H_
@@ -0,0 +1,766 @@
+#include "replacement.h"
+#include "buffer.h"
+#include "log.h"
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <vector>
+
+#define BUF_INDEX(buf_desc) ((uint32_t)((buf_desc) - buffer_pool.buf_descriptors))
+#define CLASS_OF(index) (buffer_pool.buf_descriptors[index].size_class)
+#define NO_BUF (UINT32_MAX)
+
+// size class마다 그 class의 list와 ghost를 보호하는 latch (CLOCK은 사용하지 않음)
+static std::mutex policy_latches[MAX_SIZE_CLASSES];
+
+/**
+ * @brief Pin the buffer for eviction if no one else has pinned it and the
+ * table quotas allow the incoming page to replace it.
+ * 
+ * @details Kept buffers are never claimed. The quotas are checked after the
+ * pin, when the buffer's tag can no longer change.
+ */
+static inline bool try_claim_victim(buf_descriptor_t *buf_desc, uint64_t incoming_key,
+                                    bool is_strict) {
+    if (buf_desc->is_kept.load(std::memory_order_relaxed))
+        return false;
+    int expected = 0;
+    if (!buf_desc->reference_count.compare_exchange_strong(expected, 1))
+        return false;
+    if (!buf_victim_allowed(buf_desc, incoming_key, is_strict)) {
+        buf_desc->reference_count.fetch_sub(1);
+        return false;
+    }
+    metric_pinned(1);
+    return true;
+}
+
+//  descriptor list ------------------------------------------------------------
+
+// descriptor index로 연결한 doubly linked list, head가 MRU이고 tail이 LRU
+typedef struct buf_list_t {
+    uint32_t head;
+    uint32_t tail;
+    uint32_t size;
+} buf_list_t;
+
+// list_claim_victim()이 LRU 쪽에서 한 번에 보는 최대 buffer 수
+#define LIST_CLAIM_MAX_STEPS (64)
+
+// list id 0은 어느 list에도 속하지 않음을 뜻함
+#define LIST_NONE (0)
+#define NUM_LISTS (3)
+
+// size class마다 따로 둔 list들
+static buf_list_t buf_lists[MAX_SIZE_CLASSES][NUM_LISTS];
+// descriptor별 연결 정보, 한 번에 하나의 정책만 쓰므로 모든 list가 공유
+static std::vector<uint32_t> list_prev;
+static std::vector<uint32_t> list_next;
+static std::vector<uint8_t> list_of;
+// descriptor에 새 page가 올라올 때마다 증가, 모아 둔 hit이 예전 page의 것인지 가림
+static std::unique_ptr<std::atomic<uint32_t>[]> list_generation;
+
+static void init_lists(uint32_t num_buf) {
+    for (int c = 0; c < MAX_SIZE_CLASSES; c++) {
+        for (int id = 0; id < NUM_LISTS; id++)
+            buf_lists[c][id] = {NO_BUF, NO_BUF, 0};
+    }
+    list_prev.assign(num_buf, NO_BUF);
+    list_next.assign(num_buf, NO_BUF);
+    list_of.assign(num_buf, LIST_NONE);
+    list_generation.reset(new std::atomic<uint32_t>[num_buf]);
+    for (uint32_t i = 0; i < num_buf; i++)
+        list_generation[i] = 0;
+}
+
+static void destroy_lists() {
+    std::vector<uint32_t>().swap(list_prev);
+    std::vector<uint32_t>().swap(list_next);
+    std::vector<uint8_t>().swap(list_of);
+    list_generation.reset();
+}
+
+static void list_push_head(uint8_t id, uint32_t index) {
+    buf_list_t *list = &buf_lists[CLASS_OF(index)][id];
+    list_prev[index] = NO_BUF;
+    list_next[index] = list->head;
+    if (list->head != NO_BUF)
+        list_prev[list->head] = index;
+    else
+        list->tail = index;
+    list->head = index;
+    list->size++;
+    list_of[index] = id;
+}
+
+static void list_remove(uint32_t index) {
+    buf_list_t *list = &buf_lists[CLASS_OF(index)][list_of[index]];
+    if (list_prev[index] != NO_BUF)
+        list_next[list_prev[index]] = list_next[index];
+    else
+        list->head = list_next[index];
+    if (list_next[index] != NO_BUF)
+        list_prev[list_next[index]] = list_prev[index];
+    else
+        list->tail = list_prev[index];
+    list->size--;
+    list_of[index] = LIST_NONE;
+}
+
+// list의 MRU로 옮김
+static void list_move_head(uint8_t id, uint32_t index) {
+    list_remove(index);
+    list_push_head(id, index);
+}
+
+/**
+ * @brief Claim the least recently used unpinned buffer of a list of a size
+ * class.
+ *
+ * @details Pinned and kept buffers met at the LRU end are moved to the MRU
+ * end, since they are in use, so later calls do not walk past them again.
+ * Buffers the table quotas protect are only skipped. At most
+ * LIST_CLAIM_MAX_STEPS buffers are looked at, so a claim under the class
+ * latch is bounded even when the LRU end is all pinned or protected; the
+ * caller then sees nullptr, and get_victim_buffer() looks for a table at its
+ * hard quota's own pages with get_own_victim(). The victim stays in the list
+ * until on_evict(), since get_buffer() may still give it back.
+ */
+static buf_descriptor_t *list_claim_victim(uint32_t size_class, uint8_t id,
+                                           uint64_t incoming_key, bool is_strict) {
+    uint32_t num_steps = std::min<uint32_t>(buf_lists[size_class][id].size, LIST_CLAIM_MAX_STEPS);
+    uint32_t i = buf_lists[size_class][id].tail;
+    for (; i != NO_BUF && num_steps > 0; num_steps--) {
+        buf_descriptor_t *candidate = &buffer_pool.buf_descriptors[i];
+        uint32_t prev = list_prev[i];
+        if (try_claim_victim(candidate, incoming_key, is_strict))
+            return candidate;
+        if (candidate->reference_count > 0 || candidate->is_kept)
+            list_move_head(id, i);
+        i = prev;
+    }
+    return nullptr;
+}
+
+//  hit buffer -----------------------------------------------------------------
+
+// thread 하나가 size class 하나에서 모은 hit
+typedef struct hit_buffer_t {
+    // 모은 뒤 init()이 다시 불렸다면 예전 pool의 hit이므로 버림
+    uint64_t epoch;
+    uint32_t num_hits;
+    uint32_t indexes[HIT_BUFFER_SIZE];
+    uint32_t generations[HIT_BUFFER_SIZE];
+} hit_buffer_t;
+
+static std::atomic<uint64_t> policy_epoch;
+static thread_local hit_buffer_t hit_buffers[MAX_SIZE_CLASSES];
+
+/**
+ * @brief Record a hit and apply the thread's hits of the class in one batch
+ * once enough have been collected.
+ *
+ * @param apply_hit Applies one hit to the policy's lists, called with the
+ * latch of the class held
+ *
+ * @details From half full on, the latch is only tried, so a thread rarely
+ * waits for it. A hit whose buffer got a new page since is dropped.
+ */
+static void record_hit(buf_descriptor_t *buf_desc, void (*apply_hit)(uint32_t index)) {
+    uint32_t index = BUF_INDEX(buf_desc);
+    uint32_t size_class = buf_desc->size_class;
+    hit_buffer_t *hits = &hit_buffers[size_class];
+    uint64_t epoch = policy_epoch.load(std::memory_order_relaxed);
+    if (hits->epoch != epoch) {
+        hits->epoch = epoch;
+        hits->num_hits = 0;
+    }
+    hits->indexes[hits->num_hits] = index;
+    hits->generations[hits->num_hits] = list_generation[index].load(std::memory_order_relaxed);
+    if (++hits->num_hits < HIT_BUFFER_SIZE / 2)
+        return;
+
+    std::unique_lock<std::mutex> guard(policy_latches[size_class], std::defer_lock);
+    if (hits->num_hits < HIT_BUFFER_SIZE) {
+        if (!guard.try_lock())
+            return;
+    } else {
+        guard.lock();
+    }
+    for (uint32_t i = 0; i < hits->num_hits; i++) {
+        uint32_t hit_index = hits->indexes[i];
+        if (list_of[hit_index] != LIST_NONE &&
+            list_generation[hit_index].load(std::memory_order_relaxed) == hits->generations[i])
+            apply_hit(hit_index);
+    }
+    hits->num_hits = 0;
+}
+
+// on_miss()에서 latch를 잡고 호출, 이 buffer에 대해 모아 둔 hit은 더 이상 반영하지 않음
+static inline void begin_generation(uint32_t index) {
+    list_generation[index].fetch_add(1, std::memory_order_relaxed);
+}
+
+//  ghost ring -----------------------------------------------------------------
+
+/*
+ * LRU of the keys of evicted pages. Its nodes and the key index are
+ * allocated by init(), sized to the most keys the ghost may hold, so a push
+ * or an erase allocates nothing; a push into a full ghost drops its LRU key.
+ * The nodes are linked by their index, and the index is a linear probing
+ * table of node indexes at most half full.
+ */
+typedef struct ghost_ring_t {
+    uint32_t capacity;
+    uint32_t size;
+    // head가 MRU이고 tail이 LRU, 쓰지 않는 node는 free_head부터 next로 연결
+    uint32_t head;
+    uint32_t tail;
+    uint32_t free_head;
+    std::unique_ptr<uint64_t[]> keys;
+    std::unique_ptr<uint32_t[]> prev;
+    std::unique_ptr<uint32_t[]> next;
+    // key로 node를 찾는 open addressing table, 빈 칸은 NO_BUF
+    uint32_t index_bits;
+    std::unique_ptr<uint32_t[]> index;
+} ghost_ring_t;
+
+static inline uint32_t ghost_slot_of(const ghost_ring_t *ghost, uint64_t key) {
+    return (uint32_t)((key * 0x9E3779B97F4A7C15ULL) >> (64 - ghost->index_bits));
+}
+
+// 모든 node를 free list로 되돌림
+static void ghost_clear(ghost_ring_t *ghost) {
+    ghost->size = 0;
+    ghost->head = NO_BUF;
+    ghost->tail = NO_BUF;
+    ghost->free_head = ghost->capacity > 0 ? 0 : NO_BUF;
+    for (uint32_t i = 0; i < ghost->capacity; i++)
+        ghost->next[i] = i + 1 < ghost->capacity ? i + 1 : NO_BUF;
+    if (ghost->index)
+        std::fill_n(ghost->index.get(), (size_t)1 << ghost->index_bits, NO_BUF);
+}
+
+static void ghost_init(ghost_ring_t *ghost, uint32_t capacity) {
+    ghost->capacity = std::max<uint32_t>(1, capacity);
+    ghost->keys.reset(new uint64_t[ghost->capacity]);
+    ghost->prev.reset(new uint32_t[ghost->capacity]);
+    ghost->next.reset(new uint32_t[ghost->capacity]);
+    ghost->index_bits = 1;
+    while (((size_t)1 << ghost->index_bits) < (size_t)ghost->capacity * 2)
+        ghost->index_bits++;
+    ghost->index.reset(new uint32_t[(size_t)1 << ghost->index_bits]);
+    ghost_clear(ghost);
+}
+
+static void ghost_destroy(ghost_ring_t *ghost) {
+    ghost->keys.reset();
+    ghost->prev.reset();
+    ghost->next.reset();
+    ghost->index.reset();
+    ghost->capacity = 0;
+    ghost_clear(ghost);
+}
+
+// key가 있는 index의 칸, 없으면 key가 들어갈 빈 칸
+static uint32_t ghost_probe(const ghost_ring_t *ghost, uint64_t key) {
+    uint32_t mask = (1u << ghost->index_bits) - 1;
+    uint32_t slot = ghost_slot_of(ghost, key);
+    while (ghost->index[slot] != NO_BUF && ghost->keys[ghost->index[slot]] != key)
+        slot = (slot + 1) & mask;
+    return slot;
+}
+
+// 없으면 NO_BUF
+static uint32_t ghost_find(const ghost_ring_t *ghost, uint64_t key) {
+    if (ghost->size == 0)
+        return NO_BUF;
+    return ghost->index[ghost_probe(ghost, key)];
+}
+
+static bool ghost_contains(const ghost_ring_t *ghost, uint64_t key) {
+    return ghost_find(ghost, key) != NO_BUF;
+}
+
+// node를 list와 index에서 빼고 free list로, index는 뒤의 칸들을 당겨 tombstone을 남기지 않음
+static void ghost_remove(ghost_ring_t *ghost, uint32_t node) {
+    if (ghost->prev[node] != NO_BUF)
+        ghost->next[ghost->prev[node]] = ghost->next[node];
+    else
+        ghost->head = ghost->next[node];
+    if (ghost->next[node] != NO_BUF)
+        ghost->prev[ghost->next[node]] = ghost->prev[node];
+    else
+        ghost->tail = ghost->prev[node];
+
+    uint32_t mask = (1u << ghost->index_bits) - 1;
+    uint32_t hole = ghost_probe(ghost, ghost->keys[node]);
+    for (uint32_t slot = (hole + 1) & mask; ghost->index[slot] != NO_BUF; slot = (slot + 1) & mask) {
+        // 원래 칸에서 hole을 지나 지금 칸까지 왔다면 hole로 당길 수 있음
+        uint32_t home = ghost_slot_of(ghost, ghost->keys[ghost->index[slot]]);
+        if (((slot - home) & mask) >= ((slot - hole) & mask)) {
+            ghost->index[hole] = ghost->index[slot];
+            hole = slot;
+        }
+    }
+    ghost->index[hole] = NO_BUF;
+
+    ghost->next[node] = ghost->free_head;
+    ghost->free_head = node;
+    ghost->size--;
+}
+
+static void ghost_pop_lru(ghost_ring_t *ghost) {
+    if (ghost->tail != NO_BUF)
+        ghost_remove(ghost, ghost->tail);
+}
+
+// key를 MRU로 넣고 그 node를 반환, key는 ghost에 없어야 함
+static uint32_t ghost_push(ghost_ring_t *ghost, uint64_t key) {
+    if (ghost->size == ghost->capacity)
+        ghost_pop_lru(ghost);
+    uint32_t node = ghost->free_head;
+    ghost->free_head = ghost->next[node];
+    ghost->keys[node] = key;
+    ghost->prev[node] = NO_BUF;
+    ghost->next[node] = ghost->head;
+    if (ghost->head != NO_BUF)
+        ghost->prev[ghost->head] = node;
+    else
+        ghost->tail = node;
+    ghost->head = node;
+    ghost->index[ghost_probe(ghost, key)] = node;
+    ghost->size++;
+    return node;
+}
+
+static bool ghost_erase(ghost_ring_t *ghost, uint64_t key) {
+    uint32_t node = ghost_find(ghost, key);
+    if (node == NO_BUF)
+        return false;
+    ghost_remove(ghost, node);
+    return true;
+}
+
+//  CLOCK ----------------------------------------------------------------------
+
+static int clock_init(uint32_t /* num_buf */) {
+    for (uint32_t c = 0; c < buffer_pool.num_size_classes; c++)
+        buffer_pool.size_classes[c].clock_hand = 0;
+    return 0;
+}
+
+static void clock_destroy() {
+}
+
+static void clock_on_hit(buf_descriptor_t *buf_desc) {
+    // 최댓값을 넘진 않는 선에서 사용 횟수 증가
+    int usage_count = buf_desc->usage_count.load();
+    while (usage_count < MAX_USAGE_COUNT &&
+           !buf_desc->usage_count.compare_exchange_weak(usage_count, usage_count + 1))
+        ;
+}
+
+static void clock_on_miss(buf_descriptor_t *buf_desc) {
+    buf_desc->usage_count = 1;
+}
+
+static buf_descriptor_t *clock_pick_victim(uint32_t size_class, uint64_t incoming_key,
+                                           bool is_strict) {
+    buf_size_class_t *buf_class = &buffer_pool.size_classes[size_class];
+    // usage_count가 최대인 버퍼도 MAX_USAGE_COUNT 바퀴 안에 0이 되므로,
+    // 그 이상 돌았는데도 못 찾았다면 모든 버퍼가 참조 중인 것
+    uint64_t max_steps = (uint64_t)buf_class->num_buf * (MAX_USAGE_COUNT + 1);
+
+    for (uint64_t i = 0; i < max_steps; i++) {
+        // 여러 thread가 hand를 함께 전진시키므로 각자 다른 버퍼를 검사하게 됨
+        // resize_buffer_pool()이 줄이는 중에는 빠질 buffer를 지나칠 수 있으나 pin되지 않음
+        uint32_t hand = buf_class->clock_hand.fetch_add(1) % buf_class->num_buf.load();
+        buf_descriptor_t* candidate = &buffer_pool.buf_descriptors[buf_class->first_buf + hand];
+
+        // 참조 중이거나 남겨 둘 페이지는 넘어감
+        if (candidate->reference_count > 0 || candidate->is_kept)
+            continue;
+
+        int usage_count = candidate->usage_count.load();
+        if (usage_count > 0) {
+            // 사용 횟수를 줄여 다음 순회에서 교체될 가능성 증가
+            candidate->usage_count.compare_exchange_strong(usage_count, usage_count - 1);
+            continue;
+        }
+
+        // 참조 중이지 않고 사용 횟수도 0이면 pin에 성공한 경우에만 교체 대상으로 반환
+        if (try_claim_victim(candidate, incoming_key, is_strict)) {
+            buf_log_debug("Evicting Candidate: " << candidate);
+            metric_add(METRIC_SWEEP_STEP, i + 1);
+            return candidate;
+        }
+    }
+    metric_add(METRIC_SWEEP_STEP, max_steps);
+    return nullptr;
+}
+
+static void clock_on_evict(buf_descriptor_t * /* buf_desc */) {
+}
+
+static void clock_on_resize(uint32_t /* size_class */) {
+}
+
+//  LRU-K ----------------------------------------------------------------------
+
+// 최근 K번의 참조 시각, [0]이 가장 최근이고 0은 참조 기록 없음
+typedef std::array<uint64_t, LRU_K> lru_k_history_t;
+
+// 참조가 K번 미만인 page, backward K-distance가 무한대이므로 먼저 LRU 순으로 교체
+#define LRU_K_HISTORY (1)
+// 참조가 K번 이상인 page, 가장 최근 참조 순으로 연결
+#define LRU_K_FULL (2)
+
+// size class마다 따로 세는 참조 시각
+static uint64_t lru_k_time[MAX_SIZE_CLASSES];
+static std::vector<lru_k_history_t> lru_k_history;
+// 쫓겨난 page의 참조 기록 (retained information), class마다 최대 num_buf개를 FIFO로 유지
+// 기록은 ghost의 node 번호로 찾음
+static ghost_ring_t lru_k_retained[MAX_SIZE_CLASSES];
+static std::unique_ptr<lru_k_history_t[]> lru_k_retained_history[MAX_SIZE_CLASSES];
+
+// class latch를 잡고 호출, 참조를 기록하고 참조 횟수에 맞는 list의 MRU로 옮김
+static inline void lru_k_reference(uint32_t index) {
+    for (int k = LRU_K - 1; k > 0; k--)
+        lru_k_history[index][k] = lru_k_history[index][k - 1];
+    lru_k_history[index][0] = ++lru_k_time[CLASS_OF(index)];
+    uint8_t id = lru_k_history[index][LRU_K - 1] != 0 ? LRU_K_FULL : LRU_K_HISTORY;
+    if (list_of[index] != LIST_NONE)
+        list_remove(index);
+    list_push_head(id, index);
+}
+
+// class latch를 잡고 호출, 보존하는 참조 기록을 class의 buffer 수로 줄임
+static void lru_k_trim_retained(uint32_t size_class) {
+    while (lru_k_retained[size_class].size > buffer_pool.size_classes[size_class].num_buf)
+        ghost_pop_lru(&lru_k_retained[size_class]);
+}
+
+static int lru_k_init(uint32_t num_buf) {
+    init_lists(num_buf);
+    policy_epoch++;
+    for (int c = 0; c < MAX_SIZE_CLASSES; c++)
+        lru_k_time[c] = 0;
+    lru_k_history.assign(num_buf, lru_k_history_t{});
+    for (uint32_t c = 0; c < buffer_pool.num_size_classes; c++) {
+        uint32_t max_num_buf = buffer_pool.size_classes[c].max_num_buf;
+        ghost_init(&lru_k_retained[c], max_num_buf);
+        lru_k_retained_history[c].reset(new lru_k_history_t[lru_k_retained[c].capacity]);
+    }
+    return 0;
+}
+
+static void lru_k_destroy() {
+    destroy_lists();
+    std::vector<lru_k_history_t>().swap(lru_k_history);
+    for (int c = 0; c < MAX_SIZE_CLASSES; c++) {
+        ghost_destroy(&lru_k_retained[c]);
+        lru_k_retained_history[c].reset();
+    }
+}
+
+static void lru_k_on_hit(buf_descriptor_t *buf_desc) {
+    record_hit(buf_desc, lru_k_reference);
+}
+
+static void lru_k_on_miss(buf_descriptor_t *buf_desc) {
+    uint32_t index = BUF_INDEX(buf_desc);
+    uint32_t size_class = CLASS_OF(index);
+    uint64_t key = ht_key(buf_desc->table_id, buf_desc->page_num);
+    std::lock_guard<std::mutex> guard(policy_latches[size_class]);
+    begin_generation(index);
+
+    // 최근에 쫓겨난 page라면 이전 참조 기록을 이어서 사용
+    uint32_t node = ghost_find(&lru_k_retained[size_class], key);
+    if (node != NO_BUF) {
+        lru_k_history[index] = lru_k_retained_history[size_class][node];
+        ghost_remove(&lru_k_retained[size_class], node);
+    } else {
+        lru_k_history[index] = lru_k_history_t{};
+    }
+    lru_k_reference(index);
+}
+
+static buf_descriptor_t *lru_k_pick_victim(uint32_t size_class, uint64_t incoming_key,
+                                           bool is_strict) {
+    std::lock_guard<std::mutex> guard(policy_latches[size_class]);
+    buf_descriptor_t *victim = list_claim_victim(size_class, LRU_K_HISTORY, incoming_key, is_strict);
+    if (victim != nullptr)
+        return victim;
+
+    // K번 이상 참조된 page는 LRU 쪽의 LRU_K_SAMPLE개 중 K번째 참조가 가장 오래된 page를 교체
+    // pin된 buffer까지 세어 한 번에 보는 수를 제한, 못 고르면 가장 오래 참조되지 않은 page
+    uint32_t oldest = NO_BUF;
+    uint32_t i = buf_lists[size_class][LRU_K_FULL].tail;
+    for (uint32_t n = 0; i != NO_BUF && n < LRU_K_SAMPLE; n++, i = list_prev[i]) {
+        buf_descriptor_t *candidate = &buffer_pool.buf_descriptors[i];
+        if (candidate->reference_count > 0 || candidate->is_kept)
+            continue;
+        if (oldest == NO_BUF || lru_k_history[i][LRU_K - 1] < lru_k_history[oldest][LRU_K - 1])
+            oldest = i;
+    }
+    if (oldest != NO_BUF &&
+        try_claim_victim(&buffer_pool.buf_descriptors[oldest], incoming_key, is_strict))
+        return &buffer_pool.buf_descriptors[oldest];
+    return list_claim_victim(size_class, LRU_K_FULL, incoming_key, is_strict);
+}
+
+static void lru_k_on_evict(buf_descriptor_t *buf_desc) {
+    uint32_t index = BUF_INDEX(buf_desc);
+    uint32_t size_class = CLASS_OF(index);
+    std::lock_guard<std::mutex> guard(policy_latches[size_class]);
+    if (list_of[index] == LIST_NONE)
+        return;
+    list_remove(index);
+
+    uint64_t key = ht_key(buf_desc->table_id, buf_desc->page_num);
+    // 쫓겨난 page는 hashtable에 하나뿐이므로 ghost에 같은 key가 없음
+    uint32_t node = ghost_push(&lru_k_retained[size_class], key);
+    lru_k_retained_history[size_class][node] = lru_k_history[index];
+    lru_k_trim_retained(size_class);
+}
+
+static void lru_k_on_resize(uint32_t size_class) {
+    std::lock_guard<std::mutex> guard(policy_latches[size_class]);
+    lru_k_trim_retained(size_class);
+}
+
+//  2Q -------------------------------------------------------------------------
+
+#define TWO_Q_A1IN (1)
+#define TWO_Q_AM (2)
+
+// size class마다 그 class의 buffer 수로 정한 크기와 ghost
+static uint32_t two_q_kin[MAX_SIZE_CLASSES];
+static uint32_t two_q_kout[MAX_SIZE_CLASSES];
+static ghost_ring_t two_q_a1out[MAX_SIZE_CLASSES];
+
+// class의 buffer 수로 A1in과 A1out의 크기를 정함
+static void two_q_set_sizes(uint32_t size_class) {
+    uint32_t class_num_buf = buffer_pool.size_classes[size_class].num_buf;
+    two_q_kin[size_class] = std::max<uint32_t>(1, class_num_buf / TWO_Q_KIN_DIVISOR);
+    two_q_kout[size_class] = std::max<uint32_t>(1, class_num_buf / TWO_Q_KOUT_DIVISOR);
+}
+
+static int two_q_init(uint32_t num_buf) {
+    init_lists(num_buf);
+    policy_epoch++;
+    for (uint32_t c = 0; c < buffer_pool.num_size_classes; c++) {
+        two_q_set_sizes(c);
+        // A1out은 class가 가장 커졌을 때의 크기로 할당
+        ghost_init(&two_q_a1out[c], buffer_pool.size_classes[c].max_num_buf / TWO_Q_KOUT_DIVISOR);
+    }
+    return 0;
+}
+
+static void two_q_destroy() {
+    destroy_lists();
+    for (int c = 0; c < MAX_SIZE_CLASSES; c++)
+        ghost_destroy(&two_q_a1out[c]);
+}
+
+// class latch를 잡고 호출
+// A1in의 page는 다시 참조되어도 FIFO 순서를 유지 (한 번의 scan이 Am을 밀어내지 않음)
+static void two_q_apply_hit(uint32_t index) {
+    if (list_of[index] == TWO_Q_AM)
+        list_move_head(TWO_Q_AM, index);
+}
+
+static void two_q_on_hit(buf_descriptor_t *buf_desc) {
+    record_hit(buf_desc, two_q_apply_hit);
+}
+
+static void two_q_on_miss(buf_descriptor_t *buf_desc) {
+    uint32_t index = BUF_INDEX(buf_desc);
+    uint64_t key = ht_key(buf_desc->table_id, buf_desc->page_num);
+    std::lock_guard<std::mutex> guard(policy_latches[CLASS_OF(index)]);
+    begin_generation(index);
+    // A1in에서 쫓겨난 뒤 다시 참조된 page만 Am으로 올라감
+    if (ghost_erase(&two_q_a1out[CLASS_OF(index)], key))
+        list_push_head(TWO_Q_AM, index);
+    else
+        list_push_head(TWO_Q_A1IN, index);
+}
+
+static buf_descriptor_t *two_q_pick_victim(uint32_t size_class, uint64_t incoming_key,
+                                           bool is_strict) {
+    std::lock_guard<std::mutex> guard(policy_latches[size_class]);
+    buf_descriptor_t *victim;
+    if (buf_lists[size_class][TWO_Q_A1IN].size > two_q_kin[size_class]) {
+        victim = list_claim_victim(size_class, TWO_Q_A1IN, incoming_key, is_strict);
+        if (victim == nullptr)
+            victim = list_claim_victim(size_class, TWO_Q_AM, incoming_key, is_strict);
+    } else {
+        victim = list_claim_victim(size_class, TWO_Q_AM, incoming_key, is_strict);
+        if (victim == nullptr)
+            victim = list_claim_victim(size_class, TWO_Q_A1IN, incoming_key, is_strict);
+    }
+    return victim;
+}
+
+static void two_q_on_evict(buf_descriptor_t *buf_desc) {
+    uint32_t index = BUF_INDEX(buf_desc);
+    uint32_t size_class = CLASS_OF(index);
+    std::lock_guard<std::mutex> guard(policy_latches[size_class]);
+    if (list_of[index] == LIST_NONE)
+        return;
+    if (list_of[index] == TWO_Q_A1IN) {
+        ghost_push(&two_q_a1out[size_class], ht_key(buf_desc->table_id, buf_desc->page_num));
+        if (two_q_a1out[size_class].size > two_q_kout[size_class])
+            ghost_pop_lru(&two_q_a1out[size_class]);
+    }
+    list_remove(index);
+}
+
+static void two_q_on_resize(uint32_t size_class) {
+    std::lock_guard<std::mutex> guard(policy_latches[size_class]);
+    two_q_set_sizes(size_class);
+    // 줄어든 A1out은 오래된 key부터 버림
+    while (two_q_a1out[size_class].size > two_q_kout[size_class])
+        ghost_pop_lru(&two_q_a1out[size_class]);
+}
+
+//  ARC ------------------------------------------------------------------------
+
+#define ARC_T1 (1)
+#define ARC_T2 (2)
+
+// size class마다 T1이 차지해야 할 목표 크기, ghost hit에 따라 조정됨
+static uint32_t arc_p[MAX_SIZE_CLASSES];
+// B1은 c개, B2는 T1, T2가 빈 때의 2c개까지 담도록 class의 max_num_buf로 할당
+static ghost_ring_t arc_b1[MAX_SIZE_CLASSES];
+static ghost_ring_t arc_b2[MAX_SIZE_CLASSES];
+
+static int arc_init(uint32_t num_buf) {
+    init_lists(num_buf);
+    policy_epoch++;
+    for (int c = 0; c < MAX_SIZE_CLASSES; c++)
+        arc_p[c] = 0;
+    for (uint32_t c = 0; c < buffer_pool.num_size_classes; c++) {
+        ghost_init(&arc_b1[c], buffer_pool.size_classes[c].max_num_buf);
+        ghost_init(&arc_b2[c], 2 * buffer_pool.size_classes[c].max_num_buf);
+    }
+    return 0;
+}
+
+static void arc_destroy() {
+    destroy_lists();
+    for (int c = 0; c < MAX_SIZE_CLASSES; c++) {
+        ghost_destroy(&arc_b1[c]);
+        ghost_destroy(&arc_b2[c]);
+    }
+}
+
+// class latch를 잡고 호출, 두 번 이상 참조된 page는 T2의 MRU로
+static void arc_apply_hit(uint32_t index) {
+    list_move_head(ARC_T2, index);
+}
+
+static void arc_on_hit(buf_descriptor_t *buf_desc) {
+    record_hit(buf_desc, arc_apply_hit);
+}
+
+static void arc_on_miss(buf_descriptor_t *buf_desc) {
+    uint32_t index = BUF_INDEX(buf_desc);
+    uint64_t key = ht_key(buf_desc->table_id, buf_desc->page_num);
+    uint32_t size_class = CLASS_OF(index);
+    std::lock_guard<std::mutex> guard(policy_latches[size_class]);
+    begin_generation(index);
+    if (ghost_erase(&arc_b1[size_class], key) || ghost_erase(&arc_b2[size_class], key))
+        list_push_head(ARC_T2, index);
+    else
+        list_push_head(ARC_T1, index);
+}
+
+static buf_descriptor_t *arc_pick_victim(uint32_t size_class, uint64_t incoming_key,
+                                         bool is_strict) {
+    std::lock_guard<std::mutex> guard(policy_latches[size_class]);
+    uint32_t c = buffer_pool.size_classes[size_class].num_buf;
+    ghost_ring_t *b1 = &arc_b1[size_class];
+    ghost_ring_t *b2 = &arc_b2[size_class];
+    uint32_t *p = &arc_p[size_class];
+    size_t b1_size = b1->size;
+    size_t b2_size = b2->size;
+    bool in_b2 = false;
+
+    // ghost hit이면 그 쪽 list가 더 컸어야 했으므로 target p를 조정
+    // soft quota를 무시하고 다시 고를 때(!is_strict)는 이미 조정했으므로 건너뜀
+    if (ghost_contains(b1, incoming_key)) {
+        uint32_t delta = std::max<uint32_t>(1, b2_size / b1_size);
+        if (is_strict)
+            *p = std::min(c, *p + delta);
+    } else if (ghost_contains(b2, incoming_key)) {
+        uint32_t delta = std::max<uint32_t>(1, b1_size / b2_size);
+        if (is_strict)
+            *p = *p > delta ? *p - delta : 0;
+        in_b2 = true;
+    }
+
+    uint32_t t1_size = buf_lists[size_class][ARC_T1].size;
+    bool from_t1 = t1_size >= 1 && (t1_size > *p || (in_b2 && t1_size == *p));
+    buf_descriptor_t *victim = list_claim_victim(size_class, from_t1 ? ARC_T1 : ARC_T2,
+                                                 incoming_key, is_strict);
+    if (victim == nullptr)
+        victim = list_claim_victim(size_class, from_t1 ? ARC_T2 : ARC_T1, incoming_key, is_strict);
+    return victim;
+}
+
+static void arc_on_evict(buf_descriptor_t *buf_desc) {
+    uint32_t index = BUF_INDEX(buf_desc);
+    uint64_t key = ht_key(buf_desc->table_id, buf_desc->page_num);
+    uint32_t size_class = CLASS_OF(index);
+    std::lock_guard<std::mutex> guard(policy_latches[size_class]);
+    if (list_of[index] == LIST_NONE)
+        return;
+    ghost_ring_t *b1 = &arc_b1[size_class];
+    ghost_ring_t *b2 = &arc_b2[size_class];
+    buf_list_t *lists = buf_lists[size_class];
+    ghost_push(list_of[index] == ARC_T1 ? b1 : b2, key);
+    list_remove(index);
+
+    // |T1| + |B1| <= c, |T1| + |T2| + |B1| + |B2| <= 2c 를 유지
+    // resize_buffer_pool()이 c를 줄인 직후에는 ghost를 비워도 넘칠 수 있음
+    uint32_t c = buffer_pool.size_classes[size_class].num_buf;
+    while (b1->size > 0 && lists[ARC_T1].size + b1->size > c)
+        ghost_pop_lru(b1);
+    while ((b1->size > 0 || b2->size > 0) &&
+           lists[ARC_T1].size + lists[ARC_T2].size +
+           b1->size + b2->size > 2 * (size_t)c) {
+        if (b2->size > 0)
+            ghost_pop_lru(b2);
+        else
+            ghost_pop_lru(b1);
+    }
+}
+
+// ghost는 다음 on_evict()에서 새 크기로 줄어들고, target p만 c 안으로 맞춤
+static void arc_on_resize(uint32_t size_class) {
+    std::lock_guard<std::mutex> guard(policy_latches[size_class]);
+    arc_p[size_class] = std::min<uint32_t>(arc_p[size_class],
+                                           buffer_pool.size_classes[size_class].num_buf);
+}
+
+//  ----------------------------------------------------------------------------
+
+static const buf_policy_t buf_policies[] = {
+    {"CLOCK", clock_init, clock_destroy, clock_on_hit, clock_on_miss,
+     clock_pick_victim, clock_on_evict, clock_on_resize},
+    {"LRU-K", lru_k_init, lru_k_destroy, lru_k_on_hit, lru_k_on_miss,
+     lru_k_pick_victim, lru_k_on_evict, lru_k_on_resize},
+    {"2Q", two_q_init, two_q_destroy, two_q_on_hit, two_q_on_miss,
+     two_q_pick_victim, two_q_on_evict, two_q_on_resize},
+    {"ARC", arc_init, arc_destroy, arc_on_hit, arc_on_miss,
+     arc_pick_victim, arc_on_evict, arc_on_resize},
+};
+
+const buf_policy_t *get_buf_policy(buf_policy_kind_t kind) {
+    if (kind < BUF_POLICY_CLOCK || kind > BUF_POLICY_ARC)
+        return nullptr;
+    return &buf_policies[kind];
+}
@@ -0,0 +1,70 @@
+#ifndef DB_REPLACEMENT_H_
+#define DB_REPLACEMENT_H_
+
+#include <cstdint>
+
+struct buf_descriptor_t;
+
+// LRU-K에서 기억하는 참조 횟수 K
+#define LRU_K (2)
+// K번 이상 참조된 page 중 LRU 쪽에서 이만큼을 보고 K번째 참조가 가장 오래된 page를 교체
+#define LRU_K_SAMPLE (8)
+
+// thread마다 모아 두었다가 한 번에 정책에 반영하는 hit 수 (LRU-K, 2Q, ARC)
+#define HIT_BUFFER_SIZE (64)
+
+// 2Q의 A1in(처음 참조된 page들의 FIFO)이 차지하는 비율 (num_buf / 4)
+#define TWO_Q_KIN_DIVISOR (4)
+// 2Q의 A1out(A1in에서 쫓겨난 page id의 ghost FIFO) 크기 비율 (num_buf / 2)
+#define TWO_Q_KOUT_DIVISOR (2)
+
+// init_buffer_pool()에서 선택할 수 있는 교체 정책
+typedef enum buf_policy_kind_t {
+    BUF_POLICY_CLOCK,   // clock sweep (usage_count, MAX_USAGE_COUNT)
+    BUF_POLICY_LRU_K,   // backward K-distance가 가장 큰 page를 교체
+    BUF_POLICY_2Q,      // A1in/A1out/Am 세 queue
+    BUF_POLICY_ARC      // T1/T2와 ghost B1/B2, 적응형 target p
+} buf_policy_kind_t;
+
+/**
+ * @brief Hooks of a buffer replacement policy.
+ *
+ * @details The buffer pool calls these hooks and never looks into the state
+ * of the policy. Descriptors are identified by their index in
+ * buffer_pool.buf_descriptors, and pages by ht_key(table_id, page_num).
+ * Each page size class of the pool has its own replacement state, and
+ * pick_victim() only returns buffers of the requested class. It skips
+ * kept buffers and, through buf_victim_allowed(), buffers the table quotas
+ * protect from incoming_key's table; with is_strict false the soft quotas
+ * are ignored.
+ *
+ * on_hit() is called with the page's hashtable partition latched, and the
+ * others without any latch of the buffer pool, so a policy may take its own
+ * latch in every hook but must not call back into the buffer pool. on_hit()
+ * runs on every hit, so the list policies do not latch there: each thread
+ * collects its hits and applies HIT_BUFFER_SIZE of them at once under the
+ * latch of the size class, like the usage_count of CLOCK needs no latch.
+ *
+ * init() gets the length of the descriptor array, which already covers the
+ * buffers resize_buffer_pool() may add later. A class's buffers that were
+ * removed by a resize are evicted first, so they are in no list afterwards.
+ */
+typedef struct buf_policy_t {
+    const char *name;
+    int (*init)(uint32_t num_buf);
+    void (*destroy)();
+    // hashtable에서 찾은 buffer를 pin할 때
+    void (*on_hit)(buf_descriptor_t *buf_desc);
+    // 새 page를 buffer에 올린 뒤
+    void (*on_miss)(buf_descriptor_t *buf_desc);
+    // 교체 대상을 pin(reference_count 0 -> 1)한 채로 반환, 모두 pin 중이면 nullptr
+    buf_descriptor_t *(*pick_victim)(uint32_t size_class, uint64_t incoming_key, bool is_strict);
+    // victim의 기존 page를 내보낼 때 (tag가 바뀌기 전)
+    void (*on_evict)(buf_descriptor_t *buf_desc);
+    // resize_buffer_pool()이 size class의 buffer 수를 바꾼 뒤
+    void (*on_resize)(uint32_t size_class);
+} buf_policy_t;
+
+const buf_policy_t *get_buf_policy(buf_policy_kind_t kind);
+
+#endif // DB_REPLACEMENT_H_
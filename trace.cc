@@ -0,0 +1,288 @@
+#include "trace.h"
+#include "buffer.h"
+#include "log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define TRACE_MAGIC "BUFTRACE"
+#define TRACE_VERSION (1)
+
+static const char *trace_kind_names[] = {
+    "lookup", "hit", "miss", "evict", "flush", "prefetch"
+};
+
+#ifdef BUF_TRACE
+std::atomic<bool> trace_enabled;
+
+// 한 thread만 기록하는 event ring
+typedef struct trace_ring_t {
+    // 지금까지 기록한 event 수, event는 events[head % TRACE_RING_SIZE]에 들어감
+    std::atomic<uint64_t> head;
+    // ring을 쓰는 thread가 살아 있는지
+    std::atomic<bool> in_use;
+    uint16_t thread_id;
+    trace_event_t events[TRACE_RING_SIZE];
+} trace_ring_t;
+
+// thread가 끝나면 ring을 돌려놓아 다음 thread가 다시 씀 (남은 event는 dump할 수 있음)
+typedef struct trace_ring_owner_t {
+    trace_ring_t *ring;
+    ~trace_ring_owner_t() {
+        if (ring)
+            ring->in_use = false;
+    }
+} trace_ring_owner_t;
+
+// 한 번 만든 ring은 해제하지 않음
+static std::mutex ring_list_latch;
+static std::vector<trace_ring_t *> rings;
+static thread_local trace_ring_owner_t local_ring;
+
+static trace_ring_t *acquire_ring() {
+    std::lock_guard<std::mutex> guard(ring_list_latch);
+    for (trace_ring_t *ring : rings) {
+        if (!ring->in_use) {
+            ring->in_use = true;
+            return ring;
+        }
+    }
+    trace_ring_t *ring = new trace_ring_t;
+    ring->head = 0;
+    ring->in_use = true;
+    ring->thread_id = rings.size();
+    rings.push_back(ring);
+    return ring;
+}
+
+/**
+ * @brief Append an event to the calling thread's ring.
+ *
+ * @details Each thread writes only its own ring, so no atomic
+ * read-modify-write or latch is needed once the ring is assigned.
+ */
+void trace_record(trace_kind_t kind, int64_t table_id, pagenum_t page_num, uint32_t buf_index) {
+    if (local_ring.ring == nullptr)
+        local_ring.ring = acquire_ring();
+    trace_ring_t *ring = local_ring.ring;
+
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    trace_event_t *event = &ring->events[head & (TRACE_RING_SIZE - 1)];
+    event->timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    event->table_id = table_id;
+    event->page_num = page_num;
+    event->buf_index = buf_index;
+    event->kind = kind;
+    event->thread_id = ring->thread_id;
+    ring->head.store(head + 1, std::memory_order_release);
+}
+#endif
+
+/**
+ * @brief Turn recording of trace events on or off.
+ *
+ * @retval 0: successful
+ * @retval others: tracing is not compiled in (build with BUF_TRACE)
+ */
+int trace_enable(bool enable) {
+#ifdef BUF_TRACE
+    trace_enabled = enable;
+    return 0;
+#else
+    (void)enable;
+    return 1;
+#endif
+}
+
+/**
+ * @brief Write the events in all threads' rings to a binary trace file.
+ *
+ * @retval 0: successful
+ * @retval others: failed, or tracing is not compiled in
+ *
+ * @details The file is a trace_file_header_t followed by the events, ring by
+ * ring. The dump does not stop the traced threads, so an event overwritten
+ * while it is copied may be torn. Turn tracing off first for an exact dump.
+ */
+int trace_dump(const char *pathname) {
+#ifdef BUF_TRACE
+    std::vector<trace_event_t> events;
+    {
+        std::lock_guard<std::mutex> guard(ring_list_latch);
+        for (trace_ring_t *ring : rings) {
+            uint64_t head = ring->head.load(std::memory_order_acquire);
+            uint64_t first = head > TRACE_RING_SIZE ? head - TRACE_RING_SIZE : 0;
+            for (uint64_t i = first; i < head; i++)
+                events.push_back(ring->events[i & (TRACE_RING_SIZE - 1)]);
+        }
+    }
+
+    FILE *file = fopen(pathname, "wb");
+    if (file == nullptr) {
+        buf_log_error("Error: cannot open trace file " << pathname);
+        return 1;
+    }
+    trace_file_header_t header;
+    memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_VERSION;
+    header.event_size = sizeof(trace_event_t);
+    header.num_events = events.size();
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(events.data(), sizeof(trace_event_t), events.size(), file) == events.size();
+    ok = fclose(file) == 0 && ok;
+    if (!ok)
+        buf_log_error("Error: failed to write trace file " << pathname);
+    return ok ? 0 : 1;
+#else
+    (void)pathname;
+    return 1;
+#endif
+}
+
+// binary trace file의 event를 모두 읽음, 실패하면 1
+static int read_trace_file(const char *trace_pathname, std::vector<trace_event_t> *events) {
+    FILE *in = fopen(trace_pathname, "rb");
+    if (in == nullptr) {
+        buf_log_error("Error: cannot open trace file " << trace_pathname);
+        return 1;
+    }
+
+    trace_file_header_t header;
+    bool ok = fread(&header, sizeof(header), 1, in) == 1 &&
+              memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) == 0 &&
+              header.version == TRACE_VERSION && header.event_size == sizeof(trace_event_t);
+    if (ok) {
+        events->resize(header.num_events);
+        ok = fread(events->data(), sizeof(trace_event_t), events->size(), in) == events->size();
+    }
+    fclose(in);
+    if (!ok) {
+        buf_log_error("Error: " << trace_pathname << " is not a valid trace file");
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Convert a binary trace file to CSV for offline analysis.
+ *
+ * @retval 0: successful
+ * @retval others: failed
+ *
+ * @details The events of all threads are merged in timestamp order, one line
+ * per event: timestamp_ns,thread_id,kind,table_id,page_num,buf_index. This
+ * works whether or not tracing is compiled in.
+ */
+int trace_convert(const char *trace_pathname, const char *csv_pathname) {
+    std::vector<trace_event_t> events;
+    if (read_trace_file(trace_pathname, &events))
+        return 1;
+
+    std::stable_sort(events.begin(), events.end(),
+                     [](const trace_event_t &a, const trace_event_t &b) {
+                         return a.timestamp_ns < b.timestamp_ns;
+                     });
+
+    FILE *out = fopen(csv_pathname, "w");
+    if (out == nullptr) {
+        buf_log_error("Error: cannot open " << csv_pathname);
+        return 1;
+    }
+    fprintf(out, "timestamp_ns,thread_id,kind,table_id,page_num,buf_index\n");
+    for (const trace_event_t &event : events) {
+        const char *kind = event.kind < sizeof(trace_kind_names) / sizeof(trace_kind_names[0])
+                               ? trace_kind_names[event.kind] : "unknown";
+        fprintf(out, "%lu,%u,%s,%ld,%ld,%ld\n", (unsigned long)event.timestamp_ns,
+                (unsigned)event.thread_id, kind, (long)event.table_id, (long)event.page_num,
+                event.buf_index == TRACE_NO_BUF ? -1L : (long)event.buf_index);
+    }
+    return fclose(out) == 0 ? 0 : 1;
+}
+
+/**
+ * @brief Replay the page accesses of a binary trace file against the buffer
+ * pool.
+ *
+ * @retval 0: successful
+ * @retval others: the trace file cannot be read
+ *
+ * @details Every hit and miss event is one page access of the traced
+ * workload. Each traced thread's accesses are replayed in timestamp order by
+ * a thread of its own, as fast as possible, with get_buffer() and
+ * unpin_buffer(). The tables must be opened first in the same order as when
+ * the trace was recorded, so they get the same table ids.
+ *
+ * The metrics are reset before the replay, so the hit ratio, page I/O and
+ * latency percentiles of get_buffer_stat_json() afterwards are those of the
+ * replay. Replaying one trace with different pool settings compares them on
+ * the same access stream.
+ */
+int trace_replay(const char *pathname, trace_replay_stat_t *stat) {
+    std::vector<trace_event_t> events;
+    if (read_trace_file(pathname, &events))
+        return 1;
+
+    std::map<uint16_t, std::vector<trace_event_t>> streams;
+    for (const trace_event_t &event : events) {
+        if (event.kind == TRACE_HIT || event.kind == TRACE_MISS)
+            streams[event.thread_id].push_back(event);
+    }
+    for (auto &stream : streams) {
+        std::stable_sort(stream.second.begin(), stream.second.end(),
+                         [](const trace_event_t &a, const trace_event_t &b) {
+                             return a.timestamp_ns < b.timestamp_ns;
+                         });
+    }
+
+    init_buffer_stat();
+    std::atomic<uint64_t> num_accesses{0};
+    std::atomic<uint64_t> num_failures{0};
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (auto &stream : streams) {
+        const std::vector<trace_event_t> *accesses = &stream.second;
+        threads.emplace_back([accesses, &num_accesses, &num_failures] {
+            uint64_t num_failed = 0;
+            for (const trace_event_t &event : *accesses) {
+                buf_descriptor_t *buf_desc = get_buffer(event.table_id, event.page_num);
+                if (buf_desc == nullptr)
+                    num_failed++;
+                else
+                    unpin_buffer(buf_desc);
+            }
+            num_accesses += accesses->size();
+            num_failures += num_failed;
+        });
+    }
+    for (std::thread &thread : threads)
+        thread.join();
+    uint64_t elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    stat->num_threads = streams.size();
+    stat->num_accesses = num_accesses;
+    stat->num_failures = num_failures;
+    stat->elapsed_ns = elapsed_ns;
+    stat->accesses_per_sec = elapsed_ns == 0 ? 0 : stat->num_accesses * 1e9 / elapsed_ns;
+    buf_log_info("Replayed " << stat->num_accesses << " accesses of " << stat->num_threads
+                 << " threads in " << elapsed_ns / 1000000 << "ms");
+    return 0;
+}
+
+// trace_replay()의 결과와 그 동안의 buffer pool 통계를 하나의 JSON object로
+std::string trace_replay_json(const trace_replay_stat_t *stat) {
+    return string_format(
+        "{\"replay\":{\"threads\":%u,\"accesses\":%lu,\"failures\":%lu,\"elapsed_ns\":%lu,"
+        "\"accesses_per_sec\":%.0f},\"buffer_pool\":",
+        stat->num_threads, (unsigned long)stat->num_accesses, (unsigned long)stat->num_failures,
+        (unsigned long)stat->elapsed_ns, stat->accesses_per_sec) + get_buffer_stat_json() + "}";
+}
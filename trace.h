@@ -0,0 +1,80 @@
+#ifndef DB_TRACE_H_
+#define DB_TRACE_H_
+
+#include "page.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// thread마다 보관하는 trace event 수 (2의 거듭제곱), 넘치면 오래된 event부터 덮어씀
+#define TRACE_RING_SIZE (1 << 16)
+
+// event에 buffer가 없을 때의 buf_index
+#define TRACE_NO_BUF (UINT32_MAX)
+
+typedef enum trace_kind_t {
+    TRACE_LOOKUP,       // hashtable 검색
+    TRACE_HIT,          // buffer에 있던 page를 반환
+    TRACE_MISS,         // page를 읽어 buffer에 올림
+    TRACE_EVICT,        // victim의 기존 page를 내보냄
+    TRACE_FLUSH,        // dirty page를 씀
+    TRACE_PREFETCH      // page를 미리 읽기 시작
+} trace_kind_t;
+
+// trace file에 그대로 기록되는 32 bytes event
+typedef struct trace_event_t {
+    // steady clock 기준 ns
+    uint64_t timestamp_ns;
+    int64_t table_id;
+    pagenum_t page_num;
+    uint32_t buf_index;
+    uint16_t kind;
+    // event를 기록한 thread의 ring 번호
+    uint16_t thread_id;
+} trace_event_t;
+
+// trace file의 맨 앞에 오며, 뒤에 num_events개의 trace_event_t가 이어짐
+typedef struct trace_file_header_t {
+    char magic[8];
+    uint32_t version;
+    uint32_t event_size;
+    uint64_t num_events;
+} trace_file_header_t;
+
+// trace_replay()의 결과
+typedef struct trace_replay_stat_t {
+    // trace에 기록된 thread 수, thread마다 하나의 replay thread가 재생
+    uint32_t num_threads;
+    uint64_t num_accesses;
+    // get_buffer()가 nullptr을 반환한 접근 수
+    uint64_t num_failures;
+    uint64_t elapsed_ns;
+    double accesses_per_sec;
+} trace_replay_stat_t;
+
+/*
+ * Tracing is compiled in only with BUF_TRACE. Otherwise trace_event() expands
+ * to nothing, and when compiled in, it costs one relaxed load while tracing
+ * is turned off with trace_enable().
+ */
+#ifdef BUF_TRACE
+extern std::atomic<bool> trace_enabled;
+void trace_record(trace_kind_t kind, int64_t table_id, pagenum_t page_num, uint32_t buf_index);
+
+#define trace_event(kind, table_id, page_num, buf_index) \
+    do { \
+        if (trace_enabled.load(std::memory_order_relaxed)) \
+            trace_record(kind, table_id, page_num, buf_index); \
+    } while (0)
+#else
+#define trace_event(kind, table_id, page_num, buf_index) do {} while (0)
+#endif
+
+int trace_enable(bool enable);
+int trace_dump(const char *pathname);
+int trace_convert(const char *trace_pathname, const char *csv_pathname);
+int trace_replay(const char *pathname, trace_replay_stat_t *stat);
+std::string trace_replay_json(const trace_replay_stat_t *stat);
+
+#endif // DB_TRACE_H_
@@ -0,0 +1,451 @@
+#include "wal.h"
+#include "log.h"
+#include "metrics.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define WAL_MAGIC "BUFWAL01"
+#define WAL_VERSION (1)
+
+#define wal_align(length) (((length) + 7) & ~(uint64_t)7)
+
+// log file의 첫 부분
+typedef struct wal_header_t {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    // redo를 시작할 위치, 그 앞의 update는 모두 table file에 반영되어 있음
+    lsn_t redo_lsn;
+} wal_header_t;
+
+typedef struct wal_t {
+    int fd;
+    std::atomic<bool> is_open;
+    // 아래 항목들을 보호
+    std::mutex latch;
+    // 쓰기를 맡은 thread가 끝났음을 기다리는 thread들에게 알림
+    std::condition_variable flush_cond;
+    // 아직 쓰지 않은 record들, 첫 byte의 위치는 buffer_lsn
+    std::vector<char> buffer;
+    lsn_t buffer_lsn;
+    // 쓰는 동안 buffer와 맞바꿔 두는 vector, 쓰기를 맡은 thread만 사용
+    std::vector<char> write_buffer;
+    lsn_t next_lsn;
+    std::atomic<lsn_t> flushed_lsn;
+    bool is_flushing;
+    // log 쓰기가 한 번 실패하면 이후의 flush도 모두 실패
+    bool has_failed;
+    lsn_t redo_lsn;
+    // wal_open() 시점의 log 끝, redo는 여기까지만 읽음
+    lsn_t recovered_lsn;
+    // 지금 열려 있는 table들의 경로
+    std::map<int64_t, std::string> tables;
+    // redo할 record가 남아 있는 table들의 경로
+    std::set<std::string> pending;
+} wal_t;
+
+static wal_t wal;
+
+static uint32_t wal_checksum(const wal_record_t *record, const char *data) {
+    wal_record_t header = *record;
+    header.checksum = 0;
+    uint32_t hash = 2166136261u;
+    const char *bytes = (const char *)&header;
+    for (size_t i = 0; i < sizeof(header); i++)
+        hash = (hash ^ (uint8_t)bytes[i]) * 16777619u;
+    for (size_t i = 0; i < record->data_length; i++)
+        hash = (hash ^ (uint8_t)data[i]) * 16777619u;
+    return hash;
+}
+
+// 같은 file을 다른 경로로 열어도 같은 table로 보도록 절대 경로로 바꿈
+static std::string canonical_path(const char *pathname) {
+    char *resolved = realpath(pathname, nullptr);
+    if (resolved == nullptr)
+        return pathname;
+    std::string path(resolved);
+    free(resolved);
+    return path;
+}
+
+static bool write_all(int fd, const char *data, size_t size, off_t offset) {
+    while (size > 0) {
+        ssize_t written = pwrite(fd, data, size, offset);
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+            return false;
+        data += written;
+        size -= written;
+        offset += written;
+    }
+    return true;
+}
+
+static int write_header(lsn_t redo_lsn) {
+    wal_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, WAL_MAGIC, sizeof(header.magic));
+    header.version = WAL_VERSION;
+    header.redo_lsn = redo_lsn;
+    if (!write_all(wal.fd, (const char *)&header, sizeof(header), 0) || fdatasync(wal.fd) != 0) {
+        buf_log_error("Error: failed to write the log header: " << strerror(errno));
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Read the record at lsn if it is complete and intact.
+ *
+ * @details A record that ends after end, or whose position or checksum does
+ * not match, is the torn tail of a write cut off by a crash.
+ */
+static bool read_record(lsn_t lsn, lsn_t end, wal_record_t *record, std::vector<char> *data) {
+    if (lsn + sizeof(wal_record_t) > end ||
+        pread(wal.fd, record, sizeof(wal_record_t), lsn) != sizeof(wal_record_t))
+        return false;
+    if (record->start_lsn != lsn || record->length < sizeof(wal_record_t) ||
+        record->data_length > record->length - sizeof(wal_record_t) || lsn + record->length > end)
+        return false;
+    data->resize(record->data_length);
+    if (record->data_length > 0 &&
+        pread(wal.fd, data->data(), record->data_length, lsn + sizeof(wal_record_t)) !=
+            (ssize_t)record->data_length)
+        return false;
+    return wal_checksum(record, data->data()) == record->checksum;
+}
+
+// wal.latch를 잡은 상태에서 호출, record가 끝나는 위치를 반환
+static lsn_t append_record(wal_record_kind_t kind, int64_t table_id, pagenum_t page_num,
+                           uint32_t offset, uint32_t data_length, const void *data) {
+    wal_record_t record;
+    record.length = wal_align(sizeof(wal_record_t) + data_length);
+    record.start_lsn = wal.next_lsn;
+    record.table_id = table_id;
+    record.page_num = page_num;
+    record.kind = kind;
+    record.offset = offset;
+    record.data_length = data_length;
+    record.checksum = wal_checksum(&record, (const char *)data);
+
+    // 늘어난 부분은 0으로 채워지므로 padding도 0
+    size_t pos = wal.buffer.size();
+    wal.buffer.resize(pos + record.length);
+    memcpy(&wal.buffer[pos], &record, sizeof(record));
+    memcpy(&wal.buffer[pos + sizeof(record)], data, data_length);
+    wal.next_lsn += record.length;
+    metric_add(METRIC_WAL_RECORD);
+    return wal.next_lsn;
+}
+
+/**
+ * @brief Open the write-ahead log, creating it if it does not exist.
+ *
+ * @retval 0: successful
+ * @retval others: failed
+ *
+ * @details Call after init_buffer_pool() and before buffer_open_table(). The
+ * log is scanned from the redo position of the last checkpoint to find its
+ * end, and a torn record at the end is cut off. The updates found are redone
+ * table by table when each table is opened (see wal_redo()).
+ */
+int wal_open(const char *pathname) {
+    if (wal.is_open) {
+        buf_log_error("Error: the log is already open");
+        return 1;
+    }
+    int fd = open(pathname, O_RDWR | O_CREAT, 0644);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        buf_log_error("Error: cannot open log " << pathname << ": " << strerror(errno));
+        if (fd >= 0)
+            close(fd);
+        return 1;
+    }
+    wal.fd = fd;
+
+    wal_header_t header;
+    lsn_t size = st.st_size;
+    if (size < WAL_HEADER_SIZE) {
+        // 새 log
+        if (ftruncate(fd, WAL_HEADER_SIZE) != 0 || write_header(WAL_HEADER_SIZE) != 0) {
+            close(fd);
+            return 1;
+        }
+        header.redo_lsn = WAL_HEADER_SIZE;
+        size = WAL_HEADER_SIZE;
+    } else if (pread(fd, &header, sizeof(header), 0) != sizeof(header) ||
+               memcmp(header.magic, WAL_MAGIC, sizeof(header.magic)) != 0 ||
+               header.version != WAL_VERSION) {
+        buf_log_error("Error: " << pathname << " is not a valid log");
+        close(fd);
+        return 1;
+    }
+
+    // 온전히 기록된 마지막 record까지 읽으며 redo할 table들을 찾음
+    std::map<int64_t, std::string> log_tables;
+    wal_record_t record;
+    std::vector<char> data;
+    uint64_t num_updates = 0;
+    lsn_t lsn = header.redo_lsn;
+    wal.pending.clear();
+    while (read_record(lsn, size, &record, &data)) {
+        if (record.kind == WAL_TABLE) {
+            log_tables[record.table_id] = std::string(data.begin(), data.end());
+        } else if (record.kind == WAL_UPDATE) {
+            auto table = log_tables.find(record.table_id);
+            if (table != log_tables.end())
+                wal.pending.insert(table->second);
+            num_updates++;
+        }
+        lsn += record.length;
+    }
+    // 잘린 record 뒤에 새 record를 이어 쓰도록 잘라냄
+    if (lsn < size && ftruncate(fd, lsn) != 0) {
+        buf_log_error("Error: cannot truncate log " << pathname << ": " << strerror(errno));
+        close(fd);
+        return 1;
+    }
+
+    wal.buffer.clear();
+    wal.buffer_lsn = lsn;
+    wal.next_lsn = lsn;
+    wal.flushed_lsn = lsn;
+    wal.is_flushing = false;
+    wal.has_failed = false;
+    wal.redo_lsn = header.redo_lsn;
+    wal.recovered_lsn = lsn;
+    wal.tables.clear();
+    wal.is_open = true;
+    buf_log_info("Opened log " << pathname << ": " << num_updates << " updates of "
+                 << wal.pending.size() << " tables to redo");
+    return 0;
+}
+
+/**
+ * @brief Flush and close the log.
+ *
+ * @param truncate Whether every logged update is in the table files, e.g.
+ * after a successful checkpoint with no concurrent updates
+ *
+ * @details With truncate, the log is emptied so the next wal_open() has
+ * nothing to scan, unless some table still has updates to redo.
+ */
+void wal_close(bool truncate) {
+    if (!wal.is_open)
+        return;
+    lsn_t lsn;
+    {
+        std::lock_guard<std::mutex> guard(wal.latch);
+        lsn = wal.next_lsn;
+        truncate = truncate && wal.pending.empty();
+    }
+    wal_flush(lsn);
+
+    // header보다 먼저 잘라 두면 그 사이 crash가 나도 redo_lsn 뒤에는 읽을 record가 없음
+    if (truncate && (ftruncate(wal.fd, WAL_HEADER_SIZE) != 0 || write_header(WAL_HEADER_SIZE) != 0))
+        buf_log_error("Error: failed to truncate the log");
+    close(wal.fd);
+    wal.is_open = false;
+}
+
+bool wal_is_open() {
+    return wal.is_open;
+}
+
+/**
+ * @brief Log which file table_id refers to.
+ *
+ * @details Table ids are assigned in the order tables are opened, so they can
+ * change between runs. Redo maps the table ids of update records to files
+ * with the WAL_TABLE record logged before them.
+ */
+void wal_log_table(int64_t table_id, const char *pathname) {
+    if (!wal.is_open)
+        return;
+    std::string path = canonical_path(pathname);
+    std::lock_guard<std::mutex> guard(wal.latch);
+    wal.tables[table_id] = path;
+    append_record(WAL_TABLE, table_id, 0, 0, path.size(), path.data());
+}
+
+/**
+ * @brief Log the new content of part of a page.
+ *
+ * @return The LSN to pass to wal_flush() to make the update durable.
+ *
+ * @details The record is only buffered. It is written when some thread
+ * flushes the log up to it or a later record, or once WAL_BUFFER_SIZE bytes
+ * are waiting.
+ */
+lsn_t wal_log_update(int64_t table_id, pagenum_t page_num, uint32_t offset, uint32_t length,
+                     const void *data) {
+    if (!wal.is_open)
+        return 0;
+    std::unique_lock<std::mutex> lock(wal.latch);
+    lsn_t lsn = append_record(WAL_UPDATE, table_id, page_num, offset, length, data);
+    bool is_full = wal.buffer.size() >= WAL_BUFFER_SIZE;
+    lock.unlock();
+    if (is_full)
+        wal_flush(lsn);
+    return lsn;
+}
+
+/**
+ * @brief Make the log durable up to lsn (group commit).
+ *
+ * @retval 0: successful
+ * @retval others: a log write failed
+ *
+ * @details One thread at a time writes and syncs everything buffered so far.
+ * The threads that arrive meanwhile wait, and the next of them to go writes
+ * all the records they added with a single fdatasync(), so the number of
+ * syncs does not grow with the number of committing threads.
+ *
+ * A commit is wal_flush() with the LSN of the transaction's last update.
+ */
+int wal_flush(lsn_t lsn) {
+    if (!wal.is_open || lsn <= wal.flushed_lsn.load())
+        return 0;
+
+    std::unique_lock<std::mutex> lock(wal.latch);
+    lsn = std::min(lsn, wal.next_lsn);
+    while (wal.flushed_lsn < lsn && !wal.has_failed) {
+        if (wal.is_flushing) {
+            wal.flush_cond.wait(lock);
+            continue;
+        }
+        wal.is_flushing = true;
+        lsn_t start = wal.buffer_lsn;
+        wal.write_buffer.clear();
+        wal.buffer.swap(wal.write_buffer);
+        wal.buffer_lsn = wal.next_lsn;
+        lock.unlock();
+
+        bool ok = write_all(wal.fd, wal.write_buffer.data(), wal.write_buffer.size(), start) &&
+                  fdatasync(wal.fd) == 0;
+        if (!ok)
+            buf_log_error("Error: failed to write the log: " << strerror(errno));
+        metric_add(METRIC_WAL_SYNC);
+
+        lock.lock();
+        wal.is_flushing = false;
+        if (ok)
+            wal.flushed_lsn = start + wal.write_buffer.size();
+        else
+            wal.has_failed = true;
+        wal.flush_cond.notify_all();
+    }
+    return wal.has_failed ? 1 : 0;
+}
+
+/**
+ * @brief Redo the logged updates of a table.
+ *
+ * @retval 0: successful
+ * @retval others: apply failed
+ *
+ * @details Calls apply for every update of the file since the last
+ * checkpoint, in log order. Updates are page images, so applying one that is
+ * already in the file again is harmless. Each file is redone once, the first
+ * time it is opened after wal_open().
+ */
+int wal_redo(const char *pathname, wal_redo_fn_t apply, void *arg) {
+    if (!wal.is_open)
+        return 0;
+    std::string path = canonical_path(pathname);
+    lsn_t lsn;
+    {
+        std::lock_guard<std::mutex> guard(wal.latch);
+        if (wal.pending.count(path) == 0)
+            return 0;
+        lsn = wal.redo_lsn;
+    }
+
+    std::map<int64_t, std::string> log_tables;
+    wal_record_t record;
+    std::vector<char> data;
+    uint64_t num_redone = 0;
+    for (; read_record(lsn, wal.recovered_lsn, &record, &data); lsn += record.length) {
+        if (record.kind == WAL_TABLE) {
+            log_tables[record.table_id] = std::string(data.begin(), data.end());
+            continue;
+        }
+        auto table = log_tables.find(record.table_id);
+        if (record.kind != WAL_UPDATE || table == log_tables.end() || table->second != path)
+            continue;
+        if (apply(lsn + record.length, record.page_num, record.offset, record.data_length, data.data(), arg) != 0) {
+            buf_log_error("Error: failed to redo page " << record.page_num << " of " << path);
+            return 1;
+        }
+        num_redone++;
+    }
+
+    std::lock_guard<std::mutex> guard(wal.latch);
+    wal.pending.erase(path);
+    buf_log_info("Redid " << num_redone << " updates of " << path);
+    return 0;
+}
+
+/**
+ * @brief Start a checkpoint of the log.
+ *
+ * @return The redo position to pass to wal_end_checkpoint(), or 0 if the
+ * checkpoint must not move it.
+ *
+ * @details Every update logged before the returned position is on a page that
+ * is already dirty, since pages are marked dirty before their update is
+ * logged. The open tables are logged again at the new position so that redo
+ * can map their ids without reading the older part of the log.
+ *
+ * While some table has not been redone yet, its updates must stay in the log,
+ * so the redo position does not move.
+ */
+lsn_t wal_begin_checkpoint() {
+    if (!wal.is_open)
+        return 0;
+    std::lock_guard<std::mutex> guard(wal.latch);
+    if (!wal.pending.empty())
+        return 0;
+    lsn_t redo_lsn = wal.next_lsn;
+    for (auto &table : wal.tables)
+        append_record(WAL_TABLE, table.first, 0, 0, table.second.size(), table.second.data());
+    return redo_lsn;
+}
+
+/**
+ * @brief Finish a checkpoint after the pages dirty at its start are durable.
+ *
+ * @retval 0: successful
+ * @retval others: failed to write the log
+ */
+int wal_end_checkpoint(lsn_t redo_lsn) {
+    if (!wal.is_open || redo_lsn == 0)
+        return 0;
+    lsn_t lsn;
+    {
+        std::lock_guard<std::mutex> guard(wal.latch);
+        lsn = wal.next_lsn;
+    }
+    // 새 redo 위치의 table record들이 먼저 기록되어 있어야 함
+    if (wal_flush(lsn) != 0 || write_header(redo_lsn) != 0)
+        return 1;
+    std::lock_guard<std::mutex> guard(wal.latch);
+    wal.redo_lsn = redo_lsn;
+    return 0;
+}
@@ -0,0 +1,53 @@
+#ifndef DB_WAL_H_
+#define DB_WAL_H_
+
+#include "page.h"
+
+#include <cstdint>
+
+// log 안의 byte 위치, record의 LSN은 그 record가 끝나는 위치
+typedef uint64_t lsn_t;
+
+// log file 맨 앞의 header 영역, record는 그 뒤부터 기록
+#define WAL_HEADER_SIZE (4096)
+// 이만큼 쌓이면 commit을 기다리지 않고 log를 씀
+#define WAL_BUFFER_SIZE (1 << 20)
+
+typedef enum wal_record_kind_t {
+    WAL_TABLE = 1,      // table_id가 가리키는 table file의 경로 (data)
+    WAL_UPDATE = 2      // page의 [offset, offset + data_length) 구간의 새 내용 (data)
+} wal_record_kind_t;
+
+// log에 그대로 기록되는 record header, 뒤에 data가 이어지고 8 bytes 단위로 맞춤
+typedef struct wal_record_t {
+    // header, data, padding을 합한 크기
+    uint32_t length;
+    // checksum을 0으로 두고 계산한 header와 data의 FNV-1a hash
+    uint32_t checksum;
+    // record가 시작하는 위치, 잘못 읽은 record를 걸러냄
+    lsn_t start_lsn;
+    int64_t table_id;
+    pagenum_t page_num;
+    uint16_t kind;
+    uint16_t offset;
+    uint32_t data_length;
+} wal_record_t;
+
+// WAL_UPDATE record를 다시 적용하는 함수, lsn은 record가 끝나는 위치, 0이 아니면 redo 중단
+typedef int (*wal_redo_fn_t)(lsn_t lsn, pagenum_t page_num, uint32_t offset, uint32_t length,
+                             const char *data, void *arg);
+
+int wal_open(const char *pathname);
+void wal_close(bool truncate);
+bool wal_is_open();
+
+void wal_log_table(int64_t table_id, const char *pathname);
+lsn_t wal_log_update(int64_t table_id, pagenum_t page_num, uint32_t offset, uint32_t length,
+                     const void *data);
+int wal_flush(lsn_t lsn);
+int wal_redo(const char *pathname, wal_redo_fn_t apply, void *arg);
+
+lsn_t wal_begin_checkpoint();
+int wal_end_checkpoint(lsn_t redo_lsn);
+
+#endif // DB_WAL_H_
@@ -0,0 +1,362 @@
+#include "warm.h"
+#include "buffer.h"
+#include "log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#define warm_align(length) (((length) + 7) & ~(uint64_t)7)
+
+typedef struct warm_t {
+    // table_id별 경로, dump file은 table_id 대신 경로로 table을 가리킴
+    std::mutex tables_latch;
+    std::map<int64_t, std::string> table_paths;
+
+    // warm_open()이 시작한 주기적인 dump
+    std::string pathname;
+    std::thread dumper;
+    bool is_open;
+    uint32_t interval_ms;
+    std::mutex latch;
+    std::condition_variable cond;
+    // 두 thread가 같은 임시 file에 쓰지 않도록 dump를 하나씩 실행
+    std::mutex dump_latch;
+} warm_t;
+
+static warm_t warm;
+
+// buffer_open_table()이 연 table의 경로를 기억
+void warm_register_table(int64_t table_id, const char *pathname) {
+    std::lock_guard<std::mutex> guard(warm.tables_latch);
+    warm.table_paths[table_id] = pathname;
+}
+
+// 모두 쓸 때까지 나누어 씀
+static int write_all(int fd, const char *data, size_t size) {
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+            return 1;
+        data += written;
+        size -= written;
+    }
+    return 0;
+}
+
+/**
+ * @brief Write the pages resident in the buffer pool to a dump file.
+ *
+ * @retval 0: successful
+ * @retval others: failed, and an existing dump file is left as it was
+ *
+ * @details Each valid buffer is recorded as its page number and usage count,
+ * grouped by table, with the table's path instead of its table_id, since a
+ * table may get another table_id after a restart. A buffer whose tag is
+ * being changed is skipped rather than waited for, so the pool keeps running
+ * meanwhile and the dump may miss a few pages.
+ *
+ * The file is written next to pathname and renamed over it, so a crash
+ * during a dump leaves the previous dump intact.
+ */
+int warm_dump(const char *pathname) {
+    std::lock_guard<std::mutex> dump_guard(warm.dump_latch);
+    std::map<int64_t, std::vector<uint64_t>> entries;
+    uint64_t num_entries = 0;
+    for (uint32_t c = 0; c < buffer_pool.num_size_classes; c++) {
+        buf_size_class_t *size_class = &buffer_pool.size_classes[c];
+        uint32_t num_buf = size_class->num_buf;
+        for (uint32_t i = 0; i < num_buf; i++) {
+            buf_descriptor_t *buf_desc = &buffer_pool.buf_descriptors[size_class->first_buf + i];
+            // tag는 I/O latch로 보호되므로 잡을 수 있을 때만 읽음
+            if (!buf_desc->io_latch.try_lock())
+                continue;
+            int64_t table_id = buf_desc->table_id;
+            pagenum_t page_num = buf_desc->page_num;
+            bool is_valid = buf_desc->is_valid;
+            uint32_t usage_count = buf_desc->usage_count;
+            buf_desc->io_latch.unlock();
+            if (table_id < 0 || !is_valid)
+                continue;
+            entries[table_id].push_back(warm_entry(page_num, usage_count));
+            num_entries++;
+        }
+    }
+
+    std::vector<char> data(sizeof(warm_header_t));
+    uint32_t num_tables = 0;
+    {
+        std::lock_guard<std::mutex> guard(warm.tables_latch);
+        for (auto &table : entries) {
+            auto it = warm.table_paths.find(table.first);
+            if (it == warm.table_paths.end()) {
+                num_entries -= table.second.size();
+                continue;
+            }
+            std::vector<uint64_t> &pages = table.second;
+            std::sort(pages.begin(), pages.end(), [](uint64_t a, uint64_t b) {
+                return warm_entry_page(a) < warm_entry_page(b);
+            });
+            warm_table_t header = {(uint32_t)it->second.size(),
+                                   get_table_page_size(table.first), pages.size()};
+            size_t offset = data.size();
+            data.resize(offset + sizeof(header) + warm_align(header.path_length) +
+                        pages.size() * sizeof(uint64_t));
+            memcpy(&data[offset], &header, sizeof(header));
+            offset += sizeof(header);
+            memcpy(&data[offset], it->second.data(), header.path_length);
+            offset += warm_align(header.path_length);
+            memcpy(&data[offset], pages.data(), pages.size() * sizeof(uint64_t));
+            num_tables++;
+        }
+    }
+    warm_header_t header = {WARM_MAGIC, num_tables, 0, num_entries};
+    memcpy(data.data(), &header, sizeof(header));
+
+    std::string tmp_pathname = std::string(pathname) + ".tmp";
+    int fd = open(tmp_pathname.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        buf_log_error("Error: Failed to open " << tmp_pathname << ": " << strerror(errno));
+        return 1;
+    }
+    bool is_written = write_all(fd, data.data(), data.size()) == 0 && fsync(fd) == 0;
+    close(fd);
+    if (!is_written || rename(tmp_pathname.c_str(), pathname) != 0) {
+        buf_log_error("Error: Failed to write " << pathname << ": " << strerror(errno));
+        unlink(tmp_pathname.c_str());
+        return 1;
+    }
+    buf_log_info("Dumped " << num_entries << " resident pages of " << num_tables
+                 << " tables to " << pathname);
+    return 0;
+}
+
+// dump file 전체를 읽음, 없거나 읽을 수 없으면 false
+static bool read_dump(const char *pathname, std::vector<char> *data) {
+    int fd = open(pathname, O_RDONLY);
+    if (fd < 0)
+        return false;
+    char chunk[1 << 16];
+    ssize_t length;
+    while ((length = read(fd, chunk, sizeof(chunk))) != 0) {
+        if (length < 0 && errno == EINTR)
+            continue;
+        if (length < 0) {
+            close(fd);
+            return false;
+        }
+        data->insert(data->end(), chunk, chunk + length);
+    }
+    close(fd);
+    return true;
+}
+
+/**
+ * @brief Read the pages of a dump file back into the buffer pool.
+ *
+ * @return The number of pages read, or -1 if the file does not exist or is
+ * not a dump file.
+ *
+ * @details Call after the tables are opened with buffer_open_table(). Pages
+ * of tables that are not open, or that were opened with another page size,
+ * are skipped.
+ *
+ * The hottest pages (highest usage count) are read first, and pages of the
+ * same heat in table and page order, so the reads are mostly sequential and
+ * the async I/O layer can coalesce them. WARM_LOAD_THREADS threads take
+ * batches of adjacent pages in that order, start reading each batch with
+ * prefetch_buffer() and then get every page of it. At most all but
+ * 1/WARM_FREE_FRACTION of a size class is filled, which leaves room for the
+ * workload that starts meanwhile. With CLOCK, a page gets back its dumped
+ * usage count; the other policies do not keep one, so with them only the
+ * file order remains.
+ *
+ * This returns when all pages are read. Call it from a thread of its own to
+ * serve requests while the pool warms up.
+ */
+int64_t warm_load(const char *pathname) {
+    std::vector<char> data;
+    if (!read_dump(pathname, &data) || data.size() < sizeof(warm_header_t))
+        return -1;
+    warm_header_t header;
+    memcpy(&header, data.data(), sizeof(header));
+    if (header.magic != WARM_MAGIC) {
+        buf_log_error("Error: " << pathname << " is not a buffer pool dump");
+        return -1;
+    }
+
+    std::map<std::string, int64_t> table_ids;
+    {
+        std::lock_guard<std::mutex> guard(warm.tables_latch);
+        for (auto &table : warm.table_paths)
+            table_ids[table.second] = table.first;
+    }
+    // (usage_count의 역순, table_id, page_num)으로 정렬할 page들
+    std::vector<std::tuple<uint32_t, int64_t, pagenum_t>> pages;
+    size_t offset = sizeof(header);
+    for (uint32_t t = 0; t < header.num_tables; t++) {
+        warm_table_t table;
+        if (offset + sizeof(table) > data.size())
+            break;
+        memcpy(&table, &data[offset], sizeof(table));
+        offset += sizeof(table);
+        if (offset + warm_align(table.path_length) + table.num_entries * sizeof(uint64_t) >
+            data.size())
+            break;
+        std::string path(&data[offset], table.path_length);
+        offset += warm_align(table.path_length);
+        auto it = table_ids.find(path);
+        if (it != table_ids.end() && get_table_page_size(it->second) == table.page_size) {
+            for (uint64_t i = 0; i < table.num_entries; i++) {
+                uint64_t entry;
+                memcpy(&entry, &data[offset + i * sizeof(entry)], sizeof(entry));
+                pages.emplace_back(MAX_USAGE_COUNT - std::min<uint32_t>(
+                                       warm_entry_usage(entry), MAX_USAGE_COUNT),
+                                   it->second, warm_entry_page(entry));
+            }
+        }
+        offset += table.num_entries * sizeof(uint64_t);
+    }
+    std::sort(pages.begin(), pages.end());
+
+    // size class마다 채울 수 있는 만큼만, 뜨거운 page부터 남김
+    uint32_t room[MAX_SIZE_CLASSES];
+    for (uint32_t c = 0; c < buffer_pool.num_size_classes; c++) {
+        uint32_t num_buf = buffer_pool.size_classes[c].num_buf;
+        room[c] = num_buf - num_buf / WARM_FREE_FRACTION;
+    }
+    std::vector<std::tuple<uint32_t, int64_t, pagenum_t>> kept;
+    for (auto &page : pages) {
+        uint32_t c = get_table_info(std::get<1>(page))->size_class;
+        if (room[c] == 0)
+            continue;
+        room[c]--;
+        kept.push_back(page);
+    }
+
+    // 같은 table의 이어진 entry를 WARM_LOAD_BATCH개까지 묶음
+    std::vector<size_t> batch_starts;
+    for (size_t i = 0; i < kept.size(); i++) {
+        if (batch_starts.empty() || i - batch_starts.back() == WARM_LOAD_BATCH ||
+            std::get<1>(kept[i]) != std::get<1>(kept[i - 1]))
+            batch_starts.push_back(i);
+    }
+    batch_starts.push_back(kept.size());
+
+    std::atomic<size_t> next_batch{0};
+    std::atomic<int64_t> num_loaded{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < WARM_LOAD_THREADS; i++) {
+        threads.emplace_back([&] {
+            pagenum_t page_nums[WARM_LOAD_BATCH];
+            size_t b;
+            while ((b = next_batch.fetch_add(1)) + 1 < batch_starts.size()) {
+                size_t first = batch_starts[b];
+                uint32_t num_pages = batch_starts[b + 1] - first;
+                int64_t table_id = std::get<1>(kept[first]);
+                for (uint32_t j = 0; j < num_pages; j++)
+                    page_nums[j] = std::get<2>(kept[first + j]);
+                // batch를 한 번에 읽기 시작하고, prefetch하지 못한 page는 get_buffer()가 읽음
+                prefetch_buffer(table_id, page_nums, num_pages);
+                for (uint32_t j = 0; j < num_pages; j++) {
+                    buf_descriptor_t *buf_desc = get_buffer(table_id, page_nums[j]);
+                    if (buf_desc == nullptr)
+                        continue;
+                    int usage_count = MAX_USAGE_COUNT - std::get<0>(kept[first + j]);
+                    int current = buf_desc->usage_count.load();
+                    while (current < usage_count &&
+                           !buf_desc->usage_count.compare_exchange_weak(current, usage_count))
+                        ;
+                    unpin_buffer(buf_desc);
+                    num_loaded++;
+                }
+            }
+        });
+    }
+    for (std::thread &thread : threads)
+        thread.join();
+    buf_log_info("Loaded " << num_loaded << " of " << pages.size() << " pages from " << pathname);
+    return num_loaded;
+}
+
+static void warm_dumper_main() {
+    std::unique_lock<std::mutex> lock(warm.latch);
+    while (warm.is_open) {
+        // 간격이 0으로 바뀌었으면 닫힐 때까지 기다림
+        if (warm.interval_ms == 0) {
+            warm.cond.wait(lock);
+            continue;
+        }
+        warm.cond.wait_for(lock, std::chrono::milliseconds(warm.interval_ms),
+                           [] { return !warm.is_open; });
+        if (!warm.is_open)
+            break;
+        std::string pathname = warm.pathname;
+        lock.unlock();
+        warm_dump(pathname.c_str());
+        lock.lock();
+    }
+}
+
+/**
+ * @brief Dump the resident pages to pathname periodically and when the
+ * buffer pool is closed.
+ *
+ * @param interval_ms The time between dumps, 0 to dump only at close
+ * @retval 0: successful
+ * @retval others: failed
+ *
+ * @details The periodic dumps keep the file recent after a crash. If dumping
+ * is already on, only its settings are changed.
+ */
+int warm_open(const char *pathname, uint32_t interval_ms) {
+    if (pathname == nullptr)
+        return 1;
+    std::lock_guard<std::mutex> guard(warm.latch);
+    warm.pathname = pathname;
+    warm.interval_ms = interval_ms;
+    warm.is_open = true;
+    if (interval_ms > 0 && !warm.dumper.joinable())
+        warm.dumper = std::thread(warm_dumper_main);
+    warm.cond.notify_all();
+    return 0;
+}
+
+/**
+ * @brief Stop the periodic dumps and write the last one.
+ *
+ * @details Called by close_buffer_pool() before any buffer is released. The
+ * table paths are forgotten, since the tables are closed with the pool.
+ */
+void warm_close() {
+    std::string pathname;
+    {
+        std::lock_guard<std::mutex> guard(warm.latch);
+        if (warm.is_open) {
+            warm.is_open = false;
+            pathname = warm.pathname;
+        }
+    }
+    if (!pathname.empty()) {
+        warm.cond.notify_all();
+        if (warm.dumper.joinable())
+            warm.dumper.join();
+        warm_dump(pathname.c_str());
+    }
+    std::lock_guard<std::mutex> guard(warm.tables_latch);
+    warm.table_paths.clear();
+}
@@ -0,0 +1,47 @@
+#ifndef DB_WARM_H_
+#define DB_WARM_H_
+
+#include "page.h"
+
+#include <cstdint>
+
+// dump file 맨 앞의 값 ("BUFWARM1")
+#define WARM_MAGIC (0x314d524157465542ULL)
+// warm_load()가 page를 읽는 thread 수
+#define WARM_LOAD_THREADS (4)
+// thread 하나가 prefetch_buffer()로 한 번에 읽기 시작하는 page 수의 상한
+#define WARM_LOAD_BATCH (64)
+// size class의 buffer 중 이만큼(1/n)은 비워 두고 읽음, 시작한 workload가 쓸 자리
+#define WARM_FREE_FRACTION (8)
+
+// entry 하나: 하위 56bit는 page_num, 상위 8bit는 dump할 때의 usage_count
+#define warm_entry(page_num, usage_count) \
+    (((uint64_t)(usage_count) << 56) | ((uint64_t)(page_num) & ((1ULL << 56) - 1)))
+#define warm_entry_page(entry) ((pagenum_t)((entry) & ((1ULL << 56) - 1)))
+#define warm_entry_usage(entry) ((uint32_t)((entry) >> 56))
+
+// dump file의 header, 뒤에 table마다 warm_table_t, 경로, entry들이 이어짐
+typedef struct warm_header_t {
+    uint64_t magic;
+    uint32_t num_tables;
+    uint32_t reserved;
+    uint64_t num_entries;
+} warm_header_t;
+
+// table 하나의 section header, 뒤에 path_length bytes의 경로(8 bytes 단위로 맞춤)와
+// page_num 순으로 정렬된 num_entries개의 entry가 이어짐
+typedef struct warm_table_t {
+    uint32_t path_length;
+    uint32_t page_size;
+    uint64_t num_entries;
+} warm_table_t;
+
+void warm_register_table(int64_t table_id, const char *pathname);
+
+int warm_dump(const char *pathname);
+int64_t warm_load(const char *pathname);
+
+int warm_open(const char *pathname, uint32_t interval_ms);
+void warm_close();
+
+#endif // DB_WARM_H_
@@ -0,0 +1,385 @@
+#include "zcache.h"
+#include "arena.h"
+#include "log.h"
+#include "metrics.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+// 압축기의 hash table 크기 (2의 거듭제곱의 지수)
+#define ZCACHE_HASH_BITS (12)
+// 이 길이 이상 같은 byte가 이어져야 match로 씀
+#define ZCACHE_MIN_MATCH (4)
+
+#define zcache_align(length) (((length) + 7) & ~(uint64_t)7)
+
+// ring에 그대로 기록되는 record header, 뒤에 압축된 data가 이어지고 8 bytes 단위로 맞춤
+typedef struct zcache_record_t {
+    uint64_t key;
+    // header, data, padding을 합한 크기
+    uint32_t size;
+    // 압축된 data의 크기, 0이면 ring 끝을 채운 빈 record
+    uint32_t length;
+    uint32_t page_size;
+    uint32_t reserved;
+} zcache_record_t;
+
+/*
+ * One shard is a ring log: records are appended at head and the oldest ones
+ * are dropped from tail to make room, so the cache holds the most recently
+ * evicted pages that fit into its budget. head and tail count bytes since
+ * the ring was opened, and their difference never exceeds capacity.
+ */
+typedef struct alignas(64) zcache_shard_t {
+    std::mutex latch;
+    char *ring;
+    uint64_t capacity;
+    uint64_t head;
+    uint64_t tail;
+    // key별 record의 위치 (head와 같은 누적 byte 수), 꺼내 간 page는 지움
+    std::unordered_map<uint64_t, uint64_t> index;
+    uint64_t page_bytes;
+    uint64_t compressed_bytes;
+} zcache_shard_t;
+
+typedef struct zcache_t {
+    std::atomic<bool> is_open;
+    arena_t arena;
+    size_t budget_bytes;
+    zcache_shard_t shards[ZCACHE_NUM_SHARDS];
+} zcache_t;
+
+static zcache_t zcache;
+
+// page_size bytes를 압축한 결과의 최대 크기
+static inline uint32_t compress_bound(uint32_t page_size) {
+    return page_size + page_size / 255 + 16;
+}
+
+static inline uint32_t load32(const char *p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline char *write_length(char *op, uint32_t length) {
+    for (; length >= 255; length -= 255)
+        *op++ = (char)255;
+    *op++ = (char)length;
+    return op;
+}
+
+/*
+ * LZ77 in the layout of an LZ4 block: every sequence is a token (literal
+ * length and match length - ZCACHE_MIN_MATCH, 4 bits each, 15 meaning more
+ * length bytes follow), the literals, and a 2 byte offset back to the match.
+ * The last sequence has literals only. Matches are found through a hash
+ * table of 4 byte prefixes, which keeps compressing a page at a few
+ * microseconds.
+ */
+static uint32_t compress_page(const char *src, uint32_t length, char *dest) {
+    uint16_t table[1 << ZCACHE_HASH_BITS] = {};
+    char *op = dest;
+    uint32_t ip = 0, anchor = 0;
+    // 마지막 몇 byte는 literal로 남김
+    uint32_t limit = length > 12 ? length - 12 : 0;
+
+    auto emit = [&op, src](uint32_t literal_start, uint32_t num_literals, uint32_t offset,
+                           uint32_t match_length) {
+        char *token = op++;
+        *token = (char)(std::min<uint32_t>(num_literals, 15) << 4);
+        if (num_literals >= 15)
+            op = write_length(op, num_literals - 15);
+        memcpy(op, src + literal_start, num_literals);
+        op += num_literals;
+        if (match_length == 0)
+            return;
+        *op++ = (char)(offset & 0xff);
+        *op++ = (char)(offset >> 8);
+        match_length -= ZCACHE_MIN_MATCH;
+        *token |= (char)std::min<uint32_t>(match_length, 15);
+        if (match_length >= 15)
+            op = write_length(op, match_length - 15);
+    };
+
+    while (ip < limit) {
+        uint32_t sequence = load32(src + ip);
+        uint32_t h = (sequence * 2654435761u) >> (32 - ZCACHE_HASH_BITS);
+        uint32_t candidate = table[h];
+        table[h] = (uint16_t)ip;
+        // page는 64KB 이하이므로 table의 위치는 항상 ip보다 앞이고 2 bytes offset에 들어감
+        if (candidate >= ip || load32(src + candidate) != sequence) {
+            // match가 없는 구간이 길어지면 건너뛰는 간격을 늘림
+            ip += 1 + ((ip - anchor) >> 6);
+            continue;
+        }
+        uint32_t match_length = ZCACHE_MIN_MATCH;
+        while (ip + match_length < length && src[candidate + match_length] == src[ip + match_length])
+            match_length++;
+        emit(anchor, ip - anchor, ip - candidate, match_length);
+        ip += match_length;
+        anchor = ip;
+    }
+    emit(anchor, length - anchor, 0, 0);
+    return op - dest;
+}
+
+static inline bool read_length(const char *src, uint32_t length, uint32_t *ip, uint32_t *value) {
+    uint8_t byte;
+    do {
+        if (*ip >= length)
+            return false;
+        byte = (uint8_t)src[(*ip)++];
+        *value += byte;
+    } while (byte == 255);
+    return true;
+}
+
+// page_size bytes로 풀리지 않는 data면 false
+static bool decompress_page(const char *src, uint32_t length, char *dest, uint32_t page_size) {
+    uint32_t ip = 0, op = 0;
+    while (ip < length) {
+        uint8_t token = (uint8_t)src[ip++];
+        uint32_t num_literals = token >> 4;
+        if (num_literals == 15 && !read_length(src, length, &ip, &num_literals))
+            return false;
+        if (num_literals > length - ip || num_literals > page_size - op)
+            return false;
+        memcpy(dest + op, src + ip, num_literals);
+        ip += num_literals;
+        op += num_literals;
+        // 마지막 sequence
+        if (ip == length)
+            break;
+
+        if (length - ip < 2)
+            return false;
+        uint32_t offset = (uint8_t)src[ip] | ((uint32_t)(uint8_t)src[ip + 1] << 8);
+        ip += 2;
+        uint32_t match_length = token & 15;
+        if (match_length == 15 && !read_length(src, length, &ip, &match_length))
+            return false;
+        match_length += ZCACHE_MIN_MATCH;
+        if (offset == 0 || offset > op || match_length > page_size - op)
+            return false;
+        // match가 자기 자신과 겹치면 (같은 byte의 반복) 한 byte씩 복사
+        if (offset >= match_length) {
+            memcpy(dest + op, dest + op - offset, match_length);
+            op += match_length;
+        } else {
+            for (uint32_t i = 0; i < match_length; i++, op++)
+                dest[op] = dest[op - offset];
+        }
+    }
+    return op == page_size;
+}
+
+/**
+ * @brief Open the compressed cache with a memory budget.
+ *
+ * @retval 0: successful
+ * @retval others: failed
+ *
+ * @details Clean pages evicted from the buffer pool are compressed into
+ * budget_bytes of memory, split into ZCACHE_NUM_SHARDS rings, and a miss
+ * takes its page from there before reading the file. The budget is the
+ * memory of the compressed pages; the per-page index is kept apart from it.
+ *
+ * Open the cache after init_buffer_pool(), or close and open it again to
+ * change the budget, while no other thread uses the buffer pool.
+ */
+int zcache_open(size_t budget_bytes) {
+    zcache_close();
+    uint64_t capacity = (budget_bytes / ZCACHE_NUM_SHARDS) & ~(uint64_t)7;
+    if (capacity < ZCACHE_MIN_SHARD_SIZE) {
+        buf_log_error("Error: compressed cache budget of " << budget_bytes << " bytes is too small");
+        return 1;
+    }
+    if (arena_alloc(&zcache.arena, capacity * ZCACHE_NUM_SHARDS) != 0) {
+        buf_log_error("Error: cannot allocate the compressed cache");
+        return 1;
+    }
+    for (int i = 0; i < ZCACHE_NUM_SHARDS; i++) {
+        zcache_shard_t *shard = &zcache.shards[i];
+        shard->ring = (char *)zcache.arena.addr + capacity * i;
+        shard->capacity = capacity;
+        shard->head = shard->tail = 0;
+        shard->index.clear();
+        shard->page_bytes = shard->compressed_bytes = 0;
+    }
+    zcache.budget_bytes = capacity * ZCACHE_NUM_SHARDS;
+    zcache.is_open = true;
+    return 0;
+}
+
+// 다른 thread가 buffer pool을 쓰지 않을 때 호출
+void zcache_close() {
+    if (!zcache.is_open.exchange(false))
+        return;
+    for (int i = 0; i < ZCACHE_NUM_SHARDS; i++) {
+        std::unordered_map<uint64_t, uint64_t>().swap(zcache.shards[i].index);
+        zcache.shards[i].ring = nullptr;
+    }
+    arena_free(&zcache.arena);
+    zcache.budget_bytes = 0;
+}
+
+bool zcache_is_open() {
+    return zcache.is_open.load(std::memory_order_relaxed);
+}
+
+static inline zcache_shard_t *shard_of(uint64_t key) {
+    // 같은 table의 이웃한 page들도 여러 shard로 퍼지도록 섞음
+    return &zcache.shards[((key * 0x9e3779b97f4a7c15ULL) >> 32) % ZCACHE_NUM_SHARDS];
+}
+
+// shard의 latch를 잡고 호출, index에서 key의 record를 지움
+static void erase_entry(zcache_shard_t *shard,
+                        std::unordered_map<uint64_t, uint64_t>::iterator entry) {
+    const zcache_record_t *record =
+        (const zcache_record_t *)(shard->ring + entry->second % shard->capacity);
+    shard->page_bytes -= record->page_size;
+    shard->compressed_bytes -= record->length;
+    shard->index.erase(entry);
+}
+
+// shard의 latch를 잡고 호출, tail의 가장 오래된 record를 ring에서 내보냄
+static void drop_oldest(zcache_shard_t *shard) {
+    uint64_t offset = shard->tail % shard->capacity;
+    uint64_t remaining = shard->capacity - offset;
+    // header도 들어가지 않는 ring 끝의 자투리
+    if (remaining < sizeof(zcache_record_t)) {
+        shard->tail += remaining;
+        return;
+    }
+    const zcache_record_t *record = (const zcache_record_t *)(shard->ring + offset);
+    if (record->length != 0) {
+        auto entry = shard->index.find(record->key);
+        // 이후에 같은 page를 다시 담았다면 index는 새 record를 가리킴
+        if (entry != shard->index.end() && entry->second == shard->tail)
+            erase_entry(shard, entry);
+    }
+    shard->tail += record->size;
+}
+
+// shard의 latch를 잡고 호출, ring에 size bytes가 들어갈 자리를 만듦
+static inline void make_room(zcache_shard_t *shard, uint64_t size) {
+    while (shard->head + size - shard->tail > shard->capacity)
+        drop_oldest(shard);
+}
+
+/**
+ * @brief Compress a page for zcache_insert().
+ *
+ * @return Whether the page is worth caching, i.e. whether compression saves
+ * at least 1/ZCACHE_MIN_SAVING_FRACTION of it.
+ *
+ * @details Done before taking any latch of the buffer pool, since this is
+ * the expensive part of caching a page.
+ */
+bool zcache_compress(const void *page, uint32_t page_size, zcache_image_t *image) {
+    if (image->data.size() < compress_bound(page_size))
+        image->data.resize(compress_bound(page_size));
+    uint32_t length = compress_page((const char *)page, page_size, image->data.data());
+    image->page_size = page_size;
+    image->length = length <= page_size - page_size / ZCACHE_MIN_SAVING_FRACTION ? length : 0;
+    return image->length != 0;
+}
+
+/**
+ * @brief Cache the compressed image of an evicted page.
+ *
+ * @param image The page as compressed by zcache_compress(), or nullptr to
+ * only drop the key's older image
+ *
+ * @details The caller holds the hashtable partition latch of the page while
+ * it is evicted, so images of the same page are inserted in eviction order
+ * and the cached image is always the page's latest content.
+ */
+void zcache_insert(uint64_t key, const zcache_image_t *image) {
+    if (!zcache_is_open())
+        return;
+    zcache_shard_t *shard = shard_of(key);
+    std::lock_guard<std::mutex> guard(shard->latch);
+
+    auto entry = shard->index.find(key);
+    if (entry != shard->index.end())
+        erase_entry(shard, entry);
+    if (image == nullptr || image->length == 0)
+        return;
+
+    uint64_t size = zcache_align(sizeof(zcache_record_t) + image->length);
+    uint64_t remaining = shard->capacity - shard->head % shard->capacity;
+    if (remaining < size) {
+        // record는 ring 끝에서 나누지 않으므로 남은 자리를 빈 record로 채움
+        make_room(shard, remaining);
+        if (remaining >= sizeof(zcache_record_t)) {
+            zcache_record_t *pad = (zcache_record_t *)(shard->ring + shard->head % shard->capacity);
+            *pad = {0, (uint32_t)remaining, 0, 0, 0};
+        }
+        shard->head += remaining;
+    }
+    make_room(shard, size);
+
+    zcache_record_t *record = (zcache_record_t *)(shard->ring + shard->head % shard->capacity);
+    *record = {key, (uint32_t)size, image->length, image->page_size, 0};
+    memcpy(record + 1, image->data.data(), image->length);
+    shard->index[key] = shard->head;
+    shard->head += size;
+    shard->page_bytes += image->page_size;
+    shard->compressed_bytes += image->length;
+}
+
+/**
+ * @brief Take the cached image of a page.
+ *
+ * @return Whether the page was cached, in which case it is decompressed into
+ * page and dropped from the cache.
+ *
+ * @details Called on a miss of the buffer pool while the page is mapped to a
+ * buffer, so the page cannot be evicted and cached again meanwhile. Taking
+ * the image out keeps a page in only one of the two tiers.
+ */
+bool zcache_take(uint64_t key, void *page, uint32_t page_size) {
+    if (!zcache_is_open())
+        return false;
+    zcache_shard_t *shard = shard_of(key);
+    bool is_hit = false;
+    {
+        std::lock_guard<std::mutex> guard(shard->latch);
+        auto entry = shard->index.find(key);
+        if (entry != shard->index.end()) {
+            const zcache_record_t *record =
+                (const zcache_record_t *)(shard->ring + entry->second % shard->capacity);
+            is_hit = record->page_size == page_size &&
+                decompress_page((const char *)(record + 1), record->length, (char *)page, page_size);
+            if (!is_hit)
+                buf_log_error("Error: corrupt compressed page of key " << key);
+            erase_entry(shard, entry);
+        }
+    }
+    metric_add(is_hit ? METRIC_ZCACHE_HIT : METRIC_ZCACHE_MISS);
+    return is_hit;
+}
+
+void zcache_invalidate(uint64_t key) {
+    zcache_insert(key, nullptr);
+}
+
+void zcache_get_stat(zcache_stat_t *stat) {
+    *stat = {};
+    if (!zcache_is_open())
+        return;
+    stat->budget_bytes = zcache.budget_bytes;
+    for (int i = 0; i < ZCACHE_NUM_SHARDS; i++) {
+        zcache_shard_t *shard = &zcache.shards[i];
+        std::lock_guard<std::mutex> guard(shard->latch);
+        stat->used_bytes += shard->head - shard->tail;
+        stat->num_pages += shard->index.size();
+        stat->page_bytes += shard->page_bytes;
+        stat->compressed_bytes += shard->compressed_bytes;
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef DB_ZCACHE_H_
+#define DB_ZCACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// compressed cache를 나누는 shard 수, shard마다 latch와 ring을 따로 둔다
+#define ZCACHE_NUM_SHARDS (16)
+// shard 하나의 ring 크기의 하한, budget이 이보다 작으면 열지 않음
+#define ZCACHE_MIN_SHARD_SIZE (64 * 1024)
+// 압축해도 page 크기의 1/8 이상 줄지 않는 page는 담지 않음
+#define ZCACHE_MIN_SAVING_FRACTION (8)
+
+// zcache_compress()로 압축한 page 하나, 같은 image를 여러 page에 다시 씀
+typedef struct zcache_image_t {
+    std::vector<char> data;
+    // 압축된 크기, 0이면 담을 가치가 없는 page
+    uint32_t length;
+    uint32_t page_size;
+} zcache_image_t;
+
+// zcache_get_stat()이 채우는 지금의 상태
+typedef struct zcache_stat_t {
+    uint64_t budget_bytes;
+    // ring에서 record가 차지한 byte 수, 꺼내 간 page의 자리도 덮어쓸 때까지 포함
+    uint64_t used_bytes;
+    uint64_t num_pages;
+    // 담겨 있는 page들의 원래 크기와 압축된 크기의 합
+    uint64_t page_bytes;
+    uint64_t compressed_bytes;
+} zcache_stat_t;
+
+int zcache_open(size_t budget_bytes);
+void zcache_close();
+bool zcache_is_open();
+
+bool zcache_compress(const void *page, uint32_t page_size, zcache_image_t *image);
+void zcache_insert(uint64_t key, const zcache_image_t *image);
+bool zcache_take(uint64_t key, void *page, uint32_t page_size);
+void zcache_invalidate(uint64_t key);
+
+void zcache_get_stat(zcache_stat_t *stat);
+
+#endif // DB_ZCACHE_H_